@@ -14,6 +14,8 @@
 #include "fsm/Dfsm.h"
 #include "fsm/Fsm.h"
 #include "fsm/FsmNode.h"
+#include "fsm/FsmSnapshot.h"
+#include "fsm/JsonModelReader.h"
 #include "fsm/IOTrace.h"
 #include "fsm/FsmPrintVisitor.h"
 #include "fsm/FsmSimVisitor.h"
@@ -21,6 +23,7 @@
 #include "trees/IOListContainer.h"
 #include "trees/OutputTree.h"
 #include "trees/TestSuite.h"
+#include "trees/TestSuiteTrie.h"
 #include "json/json.h"
 
 
@@ -34,7 +37,8 @@ using namespace Json;
 typedef enum {
     FSM_CSV,
     FSM_JSON,
-    FSM_BASIC
+    FSM_BASIC,
+    FSM_SNAPSHOT
 } model_type_t;
 
 typedef enum {
@@ -83,7 +87,10 @@ static void parseParameters(int argc, char* argv[]) {
     sutmodelFileName = string(argv[1]);
     testSuiteFileName = string(argv[2]);
     
-    if ( strstr(sutmodelFileName.c_str(),".csv")  ) {
+    if ( FsmSnapshot::isSnapshotFile(sutmodelFileName) ) {
+        sutModelType = FSM_SNAPSHOT;
+    }
+    else if ( strstr(sutmodelFileName.c_str(),".csv")  ) {
         sutModelType = FSM_CSV;
     }
     else {
@@ -107,15 +114,12 @@ static void readSUTModel() {
             
         case FSM_JSON:
         {
-            Reader jReader;
-            Value root;
-            stringstream document;
+            JsonModelReader jReader;
+            JsonFsmModel model;
             ifstream inputFile(sutmodelFileName);
-            document << inputFile.rdbuf();
-            inputFile.close();
             
-            if ( jReader.parse(document.str(),root) ) {
-                dfsmSut = make_shared<Dfsm>(root);
+            if ( jReader.read(inputFile,model) ) {
+                dfsmSut = make_shared<Dfsm>(model);
             }
             else {
                 cerr << "Could not parse JSON model - exit." << endl;
@@ -124,6 +128,22 @@ static void readSUTModel() {
         }
             break;
             
+        case FSM_SNAPSHOT:
+        {
+            shared_ptr<FsmSnapshot> snapshot = FsmSnapshot::open(sutmodelFileName);
+            if ( snapshot == nullptr ) {
+                cerr << "Could not load snapshot model - exit." << endl;
+                exit(1);
+            }
+            dfsmSut = snapshot->createDfsm(fsmSutName);
+            if ( dfsmSut == nullptr ) {
+                cerr << "Snapshot model is not deterministic - exit." << endl;
+                exit(1);
+            }
+            pl = dfsmSut->getPresentationLayer();
+        }
+            break;
+            
         default:
             cerr << "Could not parse this model type - exit." << endl;
             exit(1);
@@ -164,6 +184,30 @@ static void getNextIO(char** p, char** x, char** y) {
     
 }
 
+/**
+ *  Check whether the SUT model passes a test case, given by the
+ *  numbers of its inputs and outputs.
+ */
+static void checkIOTrace(const vector<int>& inVec,
+                         const vector<int>& outVec) {
+    
+    InputTrace inTrace(inVec,pl);
+    OutputTrace outTrace(outVec,pl);
+    
+    IOTrace io(inTrace,outTrace);
+    
+    
+    cout << "Check IO Trace " << io << ": ";
+    
+    if ( dfsmSut->pass(io) ) {
+        printf(" PASS\n");
+    }
+    else {
+        printf(" FAIL\n");
+    }
+    
+}
+
 static void executeTestCase(const char* tcId, char* line) {
     
     char* p = line;
@@ -210,20 +254,7 @@ static void executeTestCase(const char* tcId, char* line) {
     }
     
     
-    InputTrace inTrace(inVec,pl);
-    OutputTrace outTrace(outVec,pl);
-    
-    IOTrace io(inTrace,outTrace);
-    
-    
-    cout << "Check IO Trace " << io << ": ";
-    
-    if ( dfsmSut->pass(io) ) {
-        printf(" PASS\n");
-    }
-    else {
-        printf(" FAIL\n");
-    }
+    checkIOTrace(inVec,outVec);
     
 }
 
@@ -258,12 +289,91 @@ static void executeTestSuite(const char* fname) {
     
 }
 
+/**
+ *  Execute a test suite stored in the prefix tree format of
+ *  TestSuiteTrie. The test cases are read depth-first, and every
+ *  input and output name is looked up only once in the
+ *  presentation layer.
+ */
+static void executeTrieTestSuite(const char* fname) {
+    
+    TestSuiteTrieReader reader;
+    if ( not reader.open(fname) ) {
+        cerr << reader.getError() << " - exit." << endl;
+        exit(1);
+    }
+    
+    vector<int> inNum(reader.getNumInNames());
+    for ( size_t x = 0; x < inNum.size(); x++ ) {
+        inNum[x] = pl->in2Num(reader.getInName((int)x));
+    }
+    vector<int> outNum(reader.getNumOutNames());
+    for ( size_t y = 0; y < outNum.size(); y++ ) {
+        outNum[y] = pl->out2Num(reader.getOutName((int)y));
+    }
+    
+    // Text format of a test case, only needed for messages
+    auto toLine = [&reader](const vector<pair<int,int>>& tc) {
+        string theLine;
+        for ( size_t i = 0; i < tc.size(); i++ ) {
+            if ( i > 0 ) theLine += ".";
+            theLine += "(" + reader.getInName(tc[i].first) + "/"
+            + reader.getOutName(tc[i].second) + ")";
+        }
+        return theLine;
+    };
+    
+    int tcNum = 0;
+    vector<pair<int,int>> tc;
+    while ( reader.next(tc) ) {
+        
+        printf("TC-%d: ",++tcNum);
+        
+        vector<int> inVec;
+        vector<int> outVec;
+        bool fail = false;
+        for ( const auto& io : tc ) {
+            int xInt = inNum[io.first];
+            int yInt = outNum[io.second];
+            if ( xInt < 0 ) {
+                cerr << "Unknown input " << reader.getInName(io.first)
+                << " i test case " << toLine(tc) << endl;
+            }
+            else if ( yInt < 0 ) {
+                cout << "FAIL: SUT does not produce expected output "
+                << reader.getOutName(io.second)
+                << " occurring in test case " << toLine(tc) << endl;
+                fail = true;
+                break;
+            }
+            inVec.push_back(xInt);
+            outVec.push_back(yInt);
+        }
+        
+        if ( not fail ) {
+            checkIOTrace(inVec,outVec);
+        }
+        
+    }
+    
+    if ( not reader.getError().empty() ) {
+        cerr << reader.getError() << " - exit." << endl;
+        exit(1);
+    }
+    
+}
+
 int main(int argc, char* argv[])
 {
     
     parseParameters(argc,argv);
     readSUTModel();
-    executeTestSuite(testSuiteFileName.c_str());
+    if ( TestSuiteTrie::isTrieFile(testSuiteFileName) ) {
+        executeTrieTestSuite(testSuiteFileName.c_str());
+    }
+    else {
+        executeTestSuite(testSuiteFileName.c_str());
+    }
     
     exit(0);
     
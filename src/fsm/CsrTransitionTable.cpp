@@ -0,0 +1,201 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#include <algorithm>
+
+#include "fsm/CsrTransitionTable.h"
+#include "fsm/FsmNode.h"
+#include "fsm/FsmTransition.h"
+#include "fsm/FsmLabel.h"
+#include "logging/easylogging++.h"
+
+using namespace std;
+
+namespace {
+
+    /** Transition entry used while sorting the transitions of a single state */
+    struct CsrEntry {
+        int input;
+        int output;
+        int target;
+    };
+
+}
+
+CsrTransitionTable::CsrTransitionTable(const vector<shared_ptr<FsmNode>>& nodes,
+                                       const int maxInput,
+                                       const int maxOutput)
+: maxInput(maxInput), maxOutput(maxOutput), stateNodes(nodes),
+generation(FsmNode::getStructureGeneration())
+{
+    const int numStates = static_cast<int>(stateNodes.size());
+
+    // Node ids normally coincide with the node positions, so that
+    // no lookup map is needed. Otherwise, fall back to a hash map.
+    // Positions of states missing in an FSM file hold null pointers;
+    // these states have no transitions.
+    for (int s = 0; s < numStates; ++s)
+    {
+        if (stateNodes[s] != nullptr and stateNodes[s]->getId() != s)
+        {
+            for (int n = 0; n < numStates; ++n)
+            {
+                if (stateNodes[n] != nullptr)
+                {
+                    nodeIndex[stateNodes[n].get()] = n;
+                }
+            }
+            break;
+        }
+    }
+
+    size_t numTransitions = 0;
+    for (const auto& n : stateNodes)
+    {
+        if (n != nullptr)
+        {
+            numTransitions += n->getTransitions().size();
+        }
+    }
+
+    offsets.reserve(numStates + 1);
+    inputs.reserve(numTransitions);
+    outputs.reserve(numTransitions);
+    targets.reserve(numTransitions);
+
+    const int rowWidth = maxInput + 2;
+    inputOffsets.resize(static_cast<size_t>(numStates) * rowWidth);
+
+    vector<CsrEntry> entries;
+    for (int s = 0; s < numStates; ++s)
+    {
+        offsets.push_back(static_cast<int>(targets.size()));
+
+        entries.clear();
+        static const vector<shared_ptr<FsmTransition>> noTransitions;
+        const auto& transitions = (stateNodes[s] != nullptr) ?
+            stateNodes[s]->getTransitions() : noTransitions;
+        for (const auto& tr : transitions)
+        {
+            int tgt = getIndex(tr->getTarget().get());
+            if (tgt < 0)
+            {
+                LOG(FATAL) << "Transition target of state " << stateNodes[s]->getName()
+                << " is not a state of this FSM.";
+            }
+            entries.push_back({tr->getLabel()->getInput(), tr->getLabel()->getOutput(), tgt});
+        }
+
+        stable_sort(entries.begin(), entries.end(),
+                    [](const CsrEntry& a, const CsrEntry& b) {
+                        return a.input < b.input;
+                    });
+
+        const int first = static_cast<int>(targets.size());
+        for (const auto& e : entries)
+        {
+            inputs.push_back(e.input);
+            outputs.push_back(e.output);
+            targets.push_back(e.target);
+        }
+
+        // Transitions with input values outside 0..maxInput
+        // (e.g. EPSILON) are stored, but not covered by the input index
+        int t = first;
+        const int last = static_cast<int>(targets.size());
+        for (int x = 0; x <= maxInput + 1; ++x)
+        {
+            while (t < last and inputs[t] < x)
+            {
+                ++t;
+            }
+            inputOffsets[static_cast<size_t>(s) * rowWidth + x] = t;
+        }
+    }
+    offsets.push_back(static_cast<int>(targets.size()));
+}
+
+int CsrTransitionTable::begin(const int s, const int x) const
+{
+    if (x < 0 or x > maxInput)
+    {
+        return offsets[s];
+    }
+    return inputOffsets[static_cast<size_t>(s) * (maxInput + 2) + x];
+}
+
+int CsrTransitionTable::end(const int s, const int x) const
+{
+    if (x < 0 or x > maxInput)
+    {
+        return offsets[s];
+    }
+    return inputOffsets[static_cast<size_t>(s) * (maxInput + 2) + x + 1];
+}
+
+int CsrTransitionTable::getIndex(const FsmNode* node) const
+{
+    if (nodeIndex.empty())
+    {
+        int id = node->getId();
+        if (id >= 0 and id < size() and stateNodes[id].get() == node)
+        {
+            return id;
+        }
+        return -1;
+    }
+    auto it = nodeIndex.find(node);
+    return (it == nodeIndex.end()) ? -1 : it->second;
+}
+
+bool CsrTransitionTable::isObservable() const
+{
+    for (int s = 0; s < size(); ++s)
+    {
+        // Transitions with the same input are adjacent, only
+        // their outputs need to be compared
+        for (int t = begin(s); t < end(s); ++t)
+        {
+            for (int other = t + 1; other < end(s) and inputs[other] == inputs[t]; ++other)
+            {
+                if (outputs[other] == outputs[t])
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool CsrTransitionTable::isDeterministic() const
+{
+    for (int s = 0; s < size(); ++s)
+    {
+        for (int t = begin(s) + 1; t < end(s); ++t)
+        {
+            if (inputs[t] == inputs[t - 1])
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool CsrTransitionTable::isCompletelyDefined() const
+{
+    for (int s = 0; s < size(); ++s)
+    {
+        for (int x = 0; x <= maxInput; ++x)
+        {
+            if (begin(s, x) == end(s, x))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
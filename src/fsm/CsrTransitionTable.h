@@ -0,0 +1,142 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#ifndef FSM_FSM_CSRTRANSITIONTABLE_H_
+#define FSM_FSM_CSRTRANSITIONTABLE_H_
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class FsmNode;
+
+/**
+ Immutable compressed-sparse-row (CSR) view of the transition relation
+ of an FSM. State s is the node at position s in the node vector the
+ table has been created from. The transitions of s are stored at positions
+ begin(s)..end(s)-1 of the packed input/output/target arrays, sorted by
+ input. Transitions sharing the same input keep the order in which
+ they are stored in the FsmNode, so that algorithms iterating over
+ inputs 0..maxInput visit the transitions in the same order as
+ when working on the FsmNode graph.
+
+ The table is a snapshot: it has to be created again after the
+ underlying FsmNode graph has been changed, which is detected by
+ comparing getGeneration() with FsmNode::getStructureGeneration().
+ */
+class CsrTransitionTable
+{
+private:
+    /**
+     * Maximal value of the input alphabet in range 0..maxInput
+     */
+    int maxInput;
+
+    /**
+     * Maximal value of the output alphabet in range 0..maxOutput
+     */
+    int maxOutput;
+
+    /**
+     * The FSM states, stateNodes[s] is the node of state index s
+     */
+    std::vector<std::shared_ptr<FsmNode>> stateNodes;
+
+    /**
+     * Map FSM nodes to their state index. Only used if the node ids
+     * do not coincide with the node positions.
+     */
+    std::unordered_map<const FsmNode*, int> nodeIndex;
+
+    /**
+     * Transitions of state s are stored at offsets[s]..offsets[s+1]-1
+     */
+    std::vector<int> offsets;
+
+    /**
+     * Transitions of state s with input x in range 0..maxInput are stored
+     * at inputOffsets[s*(maxInput+2)+x]..inputOffsets[s*(maxInput+2)+x+1]-1
+     */
+    std::vector<int> inputOffsets;
+
+    /** Packed transition inputs */
+    std::vector<int> inputs;
+
+    /** Packed transition outputs */
+    std::vector<int> outputs;
+
+    /** Packed transition target state indices */
+    std::vector<int> targets;
+
+    /** FsmNode structure generation the table has been created at */
+    unsigned long generation;
+
+public:
+    /**
+     * Create the CSR table of an FSM
+     * @param nodes The FSM states; every transition target must be
+     *              contained in this vector
+     * @param maxInput Maximal value of the input alphabet
+     * @param maxOutput Maximal value of the output alphabet
+     */
+    CsrTransitionTable(const std::vector<std::shared_ptr<FsmNode>>& nodes,
+                       const int maxInput,
+                       const int maxOutput);
+
+    /** Return the number of states */
+    int size() const { return static_cast<int>(stateNodes.size()); }
+
+    /** Return the number of transitions */
+    int getNumTransitions() const { return static_cast<int>(targets.size()); }
+
+    int getMaxInput() const { return maxInput; }
+    int getMaxOutput() const { return maxOutput; }
+    unsigned long getGeneration() const { return generation; }
+
+    /** First transition of state s */
+    int begin(const int s) const { return offsets[s]; }
+
+    /** One past the last transition of state s */
+    int end(const int s) const { return offsets[s + 1]; }
+
+    /**
+     * First transition of state s labelled with input x.
+     * For x outside 0..maxInput, begin(s,x) == end(s,x).
+     */
+    int begin(const int s, const int x) const;
+
+    /** One past the last transition of state s labelled with input x */
+    int end(const int s, const int x) const;
+
+    int getInput(const int t) const { return inputs[t]; }
+    int getOutput(const int t) const { return outputs[t]; }
+    int getTarget(const int t) const { return targets[t]; }
+
+    /** Return the FSM node associated with state index s */
+    const std::shared_ptr<FsmNode>& getNode(const int s) const { return stateNodes[s]; }
+
+    /**
+     * Return the state index of an FSM node, or -1, if the node
+     * is not a state of this table.
+     */
+    int getIndex(const FsmNode* node) const;
+
+    /**
+     * Return true if and only if no state has two transitions with the same label
+     */
+    bool isObservable() const;
+
+    /**
+     * Return true if and only if no state has two transitions with the same input
+     */
+    bool isDeterministic() const;
+
+    /**
+     * Return true if and only if every state has at least one
+     * transition for every input in range 0..maxInput
+     */
+    bool isCompletelyDefined() const;
+};
+#endif //FSM_FSM_CSRTRANSITIONTABLE_H_
@@ -3,14 +3,23 @@
  *
  * Licensed under the EUPL V.1.1
  */
+#include <algorithm>
+#include <numeric>
+
 #include "fsm/Dfsm.h"
+#include "fsm/CsrTransitionTable.h"
+#include "fsm/DfsmExecutionTable.h"
+#include "fsm/DistinguishingTraceMatrix.h"
 #include "fsm/FsmNode.h"
 #include "fsm/FsmTransition.h"
 #include "fsm/PkTable.h"
 #include "fsm/DFSMTableRow.h"
 #include "fsm/InputTrace.h"
+#include "fsm/JsonModelReader.h"
 #include "fsm/IOTrace.h"
+#include "sets/ParallelFor.h"
 #include "trees/Tree.h"
+#include "trees/InputTrie.h"
 
 using namespace std;
 
@@ -388,25 +397,6 @@ void Dfsm::createDfsmTransitionGraph(const string& fname) {
     
 }
 
-void Dfsm::initDistTraces() {
-    
-    distTraces.clear();
-    
-    for ( int n = 0; n < size(); n++ ) {
-        // Create empty vector of for row n, to be extended in
-        // the inner loop
-        vector< vector< shared_ptr< vector<int> > > > thisRow;
-        for ( int m = 0; m < size(); m++ ) {
-            // Create empty vector of pointers to traces
-            vector< shared_ptr< vector<int> > > v;
-            thisRow.push_back(v);
-        }
-        // Add thisRow to distTraces
-        distTraces.push_back(thisRow);
-    }
-    
-}
-
 Dfsm::Dfsm(const std::string & fname,
            const std::string & fsmName) : Fsm(nullptr), dfsmTable(nullptr) {
     name = fsmName;
@@ -425,6 +415,7 @@ Dfsm::Dfsm(const std::string & fname,
 void Dfsm::createAtRandom()
 {
     srand(getRandomSeed());
+    resetExecutionTable();
     
     for (unsigned int i = 0; i < nodes.size(); ++ i)
     {
@@ -533,237 +524,45 @@ Dfsm::Dfsm(const Fsm & fsm)
 
 
 Dfsm::Dfsm(const Json::Value& fsmExport) :
-Fsm(), dfsmTable(nullptr)
+Dfsm(JsonFsmModel(fsmExport))
+{
+}
+
+
+
+Dfsm::Dfsm(const Json::Value& fsmExport,
+           const std::shared_ptr<FsmPresentationLayer>& pl) :
+Dfsm(JsonFsmModel(fsmExport), pl)
 {
+}
+
 
-    if (!fsmExport.isObject()) {
+
+Dfsm::Dfsm(const JsonFsmModel& fsmExport) :
+Fsm(), dfsmTable(nullptr)
+{
+    
+    if (!fsmExport.isObject) {
         cerr << endl << "File format is JSON but NOT FSM-lib file structure.";
         return;
     }
     
-    bool valid = true;
-    Json::Value inputs = fsmExport["inputs"];
-    Json::Value outputs = fsmExport["outputs"];
-    Json::Value states = fsmExport["states"];
-    Json::Value transitions = fsmExport["transitions"];
-    Json::Value requirements = fsmExport["requirements"];
-    
-    map< string,shared_ptr<FsmNode> > name2node;
-    
-    // check JSON value for a valid FSM export
-    if (inputs.isNull() || (!inputs.isArray())) {
-        valid = false;
-        cout << endl << "Unable to extract expected array of FSM inputs from JSON export file structure.";
-    }
-    if (outputs.isNull() || (!outputs.isArray())) {
-        valid = false;
-        cout << endl << "Unable to extract expected array of FSM outputs from JSON export file structure.";
-    }
-    if (states.isNull() || (!states.isArray())) {
-        valid = false;
-        cout << endl << "Unable to extract expected array of FSM states from JSON export file structure.";
-    }
-    if (transitions.isNull() || (!transitions.isArray())) {
-        valid = false;
-        cout << endl << "Unable to extract expected array of FSM transitions from JSON export file structure.";
-    }
-    if (requirements.isNull() || (!requirements.isArray())) {
-        valid = false;
-        cout << endl << "Unable to extract expected array of requirements from JSON export file structure.";
-    }
-    if (!valid) {
+    if (!isValidJsonModel(fsmExport)) {
         return;
     }
     
-    // iterate over all inputs
-    vector<string> in2String;
-    for (const auto &input : inputs) {
-        in2String.push_back(input.asString());
-    }
-    
-    // iterate over all outputs
-    vector<string> out2String;
-    int theNopNo;
-    bool haveNop = false;
-    for (unsigned int index = 0; index < outputs.size(); ++index ) {
-        string outStr(outputs[index].asString());
-        if ( outStr == "_nop" ) {
-            haveNop = true;
-            theNopNo = index;
-        }
-        out2String.push_back(outStr);
-    }
-    
-    // Add a NOP output for the case where the FSM is incomplete
-    if ( not haveNop ) {
-        out2String.push_back("_nop");
-        theNopNo = (int)out2String.size() - 1;
-    }
-    
-    // iterate over all states, insert initial state at index 0
-    // of the state2String vector.
-    vector<string> state2String;
-    for (const auto &state : states) {
-        if (state["initial"].asBool()) {
-            state2String.push_back(state["name"].asString());
-            break;
-        }
-    }
-    for (const auto &state : states) {
-        if (state["initial"].asBool()) {
-            continue; // Initial state has already been inserted
-        }
-        state2String.push_back(state["name"].asString());
-    }
-    
-    // Create the presentation layer
-    presentationLayer =
-    make_shared<FsmPresentationLayer>(in2String,out2String,state2String);
-    
-    // Define basic attributes
-    name = "FSM";
-    currentParsedNode = nullptr;
-    maxInput = (int)in2String.size() - 1;
-    maxOutput = (int)out2String.size() - 1;
-    maxState = (int)state2String.size() - 1;
-    initStateIdx = 0;
-    minimal = Maybe;
-    
-    
-    // Create all FSM states
-    for ( size_t s = 0; s < state2String.size(); s++ ) {
-        shared_ptr<FsmNode> theNode =
-        make_shared<FsmNode>((int)s,state2String[s],presentationLayer);
-        nodes.push_back(theNode);
-        name2node[state2String[s]] = theNode;
-    }
-    
-    
-    // Create all transitions
-    for (const auto &transition : transitions) {
-        // Handle source and target nodes
-        string srcName(transition["source"].asString());
-        string tgtName(transition["target"].asString());
-        
-        shared_ptr<FsmNode> srcNode = name2node[srcName];
-        shared_ptr<FsmNode> tgtNode = name2node[tgtName];
-        
-        if ( srcNode == nullptr ) {
-            cerr << "Cannot associated valid FSM node with source node name"
-            << srcName << endl;
-            exit(1);
-        }
-        
-        if ( tgtNode == nullptr ) {
-            cerr << "Cannot associated valid FSM node with target node name"
-            << tgtName << endl;
-            exit(1);
-        }
-        
-        // Get the output
-        string yString(transition["output"].asString());
-        
-        // Trim
-        yString.erase(0,yString.find_first_not_of(" \n\r\t\""));
-        yString.erase(yString.find_last_not_of(" \n\r\t\"")+1);
-        
-        int y = presentationLayer->out2Num(yString);
-        
-        if ( y < 0 ) {
-            cerr << "Unidentified output symbol `"
-            <<  yString
-            << "' in transition "
-            << srcName << " --> " << tgtName
-            << endl;
-            exit(1);
-        }
-        
-        // For each input, create a separate transition
-        // and add it to the source node
-        Json::Value inputlist = transition["input"];
-        for (const auto &inidx : inputlist) {
-            
-            string xString(inidx.asString());
-            // Trim
-            xString.erase(0,xString.find_first_not_of(" \n\r\t\""));
-            xString.erase(xString.find_last_not_of(" \n\r\t\"")+1);
-            int x = presentationLayer->in2Num(xString);
-            if ( x < 0 ) {
-                cerr << "Unidentified input symbol `"
-                <<  xString
-                << "' in transition "
-                << srcName << " --> " << tgtName
-                << endl;
-                exit(1);
-            }
-            shared_ptr<FsmLabel> theLabel =
-            make_shared<FsmLabel>(x,y,presentationLayer);
-            shared_ptr<FsmTransition> tr =
-            make_shared<FsmTransition>(srcNode,tgtNode,theLabel);
-            
-            
-            // Record the requirements satisfied by the transition
-            Json::Value satisfies = transition["requirements"];
-            for (const auto &satisfie : satisfies) {
-                tr->addSatisfies(satisfie.asString());
-            }
-            
-            srcNode->addTransition(tr);
-        }
-        
-    }
-    
-    // Add requirements to nodes
-    for (const auto &state : states) {
-        string nodeName(state["name"].asString());
-        
-        for (const auto &n : nodes ) {
-            if ( n->getName() == nodeName ) {
-                Json::Value satisfies = state["requirements"];
-                for (const auto &satisfie : satisfies) {
-                    n->addSatisfies(satisfie.asString());
-                }
-            }
-        }
-        
-    }
-    
-    
-    // Force DFSM to be completely defined:
-    // For each node and each input event x that has not been used
-    // in any outgoing transition of this node,
-    // create a self-loop transition with label x/NOP
-    for ( auto n : nodes ) {
-        
-        vector<bool> inputs;
-        for ( int x = 0; x <= maxInput; x++ ) {
-            inputs.push_back(false);
-        }
-        for (const auto &tr : n->getTransitions() ) {
-            inputs[tr->getLabel()->getInput()] = true;
-        }
-        for ( int x = 0; x <= maxInput; x++ ) {
-            if ( not inputs[x] ) {
-                shared_ptr<FsmLabel> theLabel =
-                make_shared<FsmLabel>(x,theNopNo,presentationLayer);
-                shared_ptr<FsmTransition> tr =
-                make_shared<FsmTransition>(n,n,theLabel);
-                n->addTransition(tr);
-            }
-        }
-        
-    }
+    createDfsmFromJsonModel(fsmExport, nullptr);
     
 }
 
 
 
-Dfsm::Dfsm(const Json::Value& fsmExport,
+Dfsm::Dfsm(const JsonFsmModel& fsmExport,
            const std::shared_ptr<FsmPresentationLayer>& pl) :
 Fsm(), dfsmTable(nullptr)
 {
-
-    if (!fsmExport.isObject()) {
+    
+    if (!fsmExport.isObject) {
         cerr << endl << "File format is JSON but NOT FSM-lib file structure.";
         return;
     }
@@ -773,82 +572,125 @@ Fsm(), dfsmTable(nullptr)
         return;
     }
     
-    bool valid = true;
-    Json::Value inputs = fsmExport["inputs"];
-    Json::Value outputs = fsmExport["outputs"];
-    Json::Value states = fsmExport["states"];
-    Json::Value transitions = fsmExport["transitions"];
-    Json::Value requirements = fsmExport["requirements"];
+    if (!isValidJsonModel(fsmExport)) {
+        return;
+    }
     
-    map< string,shared_ptr<FsmNode> > name2node;
+    createDfsmFromJsonModel(fsmExport, pl);
+    
+}
+
+
+
+bool Dfsm::isValidJsonModel(const JsonFsmModel& fsmExport) {
+    
+    bool valid = true;
     
     // check JSON value for a valid FSM export
-    if (inputs.isNull() || (!inputs.isArray())) {
+    if (!fsmExport.haveInputs) {
         valid = false;
         cout << endl << "Unable to extract expected array of FSM inputs from JSON export file structure.";
     }
-    if (outputs.isNull() || (!outputs.isArray())) {
+    if (!fsmExport.haveOutputs) {
         valid = false;
         cout << endl << "Unable to extract expected array of FSM outputs from JSON export file structure.";
     }
-    if (states.isNull() || (!states.isArray())) {
+    if (!fsmExport.haveStates) {
         valid = false;
         cout << endl << "Unable to extract expected array of FSM states from JSON export file structure.";
     }
-    if (transitions.isNull() || (!transitions.isArray())) {
+    if (!fsmExport.haveTransitions) {
         valid = false;
         cout << endl << "Unable to extract expected array of FSM transitions from JSON export file structure.";
     }
-    if (requirements.isNull() || (!requirements.isArray())) {
+    if (!fsmExport.haveRequirements) {
         valid = false;
         cout << endl << "Unable to extract expected array of requirements from JSON export file structure.";
     }
-    if (!valid) {
-        return;
-    }
     
+    return valid;
+}
+
+
+
+void Dfsm::createDfsmFromJsonModel(const JsonFsmModel& fsmExport,
+                                   const std::shared_ptr<FsmPresentationLayer>& pl) {
     
+    const vector<string>& strings = fsmExport.strings;
+    const vector<int>& pool = fsmExport.pool;
     
-    // iterate over all inputs; add all inputs not already contained
-    // in pl to in2String.
-    vector<string> in2String(pl->getIn2String());
-    for (const auto &input : inputs) {
-        string theInput(input.asString());
-        if ( pl->in2Num(theInput) < 0 ) {
-            in2String.push_back(theInput);
-        }
-    }
+    vector<string> in2String;
+    vector<string> out2String;
+    int theNopNo = -1;
     
-    // iterate over all outputs
-    vector<string> out2String(pl->getOut2String());
-    for (const auto &output : outputs) {
-        string theOutput(output.asString());
-        if ( pl->out2Num(theOutput) < 0 ) {
-            out2String.push_back(theOutput);
+    if ( pl == nullptr ) {
+        
+        // iterate over all inputs
+        for (int input : fsmExport.inputs) {
+            in2String.push_back(strings[input]);
+        }
+        
+        // iterate over all outputs
+        bool haveNop = false;
+        for (size_t index = 0; index < fsmExport.outputs.size(); ++index ) {
+            const string& outStr = strings[fsmExport.outputs[index]];
+            if ( outStr == "_nop" ) {
+                haveNop = true;
+                theNopNo = (int)index;
+            }
+            out2String.push_back(outStr);
+        }
+        
+        // Add a NOP output for the case where the FSM is incomplete
+        if ( not haveNop ) {
+            out2String.push_back("_nop");
+            theNopNo = (int)out2String.size() - 1;
         }
     }
-    // Check whether the _nop output is already contained in pl,
-    // otherwise add it to out2String
-    int theNopNo = pl->out2Num("_nop");
-    if ( theNopNo < 0 ) {
-        out2String.push_back("_nop");
+    else {
+        
+        // iterate over all inputs; add all inputs not already contained
+        // in pl to in2String.
+        in2String = pl->getIn2String();
+        for (int input : fsmExport.inputs) {
+            if ( pl->in2Num(strings[input]) < 0 ) {
+                in2String.push_back(strings[input]);
+            }
+        }
+        
+        // iterate over all outputs
+        out2String = pl->getOut2String();
+        for (int output : fsmExport.outputs) {
+            if ( pl->out2Num(strings[output]) < 0 ) {
+                out2String.push_back(strings[output]);
+            }
+        }
+        // Check whether the _nop output is already contained in pl,
+        // otherwise add it to out2String
+        theNopNo = pl->out2Num("_nop");
+        if ( theNopNo < 0 ) {
+            out2String.push_back("_nop");
+        }
     }
     
-    
     // iterate over all states, insert initial state at index 0
     // of the state2String vector.
-    vector<string> state2String;
-    for (const auto &state : states) {
-        if (state["initial"].asBool()) {
-            state2String.push_back(state["name"].asString());
+    vector<int> stateNames;
+    for (const auto &state : fsmExport.states) {
+        if (state.initial) {
+            stateNames.push_back(state.name);
             break;
         }
     }
-    for (const auto &state : states) {
-        if (state["initial"].asBool()) {
+    for (const auto &state : fsmExport.states) {
+        if (state.initial) {
             continue; // Initial state has already been inserted
         }
-        state2String.push_back(state["name"].asString());
+        stateNames.push_back(state.name);
+    }
+    vector<string> state2String;
+    for (int stateName : stateNames) {
+        state2String.push_back(strings[stateName]);
     }
     
     // Create the presentation layer
@@ -865,23 +707,36 @@ Fsm(), dfsmTable(nullptr)
     minimal = Maybe;
     
     
-    // Create all FSM states
+    // Create all FSM states. The node names are looked up by their
+    // index in the string table; a later state replaces an earlier
+    // state of the same name.
+    vector<shared_ptr<FsmNode>> name2node(strings.size());
+    vector<vector<shared_ptr<FsmNode>>> nodesOfName(strings.size());
     for ( size_t s = 0; s < state2String.size(); s++ ) {
         shared_ptr<FsmNode> theNode =
         make_shared<FsmNode>((int)s,state2String[s],presentationLayer);
         nodes.push_back(theNode);
-        name2node[state2String[s]] = theNode;
+        name2node[stateNames[s]] = theNode;
+        nodesOfName[stateNames[s]].push_back(theNode);
     }
     
+    // Numbers of the output and input strings, looked up on first use
+    vector<int> outNum(strings.size(), -2);
+    vector<int> inNum(strings.size(), -2);
+    auto trimmed = [](string s) {
+        s.erase(0,s.find_first_not_of(" \n\r\t\""));
+        s.erase(s.find_last_not_of(" \n\r\t\"")+1);
+        return s;
+    };
     
     // Create all transitions
-    for (const auto &transition : transitions) {
+    for (const auto &transition : fsmExport.transitions) {
         // Handle source and target nodes
-        string srcName(transition["source"].asString());
-        string tgtName(transition["target"].asString());
+        const string& srcName = strings[transition.source];
+        const string& tgtName = strings[transition.target];
         
-        shared_ptr<FsmNode> srcNode = name2node[srcName];
-        shared_ptr<FsmNode> tgtNode = name2node[tgtName];
+        shared_ptr<FsmNode> srcNode = name2node[transition.source];
+        shared_ptr<FsmNode> tgtNode = name2node[transition.target];
         
         if ( srcNode == nullptr ) {
             cerr << "Cannot associated valid FSM node with source node name"
@@ -896,17 +751,14 @@ Fsm(), dfsmTable(nullptr)
         }
         
         // Get the output
-        string yString(transition["output"].asString());
-        
-        // Trim
-        yString.erase(0,yString.find_first_not_of(" \n\r\t\""));
-        yString.erase(yString.find_last_not_of(" \n\r\t\"")+1);
-        
-        int y = presentationLayer->out2Num(yString);
+        int& y = outNum[transition.output];
+        if ( y == -2 ) {
+            y = presentationLayer->out2Num(trimmed(strings[transition.output]));
+        }
         
         if ( y < 0 ) {
             cerr << "Unidentified output symbol `"
-            <<  yString
+            <<  trimmed(strings[transition.output])
             << "' in transition "
             << srcName << " --> " << tgtName
             << endl;
@@ -915,17 +767,15 @@ Fsm(), dfsmTable(nullptr)
         
         // For each input, create a separate transition
         // and add it to the source node
-        Json::Value inputlist = transition["input"];
-        for (const auto &inidx : inputlist) {
+        for (int i = transition.inBegin; i < transition.inEnd; ++i) {
             
-            string xString(inidx.asString());
-            // Trim
-            xString.erase(0,xString.find_first_not_of(" \n\r\t\""));
-            xString.erase(xString.find_last_not_of(" \n\r\t\"")+1);
-            int x = presentationLayer->in2Num(xString);
+            int& x = inNum[pool[i]];
+            if ( x == -2 ) {
+                x = presentationLayer->in2Num(trimmed(strings[pool[i]]));
+            }
             if ( x < 0 ) {
                 cerr << "Unidentified input symbol `"
-                <<  xString
+                <<  trimmed(strings[pool[i]])
                 << "' in transition "
                 << srcName << " --> " << tgtName
                 << endl;
@@ -938,9 +788,8 @@ Fsm(), dfsmTable(nullptr)
             
             
             // Record the requirements satisfied by the transition
-            Json::Value satisfies = transition["requirements"];
-            for (const auto &satisfie : satisfies) {
-                tr->addSatisfies(satisfie.asString());
+            for (int r = transition.reqBegin; r < transition.reqEnd; ++r) {
+                tr->addSatisfies(strings[pool[r]]);
             }
             
             srcNode->addTransition(tr);
@@ -949,18 +798,12 @@ Fsm(), dfsmTable(nullptr)
     }
     
     // Add requirements to nodes
-    for (const auto &state : states) {
-        string nodeName(state["name"].asString());
-        
-        for (const auto &n : nodes ) {
-            if ( n->getName() == nodeName ) {
-                Json::Value satisfies = state["requirements"];
-                for (const auto &satisfie : satisfies) {
-                    n->addSatisfies(satisfie.asString());
-                }
+    for (const auto &state : fsmExport.states) {
+        for (const auto &n : nodesOfName[state.name] ) {
+            for (int r = state.reqBegin; r < state.reqEnd; ++r) {
+                n->addSatisfies(strings[pool[r]]);
             }
         }
-        
     }
     
     
@@ -1018,11 +861,19 @@ void Dfsm::calcPkTables() {
 }
 
 
-Dfsm Dfsm::minimise()
+Dfsm Dfsm::minimise(const bool useHopcroft)
 {
     
     vector<shared_ptr<FsmNode>> uNodes;
-    removeUnreachableNodes(uNodes);
+    if (removeUnreachableNodes(uNodes))
+    {
+        resetExecutionTable();
+    }
+    
+    if (useHopcroft)
+    {
+        return minimiseHopcroft();
+    }
     
     calcPkTables();
     shared_ptr<PkTable> pMin = pktblLst[pktblLst.size()-1];
@@ -1032,6 +883,246 @@ Dfsm Dfsm::minimise()
     return dfsm;
 }
 
+Dfsm Dfsm::minimiseHopcroft()
+{
+    const DfsmExecutionTable& tbl = getExecutionTable();
+    const int n = tbl.size();
+    const int numInputs = maxInput + 1;
+    
+    // Inverse transition relation: the predecessors of state s
+    // under input x are stored at preds[predOffsets[x*(n+1)+s] ..
+    // predOffsets[x*(n+1)+s+1]-1]
+    vector<int> predOffsets(static_cast<size_t>(numInputs) * (n + 1) + 1, 0);
+    for (int x = 0; x < numInputs; ++x)
+    {
+        for (int s = 0; s < n; ++s)
+        {
+            int tgt = tbl.getNext(s, x);
+            if (tgt >= 0)
+            {
+                ++predOffsets[static_cast<size_t>(x) * (n + 1) + tgt + 1];
+            }
+        }
+    }
+    for (size_t i = 1; i < predOffsets.size(); ++i)
+    {
+        predOffsets[i] += predOffsets[i - 1];
+    }
+    vector<int> preds(predOffsets.back());
+    vector<int> fill(predOffsets.begin(), predOffsets.end() - 1);
+    for (int x = 0; x < numInputs; ++x)
+    {
+        for (int s = 0; s < n; ++s)
+        {
+            int tgt = tbl.getNext(s, x);
+            if (tgt >= 0)
+            {
+                preds[fill[static_cast<size_t>(x) * (n + 1) + tgt]++] = s;
+            }
+        }
+    }
+    
+    // The partition: block b consists of the states
+    // elems[blockBegin[b]..blockEnd[b]-1], and loc[s] is the position
+    // of state s in elems.
+    vector<int> elems(n);
+    vector<int> loc(n);
+    vector<int> blockOf(n);
+    vector<int> blockBegin;
+    vector<int> blockEnd;
+    
+    // Initial partition: states are equivalent with respect to
+    // sequences of length 1, iff they produce the same outputs
+    // for every input (-1 marks undefined transitions)
+    for (int s = 0; s < n; ++s)
+    {
+        elems[s] = s;
+    }
+    auto outputsLess = [&tbl, numInputs](const int s1, const int s2) {
+        for (int x = 0; x < numInputs; ++x)
+        {
+            if (tbl.getOutput(s1, x) != tbl.getOutput(s2, x))
+            {
+                return tbl.getOutput(s1, x) < tbl.getOutput(s2, x);
+            }
+        }
+        return false;
+    };
+    stable_sort(elems.begin(), elems.end(), outputsLess);
+    for (int i = 0; i < n; ++i)
+    {
+        if (i == 0 or outputsLess(elems[i - 1], elems[i]))
+        {
+            if (i > 0)
+            {
+                blockEnd.push_back(i);
+            }
+            blockBegin.push_back(i);
+        }
+        loc[elems[i]] = i;
+        blockOf[elems[i]] = static_cast<int>(blockBegin.size()) - 1;
+    }
+    if (n > 0)
+    {
+        blockEnd.push_back(n);
+    }
+    
+    // Splitters (block, input) still to be processed
+    vector<pair<int, int>> waiting;
+    vector<bool> isWaiting;
+    for (int b = 0; b < static_cast<int>(blockBegin.size()); ++b)
+    {
+        for (int x = 0; x < numInputs; ++x)
+        {
+            waiting.push_back(make_pair(b, x));
+            isWaiting.push_back(true);
+        }
+    }
+    
+    // Number of marked states of each block; marked states are
+    // moved to the front of their block
+    vector<int> marked(blockBegin.size(), 0);
+    vector<int> touched;
+    vector<int> splitter;
+    
+    while (not waiting.empty())
+    {
+        int b = waiting.back().first;
+        int x = waiting.back().second;
+        waiting.pop_back();
+        isWaiting[static_cast<size_t>(b) * numInputs + x] = false;
+        
+        // Copy the splitter block, since marking may reorder its states
+        splitter.assign(elems.begin() + blockBegin[b], elems.begin() + blockEnd[b]);
+        
+        for (int s : splitter)
+        {
+            for (int k = predOffsets[static_cast<size_t>(x) * (n + 1) + s];
+                 k < predOffsets[static_cast<size_t>(x) * (n + 1) + s + 1]; ++k)
+            {
+                int p = preds[k];
+                int c = blockOf[p];
+                int pos = blockBegin[c] + marked[c];
+                if (loc[p] < pos)
+                {
+                    // p is already marked
+                    continue;
+                }
+                if (marked[c] == 0)
+                {
+                    touched.push_back(c);
+                }
+                int q = elems[pos];
+                swap(elems[pos], elems[loc[p]]);
+                loc[q] = loc[p];
+                loc[p] = pos;
+                ++marked[c];
+            }
+        }
+        
+        for (int c : touched)
+        {
+            int m = marked[c];
+            marked[c] = 0;
+            if (m == blockEnd[c] - blockBegin[c])
+            {
+                continue;
+            }
+            
+            // Split block c: the marked states form the new block d
+            int d = static_cast<int>(blockBegin.size());
+            blockBegin.push_back(blockBegin[c]);
+            blockEnd.push_back(blockBegin[c] + m);
+            blockBegin[c] += m;
+            marked.push_back(0);
+            for (int i = blockBegin[d]; i < blockEnd[d]; ++i)
+            {
+                blockOf[elems[i]] = d;
+            }
+            
+            for (int y = 0; y < numInputs; ++y)
+            {
+                isWaiting.push_back(false);
+                if (isWaiting[static_cast<size_t>(c) * numInputs + y])
+                {
+                    waiting.push_back(make_pair(d, y));
+                    isWaiting.back() = true;
+                }
+                else if (blockEnd[d] - blockBegin[d] < blockEnd[c] - blockBegin[c])
+                {
+                    waiting.push_back(make_pair(d, y));
+                    isWaiting.back() = true;
+                }
+                else
+                {
+                    waiting.push_back(make_pair(c, y));
+                    isWaiting[static_cast<size_t>(c) * numInputs + y] = true;
+                }
+            }
+        }
+        touched.clear();
+    }
+    
+    // Number the classes by their smallest member, so that the class
+    // of state 0 becomes the initial state of the minimised DFSM
+    const int numClasses = static_cast<int>(blockBegin.size());
+    vector<int> block2Class(numClasses, -1);
+    vector<int> classRep;
+    for (int s = 0; s < n; ++s)
+    {
+        if (block2Class[blockOf[s]] < 0)
+        {
+            block2Class[blockOf[s]] = static_cast<int>(classRep.size());
+            classRep.push_back(s);
+        }
+    }
+    
+    vector<string> minState2String(numClasses, "{");
+    vector<bool> firstMember(numClasses, true);
+    for (int s = 0; s < n; ++s)
+    {
+        int c = block2Class[blockOf[s]];
+        if (not firstMember[c])
+        {
+            minState2String[c] += ",";
+        }
+        firstMember[c] = false;
+        minState2String[c] += presentationLayer->getStateId(s, "");
+    }
+    for (auto& str : minState2String)
+    {
+        str += "}";
+    }
+    
+    shared_ptr<FsmPresentationLayer> minPl =
+    make_shared<FsmPresentationLayer>(presentationLayer->getIn2String(),
+                                      presentationLayer->getOut2String(),
+                                      minState2String);
+    
+    vector<shared_ptr<FsmNode>> nodeLst;
+    for (int c = 0; c < numClasses; ++c)
+    {
+        nodeLst.push_back(make_shared<FsmNode>(c, "", minPl));
+    }
+    
+    for (int c = 0; c < numClasses; ++c)
+    {
+        for (int x = 0; x <= maxInput; ++x)
+        {
+            int tgt = tbl.getNext(classRep[c], x);
+            if (tgt < 0)
+            {
+                continue;
+            }
+            shared_ptr<FsmNode> tgtNode = nodeLst[block2Class[blockOf[tgt]]];
+            shared_ptr<FsmLabel> lbl = make_shared<FsmLabel>(x, tbl.getOutput(classRep[c], x), minPl);
+            nodeLst[c]->addTransition(make_shared<FsmTransition>(nodeLst[c], tgtNode, lbl));
+        }
+    }
+    
+    return Dfsm("", maxInput, maxOutput, nodeLst, minPl);
+}
+
 void Dfsm::printTables() const
 {
     ofstream file("tables.tex");
@@ -1136,77 +1227,174 @@ IOListContainer Dfsm::getCharacterisationSet()
     return tcl;
 }
 
+const DfsmExecutionTable& Dfsm::getExecutionTable()
+{
+    shared_ptr<CsrTransitionTable> csr = getCsrTransitionTable();
+    if (execTable == nullptr or execTableSource != csr)
+    {
+        execTable = make_shared<DfsmExecutionTable>(*csr, initStateIdx);
+        execTableSource = csr;
+    }
+    return *execTable;
+}
+
+void Dfsm::resetExecutionTable()
+{
+    resetCsrTransitionTable();
+    execTable = nullptr;
+    execTableSource = nullptr;
+}
+
 IOTrace Dfsm::applyDet(const InputTrace & i)
 {
-    OutputTrace o = OutputTrace(presentationLayer);
-    
-    shared_ptr<FsmNode> currentNode = nodes.at(initStateIdx);
+    vector<int> inputs = i.get();
+    vector<int> outputs(inputs.size());
     
     // Apply input trace to FSM, as far as possible
-    for ( int input : i.get() ) {
-        if ( currentNode == nullptr ) break;
-        currentNode = currentNode->apply(input, o);
-    }
-    
-    // Handle the case where the very first input is not accpeted
-    // by the incomplete DFSM, or even the initial node does not exist:
-    // we return an empty IOTrace
-    if (currentNode == nullptr && o.get().empty())
-    {
-        return IOTrace(InputTrace(presentationLayer),
-                       OutputTrace(presentationLayer));
-    }
+    size_t len = getExecutionTable().apply(inputs.data(), inputs.size(), outputs.data());
     
     // Handle the case where only a prefix of the input trace
     // has been accepted by the incomplete DFSM: we return
     // an IOTrace whose input consist of this prefix, together
-    // with the associated outputs already contained in o.
-    if (currentNode == nullptr)
+    // with the associated outputs. If not even the first input
+    // is accepted, the IOTrace is empty.
+    if (len < inputs.size())
     {
-        
-        // Constant iterator to start of input trace.
-        auto ifirst = i.cbegin();
-        // Iterator pointing BEHIND the last input applied
-        // @note The number of inputs processed so far equals o.size()
-        auto ilast = ifirst + o.get().size();
-        
-        // Constant iterator to start of output trace.
-        auto ofirst = o.cbegin();
-        // Iterator pointing BEHIND last obtained output.
-        auto olast = ofirst + o.get().size();
-        
-        return IOTrace(InputTrace(vector<int>(ifirst, ilast), presentationLayer),
-                       OutputTrace(vector<int>(ofirst, olast), presentationLayer));
-        
+        inputs.resize(len);
+        outputs.resize(len);
     }
     
-    // The full input trace has been processed by the DFSM.
-    // The associated outputs are contained in o.
-    return IOTrace(InputTrace(i.get(), presentationLayer),
-                   OutputTrace(o.get(), presentationLayer));
+    return IOTrace(InputTrace(inputs, presentationLayer),
+                   OutputTrace(outputs, presentationLayer));
     
 }
 
 bool Dfsm::pass(const IOTrace & io)
 {
-    IOTrace myIO = applyDet(io.getInputTrace());
-    return myIO.getOutputTrace() == io.getOutputTrace();
+    vector<int> inputs = io.getInputTrace().get();
+    vector<int> outputs = io.getOutputTrace().get();
+    return getExecutionTable().pass(inputs.data(), inputs.size(),
+                                    outputs.data(), outputs.size());
+}
+
+size_t Dfsm::pass(const vector<IOTrace>& ios, vector<bool>& verdicts)
+{
+    const DfsmExecutionTable& tbl = getExecutionTable();
+    size_t numPassed = 0;
+    verdicts.assign(ios.size(), false);
+    
+    for (size_t k = 0; k < ios.size(); ++k)
+    {
+        vector<int> inputs = ios[k].getInputTrace().get();
+        vector<int> outputs = ios[k].getOutputTrace().get();
+        if (tbl.pass(inputs.data(), inputs.size(), outputs.data(), outputs.size()))
+        {
+            verdicts[k] = true;
+            ++numPassed;
+        }
+    }
+    return numPassed;
 }
 
 
 
-IOListContainer Dfsm::wMethod(const unsigned int numAddStates) {
+bool Dfsm::isEquivalent(const Dfsm& other, shared_ptr<IOTrace>& failTrace) const
+{
+    failTrace = nullptr;
+    
+    DfsmExecutionTable mine(*getCsrTransitionTable(), initStateIdx);
+    DfsmExecutionTable theirs(*other.getCsrTransitionTable(), other.initStateIdx);
+    const int n1 = mine.size();
+    const int numInputs = max(maxInput, other.maxInput) + 1;
+    
+    // Union-find forest over the states of both DFSMs, where the
+    // states of other are shifted by n1
+    vector<int> parent(n1 + theirs.size());
+    iota(parent.begin(), parent.end(), 0);
+    auto find = [&parent](int s) {
+        while (parent[s] != s)
+        {
+            parent[s] = parent[parent[s]];
+            s = parent[s];
+        }
+        return s;
+    };
+    
+    // Pairs of states to be checked in BFS order, with the index of
+    // their predecessor pair and the label x/y leading to them
+    vector<pair<int, int>> pairs;
+    vector<int> pred;
+    vector<pair<int, int>> predLabel;
+    size_t head = 0;
+    
+    auto unite = [&](const int s1, const int s2, const int p, const int x, const int y)
+    {
+        int r1 = find(s1);
+        int r2 = find(n1 + s2);
+        if (r1 != r2)
+        {
+            parent[r2] = r1;
+            pairs.push_back(make_pair(s1, s2));
+            pred.push_back(p);
+            predLabel.push_back(make_pair(x, y));
+        }
+    };
+    
+    unite(mine.getInitState(), theirs.getInitState(), -1, 0, 0);
+    
+    while (head < pairs.size())
+    {
+        const int p = static_cast<int>(head++);
+        const int s1 = pairs[p].first;
+        const int s2 = pairs[p].second;
+        
+        for (int x = 0; x < numInputs; ++x)
+        {
+            const int y1 = mine.getOutput(s1, x);
+            const int y2 = theirs.getOutput(s2, x);
+            
+            if (y1 != y2)
+            {
+                // The trace reaching pair p, extended by x and the
+                // output of the DFSM where x is defined, is contained
+                // in the language of exactly one DFSM
+                vector<int> inputs(1, x);
+                vector<int> outputs(1, (y1 >= 0) ? y1 : y2);
+                for (int q = p; pred[q] >= 0; q = pred[q])
+                {
+                    inputs.push_back(predLabel[q].first);
+                    outputs.push_back(predLabel[q].second);
+                }
+                reverse(inputs.begin(), inputs.end());
+                reverse(outputs.begin(), outputs.end());
+                failTrace = make_shared<IOTrace>(InputTrace(inputs, presentationLayer),
+                                                 OutputTrace(outputs, presentationLayer));
+                return false;
+            }
+            
+            if (y1 >= 0)
+            {
+                unite(mine.getNext(s1, x), theirs.getNext(s2, x), p, x, y1);
+            }
+        }
+    }
+    return true;
+}
+
+IOListContainer Dfsm::wMethod(const unsigned int numAddStates,
+                              const unsigned int numThreads) {
     
     Dfsm dfsmMin = minimise();
-    return dfsmMin.wMethodOnMinimisedDfsm(numAddStates);
+    return dfsmMin.wMethodOnMinimisedDfsm(numAddStates, numThreads);
     
 }
 
 
-IOListContainer Dfsm::wMethodOnMinimisedDfsm(const unsigned int numAddStates)
+IOListContainer Dfsm::wMethodOnMinimisedDfsm(const unsigned int numAddStates,
+                                             const unsigned int numThreads)
 {
     
-    shared_ptr<Tree> iTree = getTransitionCover();
+    InputTrie iTree = getTransitionCoverTrie();
     
     if (numAddStates > 0)
     {
@@ -1214,45 +1402,47 @@ IOListContainer Dfsm::wMethodOnMinimisedDfsm(const unsigned int numAddStates)
                                                     1,
                                                     (int)numAddStates,
                                                     presentationLayer);
-        iTree->add(inputEnum);
+        iTree.add(inputEnum, numThreads);
     }
     
     IOListContainer w = getCharacterisationSet();
-    iTree->add(w);
-    return iTree->getIOLists();
+    iTree.add(w, numThreads);
+    return iTree.getIOLists();
 }
 
-IOListContainer Dfsm::wpMethod(const unsigned int numAddStates)
+IOListContainer Dfsm::wpMethod(const unsigned int numAddStates,
+                               const unsigned int numThreads)
 {
     Dfsm dfsmMin = minimise();
-    return dfsmMin.wpMethodOnMinimisedDfsm(numAddStates);
+    return dfsmMin.wpMethodOnMinimisedDfsm(numAddStates, numThreads);
 }
 
-IOListContainer Dfsm::wpMethodOnMinimisedDfsm(const unsigned int numAddStates)
+IOListContainer Dfsm::wpMethodOnMinimisedDfsm(const unsigned int numAddStates,
+                                              const unsigned int numThreads)
 {
-    shared_ptr<Tree> scov = getStateCover();
+    InputTrie scov = getStateCoverTrie();
 
-    shared_ptr<Tree> tcov = getTransitionCover();
+    InputTrie tcov = getTransitionCoverTrie();
 
-    tcov->remove(scov);
-    const shared_ptr<Tree> &r = tcov;
+    tcov.remove(scov);
+    InputTrie& r = tcov;
 
     IOListContainer w = getCharacterisationSet();
 
     calcStateIdentificationSetsFast();
 
-    shared_ptr<Tree> Wp1 = scov;
+    InputTrie& Wp1 = scov;
     if (numAddStates > 0)
     {
         IOListContainer inputEnum = IOListContainer(maxInput, 1,
                                                     (int)numAddStates,
                                                     presentationLayer);
 
-        Wp1->add(inputEnum);
+        Wp1.add(inputEnum, numThreads);
     }
-    Wp1->add(w);
+    Wp1.add(w, numThreads);
 
-    shared_ptr<Tree> Wp2 = r;
+    InputTrie& Wp2 = r;
     if (numAddStates > 0)
     {
         IOListContainer inputEnum = IOListContainer(maxInput,
@@ -1260,26 +1450,27 @@ IOListContainer Dfsm::wpMethodOnMinimisedDfsm(const unsigned int numAddStates)
                                                     (int)numAddStates,
                                                     presentationLayer);
 
-        Wp2->add(inputEnum);
+        Wp2.add(inputEnum, numThreads);
     }
     appendStateIdentificationSets(Wp2);
 
-    Wp1->unionTree(Wp2);
-    return Wp1->getIOLists();
+    Wp1.unionTree(Wp2);
+    return Wp1.getIOLists();
 }
 
-IOListContainer Dfsm::hsiMethod(const unsigned int numAddStates)
+IOListContainer Dfsm::hsiMethod(const unsigned int numAddStates,
+                                const unsigned int numThreads)
 {
     Fsm fMin = minimiseObservableFSM();
-    return fMin.hsiMethod(numAddStates);
+    return fMin.hsiMethod(numAddStates, numThreads);
 }
 
 IOListContainer Dfsm::tMethod()
 {
     
-    shared_ptr<Tree> iTree = getTransitionCover();
+    InputTrie iTree = getTransitionCoverTrie();
     
-    return iTree->getIOLists();
+    return iTree.getIOLists();
     
 }
 
@@ -1323,6 +1514,10 @@ InputTrace Dfsm::calcDistinguishingTrace(
         const shared_ptr<InputTrace> iBeta,
         const shared_ptr<Tree> tree)
 {
+    if ( pktblLst.empty() ) {
+        calcPkTables();
+    }
+    
     shared_ptr<FsmNode> s0 = getInitialState();
     shared_ptr<FsmNode> s1 = *s0->after(*iAlpha).begin();
     shared_ptr<FsmNode> s2 = *s0->after(*iBeta).begin();
@@ -1344,6 +1539,9 @@ InputTrace Dfsm::calcDistinguishingTrace(
 vector<int> Dfsm::calcDistinguishingTrace(shared_ptr<SegmentedTrace> alpha,
                                                shared_ptr<SegmentedTrace> beta, const shared_ptr<TreeNode> treeNode) {
     
+    if ( pktblLst.empty() ) {
+        calcPkTables();
+    }
     
     shared_ptr<FsmNode> s0 = getInitialState();
     shared_ptr<FsmNode> s1 = alpha->getTgtNode();
@@ -1451,21 +1649,129 @@ InputTrace Dfsm::calcDistinguishingTraceAfterTree(
     return InputTrace(presentationLayer);
 }
 
-IOListContainer Dfsm::hMethodOnMinimisedDfsm(const unsigned int numAddStates) {
+vector<int> Dfsm::calcHDistinguishingTrace(const DfsmExecutionTable& tbl,
+                                           const CsrTransitionTable& csr,
+                                           const int s1,
+                                           const int s2,
+                                           const vector<int>& u1,
+                                           const vector<int>& u2,
+                                           const InputTrie& iTree) const
+{
+    auto after = [&tbl](int s, const vector<int>& trc) {
+        for ( auto it = trc.cbegin(); it != trc.cend() && s >= 0; ++it ) {
+            s = tbl.getNext(s, *it);
+        }
+        return s;
+    };
     
-    // Our initial state
-    shared_ptr<FsmNode> s0 = getInitialState();
+    /* Same verdict as FsmNode::distinguished() for deterministic FSMs:
+     the output trees differ as soon as the outputs differ, or one of
+     the states has no transition for the next input */
+    auto distinguished = [&tbl](int si, int sj, const vector<int>& trc) {
+        for ( int x : trc ) {
+            int yi = tbl.getOutput(si, x);
+            int yj = tbl.getOutput(sj, x);
+            if ( yi != yj ) return true;
+            if ( yi < 0 ) return false;
+            si = tbl.getNext(si, x);
+            sj = tbl.getNext(sj, x);
+        }
+        return false;
+    };
+    
+    /* Prefix relation tree of the sub-tries after u1 and u2,
+     see Tree::getPrefixRelationTree() */
+    InputTrie t1 = iTree.getSubTree(u1);
+    InputTrie t2 = iTree.getSubTree(u2);
+    IOListContainer iolc1 = t1.getIOLists();
+    IOListContainer iolc2 = t2.getIOLists();
+    shared_ptr<vector<vector<int>>> aPrefixes = iolc1.getIOLists();
+    shared_ptr<vector<vector<int>>> bPrefixes = iolc2.getIOLists();
+    
+    InputTrie r(maxInput, presentationLayer);
+    const InputTrie* tree = &r;
+    if ( aPrefixes->at(0).empty() && bPrefixes->at(0).empty() ) {
+        // Empty prefix relation tree
+    }
+    else if ( aPrefixes->at(0).empty() ) {
+        tree = &t2;
+    }
+    else if ( bPrefixes->at(0).empty() ) {
+        tree = &t1;
+    }
+    else {
+        for ( const auto& aPrefix : *aPrefixes ) {
+            for ( const auto& bPrefix : *bPrefixes ) {
+                size_t len = min(aPrefix.size(), bPrefix.size());
+                if ( equal(aPrefix.cbegin(), aPrefix.cbegin() + len, bPrefix.cbegin()) ) {
+                    r.addToRoot(aPrefix);
+                    r.addToRoot(bPrefix);
+                }
+            }
+        }
+    }
+    
+    /* Breadth-first search for a distinguishing trace in the tree,
+     see calcDistinguishingTraceInTree() */
+    vector<uint32_t> queue;
+    for ( uint32_t c = tree->getFirstChild(tree->getRoot()); c != InputTrie::NIL; c = tree->getNextSibling(c) ) {
+        queue.push_back(c);
+    }
+    for ( size_t head = 0; head < queue.size(); ++head ) {
+        uint32_t n = queue[head];
+        vector<int> path = tree->getPath(n);
+        if ( distinguished(s1, s2, path) ) {
+            return path;
+        }
+        for ( uint32_t c = tree->getFirstChild(n); c != InputTrie::NIL; c = tree->getNextSibling(c) ) {
+            queue.push_back(c);
+        }
+    }
+    
+    /* Extend a leaf of the tree by a distinguishing trace,
+     see calcDistinguishingTraceAfterTree() */
+    for ( uint32_t leaf : tree->getLeaves() ) {
+        vector<int> path = tree->getPath(leaf);
+        int si = after(s1, path);
+        int sj = after(s2, path);
+        if ( si == sj ) continue;
+        
+        InputTrace gamma = csr.getNode(si)->calcDistinguishingTrace(csr.getNode(sj),
+                                                                    pktblLst,
+                                                                    maxInput);
+        path.insert(path.end(), gamma.cbegin(), gamma.cend());
+        return path;
+    }
+    
+    return csr.getNode(s1)->calcDistinguishingTrace(csr.getNode(s2),
+                                                    pktblLst,
+                                                    maxInput).get();
+}
+
+IOListContainer Dfsm::hMethodOnMinimisedDfsm(const unsigned int numAddStates,
+                                             const unsigned int numThreads) {
     
     // We need a valid set of DFSM table and Pk-Tables for this method
-    if ( dfsmTable == nullptr ) {
+    if ( dfsmTable == nullptr || pktblLst.empty() ) {
         calcPkTables();
     }
     
+    shared_ptr<CsrTransitionTable> csr = getCsrTransitionTable();
+    const DfsmExecutionTable& tbl = getExecutionTable();
+    const int s0 = tbl.getInitState();
+    
+    auto after = [&tbl](int s, vector<int>::const_iterator it, vector<int>::const_iterator end) {
+        for ( ; it != end && s >= 0; ++it ) {
+            s = tbl.getNext(s, *it);
+        }
+        return s;
+    };
+    
     // Auxiliary state cover set needed for further computations
     shared_ptr<Tree> V = getStateCover();
     
     // Test suite is initialised with the state cover
-    shared_ptr<Tree> iTree = getStateCover();
+    InputTrie iTree = getStateCoverTrie();
     
     IOListContainer inputEnum = IOListContainer(maxInput,
                                                 (int)numAddStates+1,
@@ -1473,48 +1779,114 @@ IOListContainer Dfsm::hMethodOnMinimisedDfsm(const unsigned int numAddStates) {
                                                 presentationLayer);
     
     // Initial test suite set is V.Sigma^{m-n+1}, m-n = numAddStates
-    iTree->add(inputEnum);
+    iTree.add(inputEnum, numThreads);
+    
+    IOListContainer iolcV = V->getIOListsWithPrefixes();
+    shared_ptr<vector<vector<int>>> iolV = iolcV.getIOLists();
+    
+    // States reached by the elements of V
+    vector<int> sV;
+    sV.reserve(iolV->size());
+    for ( const auto& alpha : *iolV ) {
+        sV.push_back(after(s0, alpha.cbegin(), alpha.cend()));
+    }
+    
+    /* Each pair u1, u2 of traces leading to different states adds
+     u1.gamma and u2.gamma to the test suite, where gamma distinguishes
+     the states and depends on the sub-tries of iTree after u1 and u2.
+     The traces gamma of a batch of pairs are calculated concurrently
+     on the current iTree. The pairs are then inserted in their serial
+     order; if an earlier pair of the batch has added a node below u1
+     or u2, gamma is recalculated on the updated iTree. Therefore
+     the resulting test suite does not depend on the number of threads. */
+    struct HPair {
+        vector<int> u1;
+        vector<int> u2;
+        int s1;
+        int s2;
+    };
+    
+    const unsigned int nThreads = numWorkerThreads(numThreads);
+    const size_t batchSize = (nThreads > 1) ? 32 * static_cast<size_t>(nThreads) : 1;
+    
+    vector<vector<int>> gammas;
+    vector<unsigned int> touched;
+    unsigned int round = 0;
+    
+    auto insert = [&iTree, &touched, &round](const vector<int>& trc) {
+        size_t oldSize = iTree.size();
+        iTree.addToRoot(trc);
+        if ( iTree.size() == oldSize ) return;
+        
+        /* Mark the proper prefixes of trc: their sub-tries have changed */
+        if ( touched.size() < iTree.size() ) {
+            touched.resize(iTree.size(), 0);
+        }
+        uint32_t n = iTree.getRoot();
+        for ( int x : trc ) {
+            touched[n] = round;
+            n = iTree.after(n, x);
+        }
+    };
+    
+    auto process = [&](const vector<HPair>& pairs) {
+        for ( size_t start = 0; start < pairs.size(); start += batchSize ) {
+            size_t stop = min(pairs.size(), start + batchSize);
+            ++round;
+            
+            if ( batchSize > 1 ) {
+                gammas.assign(stop - start, vector<int>());
+                parallelFor(stop - start, nThreads, [&](size_t i, unsigned int) {
+                    const HPair& p = pairs[start + i];
+                    gammas[i] = calcHDistinguishingTrace(tbl, *csr, p.s1, p.s2, p.u1, p.u2, iTree);
+                });
+            }
+            
+            for ( size_t i = start; i < stop; ++i ) {
+                const HPair& p = pairs[i];
+                vector<int> gamma;
+                bool stale = batchSize == 1;
+                if ( !stale ) {
+                    uint32_t n1 = iTree.after(iTree.getRoot(), p.u1.cbegin(), p.u1.cend());
+                    uint32_t n2 = iTree.after(iTree.getRoot(), p.u2.cbegin(), p.u2.cend());
+                    stale = (n1 < touched.size() && touched[n1] == round) ||
+                            (n2 < touched.size() && touched[n2] == round);
+                }
+                if ( stale ) {
+                    gamma = calcHDistinguishingTrace(tbl, *csr, p.s1, p.s2, p.u1, p.u2, iTree);
+                }
+                else {
+                    gamma.swap(gammas[i - start]);
+                }
+                
+                vector<int> u1Gamma(p.u1);
+                u1Gamma.insert(u1Gamma.end(), gamma.begin(), gamma.end());
+                vector<int> u2Gamma(p.u2);
+                u2Gamma.insert(u2Gamma.end(), gamma.begin(), gamma.end());
+                insert(u1Gamma);
+                insert(u2Gamma);
+            }
+        }
+    };
+    
+    vector<HPair> pairs;
     
     // Step 1.
     // Add all alpha.gamma, beta.gamma where alpha, beta in V
     // and gamma distinguishes s0-after-alpha, s0-after-beta
     // (if alpha.gamma or beta.gamma are already in iTree, addition
     // will not lead to a new test case)
-    IOListContainer iolcV = V->getIOListsWithPrefixes();
-    shared_ptr<vector<vector<int>>> iolV = iolcV.getIOLists();
-    
     for ( size_t i = 0; i < iolV->size(); i++ ) {
-        
-        shared_ptr<InputTrace> alpha =
-        make_shared<InputTrace>(iolV->at(i),presentationLayer);
-
         for ( size_t j = i+1; j < iolV->size(); j++ ) {
-            
-            shared_ptr<InputTrace> beta =
-            make_shared<InputTrace>(iolV->at(j),presentationLayer);
-
-            shared_ptr<Tree> alphaTree = iTree->getSubTree(alpha);
-            shared_ptr<Tree> betaTree = iTree->getSubTree(beta);
-            shared_ptr<Tree> prefixRelationTree = alphaTree->getPrefixRelationTree(betaTree);
-
-            InputTrace gamma = calcDistinguishingTrace(alpha, beta, prefixRelationTree);
-
-            shared_ptr<InputTrace> iAlphaGamma = make_shared<InputTrace>(alpha->get(), presentationLayer);
-            iAlphaGamma->append(gamma.get());
-
-            shared_ptr<InputTrace> iBetaGamma = make_shared<InputTrace>(beta->get(), presentationLayer);
-            iBetaGamma->append(gamma.get());
-
-            iTree->addToRoot(iAlphaGamma->get());
-            iTree->addToRoot(iBetaGamma->get());
+            pairs.push_back(HPair{iolV->at(i), iolV->at(j), sV[i], sV[j]});
         }
-        
     }
+    process(pairs);
     
     // Step 2.
     // For each sequence α.β, α ∈ Q, |β| = m – n + 1, and each non-empty prefix
     // β1 of β that takes the DFSM from s0 to state s,
-    // add sequences α.β1.γ and ω.γ, where ω ∈ V and s0-after-ω ≠ s,
+    // add sequences α.β1.γ and ω.γ, where ω ∈ V and s0-after-ω ≠ s,
     // and γ is a distinguishing sequence of states s0-after-α.β1
     // and s0-after-ω.
     IOListContainer allBeta = IOListContainer(maxInput,
@@ -1526,42 +1898,19 @@ IOListContainer Dfsm::hMethodOnMinimisedDfsm(const unsigned int numAddStates) {
     
     for (const auto &beta : *iolAllBeta ) {
         
-        for (const auto &alpha : *iolV ) {
+        pairs.clear();
+        for ( size_t a = 0; a < iolV->size(); a++ ) {
             
-            shared_ptr<InputTrace> iAlphaBeta =
-                make_shared<InputTrace>(alpha,presentationLayer);
-            iAlphaBeta->append(beta);
-            unordered_set<shared_ptr<FsmNode>>
-                s_alpha_betaSet = s0->after(*iAlphaBeta);
-            shared_ptr<FsmNode> s_alpha_beta = *s_alpha_betaSet.begin();
+            vector<int> alphaBeta(iolV->at(a));
+            alphaBeta.insert(alphaBeta.end(), beta.begin(), beta.end());
+            int s_alpha_beta = after(sV[a], beta.cbegin(), beta.cend());
             
-            for ( auto omega : *iolV ) {
-                shared_ptr<InputTrace>
-                    iOmega = make_shared<InputTrace>(omega,presentationLayer);
-                unordered_set<shared_ptr<FsmNode>>
-                    s_omegaSet = s0->after(*iOmega);
-                shared_ptr<FsmNode> s_omega = *s_omegaSet.begin();
-
-                if ( s_alpha_beta == s_omega ) continue;
-
-                shared_ptr<Tree> alphaBetaTree = iTree->getSubTree(iAlphaBeta);
-                shared_ptr<Tree> trAfterOmega = iTree->getSubTree(iOmega);
-                shared_ptr<Tree> prefixRelationTree = alphaBetaTree->getPrefixRelationTree(trAfterOmega);
-
-                InputTrace gamma = calcDistinguishingTrace(iAlphaBeta, iOmega, prefixRelationTree);
-
-                shared_ptr<InputTrace> iAlphaBetaGamma = make_shared<InputTrace>(iAlphaBeta->get(), presentationLayer);
-                iAlphaBetaGamma->append(gamma.get());
-
-                shared_ptr<InputTrace> iOmegaGamma = make_shared<InputTrace>(iOmega->get(), presentationLayer);
-                iOmegaGamma->append(gamma.get());
-
-                iTree->addToRoot(iAlphaBetaGamma->get());
-                iTree->addToRoot(iOmegaGamma->get());
+            for ( size_t o = 0; o < iolV->size(); o++ ) {
+                if ( s_alpha_beta == sV[o] ) continue;
+                pairs.push_back(HPair{alphaBeta, iolV->at(o), s_alpha_beta, sV[o]});
             }
-            
         }
-        
+        process(pairs);
     }
     
     // Step 3.
@@ -1571,69 +1920,38 @@ IOListContainer Dfsm::hMethodOnMinimisedDfsm(const unsigned int numAddStates) {
     // to two different states add sequences α.β1.γ and α.β2.γ,
     // where γ is a distinguishing sequence of states
     // s0-after-alpha.beta1 and s0-after-alpha.beta2.
-    
-    for ( auto alpha : *iolV ) {
+    for ( size_t a = 0; a < iolV->size(); a++ ) {
         
-        shared_ptr<InputTrace> iAlpha =
-            make_shared<InputTrace>(alpha,presentationLayer);
+        const vector<int>& alpha = iolV->at(a);
+        pairs.clear();
         
-        for ( auto beta : *inputEnum.getIOLists() ) {
-        
-            for ( size_t i = 0; i < beta.size() - 1; i++ ) {
-                
-                shared_ptr<InputTrace> iBeta_1 = make_shared<InputTrace>(presentationLayer);
-                for ( size_t k = 0; k <= i; k++ ) {
-                    iBeta_1->add(beta[k]);
-                }
-                
+        for ( const auto& beta : *inputEnum.getIOLists() ) {
+            
+            // States reached by alpha.beta[0..k]
+            vector<int> sBeta(beta.size());
+            int s = sV[a];
+            for ( size_t k = 0; k < beta.size(); k++ ) {
+                s = (s >= 0) ? tbl.getNext(s, beta[k]) : -1;
+                sBeta[k] = s;
+            }
+            
+            for ( size_t i = 0; i + 1 < beta.size(); i++ ) {
                 for ( size_t j = i+1; j < beta.size(); j++ ) {
+                    if ( sBeta[i] == sBeta[j] ) continue;
                     
-                    shared_ptr<InputTrace> iBeta_2 =
-                        make_shared<InputTrace>(presentationLayer);
-                    for ( size_t k = 0; k <= j; k++ ) {
-                        iBeta_2->add(beta[k]);
-                    }
-                    
-                    shared_ptr<InputTrace> iAlphaBeta_1 =
-                        make_shared<InputTrace>(alpha,presentationLayer);
-                    iAlphaBeta_1->append(iBeta_1->get());
-                    
-                    shared_ptr<InputTrace> iAlphaBeta_2 =
-                    make_shared<InputTrace>(alpha,presentationLayer);
-                    iAlphaBeta_2->append(iBeta_2->get());
-                    
-                    unordered_set<shared_ptr<FsmNode>> s1Set =
-                    s0->after(*iAlphaBeta_1);
-                    shared_ptr<FsmNode> s1 = *s1Set.begin();
-                    
-                    unordered_set<shared_ptr<FsmNode>> s2Set =
-                    s0->after(*iAlphaBeta_2);
-                    shared_ptr<FsmNode> s2 = *s2Set.begin();
-                    
-                    if ( s1 == s2 ) continue;
-
-                    shared_ptr<Tree> afterAlphaBeta1Tree = iTree->getSubTree(iAlphaBeta_1);
-                    shared_ptr<Tree> afterAlphaBeta2Tree = iTree->getSubTree(iAlphaBeta_2);
-                    shared_ptr<Tree> prefixRelationTree = afterAlphaBeta1Tree->getPrefixRelationTree(afterAlphaBeta2Tree);
-
-                    InputTrace gamma = calcDistinguishingTrace(iAlphaBeta_1, iAlphaBeta_2, prefixRelationTree);
-
-                    shared_ptr<InputTrace> iAlphaBeta_1Gamma = make_shared<InputTrace>(iAlphaBeta_1->get(), presentationLayer);
-                    iAlphaBeta_1Gamma->append(gamma.get());
-
-                    shared_ptr<InputTrace> iAlphaBeta_2Gamma = make_shared<InputTrace>(iAlphaBeta_2->get(), presentationLayer);
-                    iAlphaBeta_2Gamma->append(gamma.get());
-
-                    iTree->addToRoot(iAlphaBeta_1Gamma->get());
-                    iTree->addToRoot(iAlphaBeta_2Gamma->get());
+                    vector<int> alphaBeta_1(alpha);
+                    alphaBeta_1.insert(alphaBeta_1.end(), beta.begin(), beta.begin() + i + 1);
+                    vector<int> alphaBeta_2(alpha);
+                    alphaBeta_2.insert(alphaBeta_2.end(), beta.begin(), beta.begin() + j + 1);
+                    pairs.push_back(HPair{alphaBeta_1, alphaBeta_2, sBeta[i], sBeta[j]});
                 }
             }
-        
         }
+        process(pairs);
     }
-
-    return iTree->getIOLists();
-
+    
+    return iTree.getIOLists();
+    
 }
 
 
@@ -1649,101 +1967,33 @@ bool Dfsm::distinguishable(const FsmNode& s1, const FsmNode& s2) {
     
 }
 
-void Dfsm::calculateDistMatrix() {
-    initDistTraces();
+void Dfsm::calculateDistMatrix(const unsigned int numThreads) {
+    // The Pk-tables are no longer needed for the traces, but
+    // callers rely on them being available afterwards
     calcPkTables();
     
-    for ( int n = 0; n < size(); n++ ) {
-        for ( int m = n+1; m < size(); m++ ) {
-            // Skip indistinguishable nodes
-            if ( not distinguishable(*nodes[n], *nodes[m]) ) continue;
-            
-            vector< shared_ptr< vector<int> > > u = calcDistTraces(*nodes[n],*nodes[m]);
-            distTraces[n][m] = u;
-            distTraces[m][n] = u;
-            
-        }
-    }
-    
-    
+    DfsmExecutionTable tbl(*getCsrTransitionTable(), initStateIdx);
+    distMatrix = make_shared<DistinguishingTraceMatrix>(tbl, numThreads);
 }
 
-vector< shared_ptr< vector<int> > >  Dfsm::calcDistTraces(shared_ptr< vector<int> > trc,
-                                                          int id1,
-                                                          int id2) {
-    
-    vector< shared_ptr< vector<int> > > v;
-    
-    for ( int x = 0; x <= maxInput; x++ ) {
-        int y1 = dfsmTable->getRow(id1)->getioSection()[x];
-        int y2 = dfsmTable->getRow(id2)->getioSection()[x];
-        
-        if ( y1 != y2 ) {
-            shared_ptr< vector<int> > newTrc = make_shared< vector<int> >(*trc);
-            newTrc->push_back(x);
-            v.push_back(newTrc);
-        }
-    }
-    
-    return v;
-    
-}
 
-vector< shared_ptr< vector<int> > > Dfsm::calcDistTraces(size_t l,
-                                                         shared_ptr< vector<int> > trc,
-                                                         int id1,
-                                                         int id2) {
-    if ( l == 0 ) return calcDistTraces(trc,id1,id2);
+vector< shared_ptr< vector<int> > > Dfsm::getDistTraces(FsmNode& s1,
+                                                                  FsmNode& s2) {
     
     vector< shared_ptr< vector<int> > > v;
-    shared_ptr<PkTable> thisPkTbl = pktblLst[l];
-    shared_ptr<PkTable> prevPkTbl = pktblLst[l-1];
+    if ( distMatrix == nullptr ) return v;
     
-    for ( int x = 0; x <= maxInput; x++ ) {
-        int idNext1 = thisPkTbl->getRow(id1)->getI2PMap()[x];
-        int idNext2 = thisPkTbl->getRow(id2)->getI2PMap()[x];
-
-        if ( prevPkTbl->getClass(idNext1) != prevPkTbl->getClass(idNext2) ) {
-            shared_ptr< vector<int> > newTrc = make_shared< vector<int> >(*trc);
-            newTrc->push_back(x);
-            vector< shared_ptr< vector<int> > > w = calcDistTraces(l-1,newTrc,idNext1,idNext2);
-            v.insert(v.end(),w.begin(),w.end());
-        }
-        
+    size_t len = distMatrix->getTraceLength(s1.getId(), s2.getId());
+    size_t num = distMatrix->getNumTraces(s1.getId(), s2.getId());
+    for ( size_t k = 0; k < num; k++ ) {
+        const int* trc = distMatrix->getTrace(s1.getId(), s2.getId(), k);
+        v.push_back(make_shared< vector<int> >(trc, trc + len));
     }
-    
     return v;
     
 }
 
 
-vector< shared_ptr< vector<int> > > Dfsm::calcDistTraces(FsmNode& s1,
-                                                         FsmNode& s2) {
-    
-    int id1 = s1.getId();
-    int id2 = s2.getId();
-    
-    // Find first Pk-table distPkTbl,  where s1 and s2 are distinguished
-    size_t l = 0;
-    shared_ptr<PkTable> distPkTbl = nullptr;
-    for ( ; l < pktblLst.size(); l++ ) {
-        distPkTbl = pktblLst[l];
-        if ( distPkTbl->getClass(id1) != distPkTbl->getClass(id2) )
-            break;
-    }
-    
-    return calcDistTraces(l,make_shared< vector<int> >(),id1,id2);
-}
-
-
-vector< shared_ptr< vector<int> > > Dfsm::getDistTraces(FsmNode& s1,
-                                                                  FsmNode& s2) {
-    
-    return distTraces[s1.getId()][s2.getId()];
-    
-}
-
-
 
 
 
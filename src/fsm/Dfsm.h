@@ -23,9 +23,12 @@
 
 
 class PkTable;
+class DfsmExecutionTable;
+class DistinguishingTraceMatrix;
 class IOTrace;
 class SegmentedTrace;
 class TreeNode;
+struct JsonFsmModel;
 
 class Dfsm : public Fsm
 {
@@ -36,6 +39,15 @@ private:
 	//TODO
 	std::vector<std::shared_ptr<PkTable>> pktblLst;
 
+    /**
+     * Dense execution table used by applyDet() and pass(),
+     * created on first use
+     */
+    std::shared_ptr<DfsmExecutionTable> execTable;
+
+    /** Transition table execTable has been created from */
+    std::shared_ptr<CsrTransitionTable> execTableSource;
+
 	/**
 	Create a DFSMTable from the DFSM
 	@return The DFSMTable created
@@ -49,24 +61,49 @@ private:
     void createDfsmTransitionGraph(const std::string& fname);
     
     /**
-     *   distTraces[n][m] contains a vector of pointers to
-     *   traces distinguishing this from FsmNode number n
+     *  Check that a JSON model contains all arrays required by the
+     *  JSON constructors, reporting each missing one
      */
-    std::vector< std::vector< std::vector< std::shared_ptr< std::vector<int> > > > > distTraces;
+    static bool isValidJsonModel(const JsonFsmModel& model);
     
-    void initDistTraces();
+    /**
+     *  Create the presentation layer, states and transitions from a
+     *  valid JSON model; shared by all JSON constructors.
+     *  @param pl Presentation layer to be extended, or nullptr
+     */
+    void createDfsmFromJsonModel(const JsonFsmModel& model,
+                                 const std::shared_ptr<FsmPresentationLayer>& pl);
     
-    std::vector< std::shared_ptr< std::vector<int> > > calcDistTraces(FsmNode& s1,
-                                                                      FsmNode& s2);
+    /**
+     *   Shortest traces distinguishing the pairs of FsmNodes,
+     *   created by calculateDistMatrix()
+     */
+    std::shared_ptr<DistinguishingTraceMatrix> distMatrix;
     
-    std::vector< std::shared_ptr< std::vector<int> > > calcDistTraces(size_t l,
-                                                                      std::shared_ptr< std::vector<int> > trc,
-                                                                      int id1,
-                                                                      int id2);
+    /**
+     * Minimise this DFSM by Hopcroft's partition refinement.
+     * \pre all nodes are reachable and their ids coincide with
+     *      their positions in the node vector
+     * @return the new minimised DFSM
+     */
+    Dfsm minimiseHopcroft();
     
-    std::vector< std::shared_ptr< std::vector<int> > > calcDistTraces(std::shared_ptr< std::vector<int> > trc,
-                                                                      int id1,
-                                                                      int id2);
+    /**
+     * Distinguishing trace used by the H-Method for the states s1 and s2
+     * (indices of the execution table tbl) reached by u1 and u2.
+     * The trace is derived as calcDistinguishingTrace(iAlpha, iBeta, tree)
+     * does, where tree is the prefix relation tree of the sub-tries of
+     * iTree after u1 and u2. This DFSM and iTree are only read, so
+     * several traces may be calculated concurrently.
+     * \pre the Pk-tables have been calculated
+     */
+    std::vector<int> calcHDistinguishingTrace(const DfsmExecutionTable& tbl,
+                                              const CsrTransitionTable& csr,
+                                              const int s1,
+                                              const int s2,
+                                              const std::vector<int>& u1,
+                                              const std::vector<int>& u2,
+                                              const InputTrie& iTree) const;
 
 public:
 	/**
@@ -215,14 +252,38 @@ public:
      */
     Dfsm(const Json::Value& jsonModel,
          const std::shared_ptr<FsmPresentationLayer>& presentationLayer);
+    
+    /**
+     *  Construct a DFSM from a JSON model read by JsonModelReader,
+     *  without building a jsoncpp DOM. The result is the same as
+     *  for Dfsm(const Json::Value&) on the parsed document.
+     */
+    Dfsm(const JsonFsmModel& jsonModel);
+    
+    /**
+     *  Construct a DFSM from a JSON model read by JsonModelReader,
+     *  using a given presentation layer, like
+     *  Dfsm(const Json::Value&, const std::shared_ptr<FsmPresentationLayer>&)
+     */
+    Dfsm(const JsonFsmModel& jsonModel,
+         const std::shared_ptr<FsmPresentationLayer>& presentationLayer);
 
 
 	/**
 	Minimise this DFSM
 	As a side effect, create the DFSM table and all Pk tables needed.
+	@param useHopcroft If true, the equivalence classes are calculated by
+	       Hopcroft's partition refinement in O(|I| n log n) instead of
+	       iterating over the Pk tables. In this case, no DFSM table and
+	       Pk tables are created, neither for this DFSM nor for the
+	       minimised one; operations relying on them (e.g. printTables())
+	       create them on demand, or require a call of minimise() without
+	       this option. The minimised DFSM is the same as the one created
+	       from the Pk tables, apart from the numbering of its states:
+	       these are numbered by the smallest original state they contain.
 	@return the new minimised DFSM
 	*/
-	Dfsm minimise();
+	Dfsm minimise(const bool useHopcroft = false);
 
 	/**
 	Output the DFSM table and the Pk-tables in LaTeX format.
@@ -260,6 +321,38 @@ public:
 	*/
 	bool pass(const IOTrace & io);
 
+    /**
+     Check a batch of IOTraces against the DFSM
+     @param ios IOTraces to be checked against the DFSM
+     @param verdicts On return, verdicts[k] is true if and only if
+            ios[k] is in the language of the DFSM
+     @return Number of IOTraces in the language of the DFSM
+     */
+    size_t pass(const std::vector<IOTrace>& ios, std::vector<bool>& verdicts);
+
+    /**
+     Check whether this DFSM and other are I/O-equivalent, using the
+     union-find algorithm of Hopcroft and Karp on pairs of states.
+     Pairs are processed breadth-first, so that the counterexample
+     is short, but it is not guaranteed to be a shortest one.
+     Inputs that are undefined in one DFSM, but defined in the other
+     one, distinguish the states.
+     @param other The DFSM to compare with
+     @param failTrace Return parameter: if the DFSMs are not equivalent,
+            an I/O trace contained in the language of exactly one of them,
+            nullptr otherwise
+     @return True if the DFSMs are equivalent, False otherwise
+     */
+    bool isEquivalent(const Dfsm& other, std::shared_ptr<IOTrace>& failTrace) const;
+
+    /**
+     Return the dense execution table of this DFSM, which is created
+     on first use. The table is re-created whenever the transition
+     table of the FSM is, see Fsm::getCsrTransitionTable().
+     */
+    const DfsmExecutionTable& getExecutionTable();
+    void resetExecutionTable();
+
    /**
 	* Perform test generation by means of the W-Method.
     * The DFSM this method is applied to is regarded as the reference
@@ -276,6 +369,9 @@ public:
     *                     which the implementation DFSM in minimised 
     *                     for may have, when compared to the reference
     *                     model in minimised form.
+    * @param numThreads Number of worker threads used to expand the
+    *                   test tree (0: one per hardware thread). The
+    *                   test suite does not depend on this value.
 	* @return A test suite
     *
     * @note The size of the test suite to be produced grows exponentially
@@ -285,12 +381,14 @@ public:
     *       then method wMethodOnMinimisedDfsm() should rather be used,
     *       since it avoids unnecessary minisation steps.
 	*/
-	IOListContainer wMethod(const unsigned int numAddStates);
+	IOListContainer wMethod(const unsigned int numAddStates,
+                            const unsigned int numThreads = 1);
 
     /**
      *  Apply the W-Method on a DFSM that is already minimised
      */
-    IOListContainer wMethodOnMinimisedDfsm(const unsigned int numAddStates);
+    IOListContainer wMethodOnMinimisedDfsm(const unsigned int numAddStates,
+                                           const unsigned int numThreads = 1);
 
 
 	/**
@@ -305,14 +403,19 @@ public:
      *                     which the implementation DFSM in minimised
      *                     form may have, when compared to the reference
      *                     model in minimised form.
+     * @param numThreads Number of worker threads used to expand the
+     *                   test tree (0: one per hardware thread). The
+     *                   test suite does not depend on this value.
 	* @return A test suite
 	*/
-	IOListContainer wpMethod(const unsigned int numAddStates);
+	IOListContainer wpMethod(const unsigned int numAddStates,
+                             const unsigned int numThreads = 1);
 
     /**
      * Apply the Wp Method on a DFSM that is already minimised
      */
-    IOListContainer wpMethodOnMinimisedDfsm(const unsigned int numAddStates);
+    IOListContainer wpMethodOnMinimisedDfsm(const unsigned int numAddStates,
+                                            const unsigned int numThreads = 1);
 
     /**
      * WORK IN PROGRESS
@@ -323,9 +426,13 @@ public:
      *                     which the implementation DFSM in minimised
      *                     form may have, when compared to the reference
      *                     model in minimised form.
+     * @param numThreads Number of worker threads used to expand the
+     *                   test tree (0: one per hardware thread). The
+     *                   test suite does not depend on this value.
      * @return a test suite
      */
-    IOListContainer hsiMethod(const unsigned int numAddStates);
+    IOListContainer hsiMethod(const unsigned int numAddStates,
+                              const unsigned int numThreads = 1);
     /**
      * Perform test generation by means of the T-Method. The algorithm 
      * applies to deterministic FSMs which are completely defined.
@@ -355,8 +462,14 @@ public:
      *        H-Method for nondeterministic FSMs which are not
      *        completely specified will be added to the library 
      *        in the future.
+     *
+     *  @param numAddStates The maximal number of additional states
+     *  @param numThreads Number of worker threads calculating the
+     *         distinguishing traces (0: one per hardware thread).
+     *         The test suite does not depend on this value.
      */
-    IOListContainer hMethodOnMinimisedDfsm(const unsigned int numAddStates);
+    IOListContainer hMethodOnMinimisedDfsm(const unsigned int numAddStates,
+                                           const unsigned int numThreads = 1);
     
     
     /**
@@ -430,8 +543,15 @@ public:
     
     /**
      *   Calculate the distinguishability matrix
+     *   @param numThreads Number of worker threads (0: one per hardware thread)
+     */
+    void calculateDistMatrix(const unsigned int numThreads = 1);
+    
+    /**
+     * Return the distinguishability matrix, or nullptr if
+     * calculateDistMatrix() has not been called
      */
-    void calculateDistMatrix();
+    std::shared_ptr<const DistinguishingTraceMatrix> getDistMatrix() const { return distMatrix; }
     
     /**
      * Return the vector of shortest traces distinguishing s1 and s2
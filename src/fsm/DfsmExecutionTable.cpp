@@ -0,0 +1,119 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#include "fsm/DfsmExecutionTable.h"
+#include "fsm/CsrTransitionTable.h"
+
+using namespace std;
+
+DfsmExecutionTable::DfsmExecutionTable(const CsrTransitionTable& csr, const int initState)
+: numStates(csr.size()), numInputs(csr.getMaxInput() + 1), initState(initState),
+next(static_cast<size_t>(csr.size()) * (csr.getMaxInput() + 1), -1),
+out(static_cast<size_t>(csr.size()) * (csr.getMaxInput() + 1), -1)
+{
+    for (int s = 0; s < numStates; ++s)
+    {
+        for (int x = 0; x < numInputs; ++x)
+        {
+            int t = csr.begin(s, x);
+            if (t < csr.end(s, x))
+            {
+                size_t idx = static_cast<size_t>(s) * numInputs + x;
+                next[idx] = csr.getTarget(t);
+                out[idx] = csr.getOutput(t);
+            }
+        }
+    }
+}
+
+size_t DfsmExecutionTable::apply(const int* inputs, const size_t len, int* outputs) const
+{
+    if (initState < 0 or initState >= numStates)
+    {
+        return 0;
+    }
+
+    const int32_t* nextTbl = next.data();
+    const int32_t* outTbl = out.data();
+    size_t s = static_cast<size_t>(initState);
+
+    for (size_t k = 0; k < len; ++k)
+    {
+        int x = inputs[k];
+        if (x < 0 or x >= numInputs)
+        {
+            return k;
+        }
+        size_t idx = s * numInputs + x;
+        int32_t tgt = nextTbl[idx];
+        if (tgt < 0)
+        {
+            return k;
+        }
+        outputs[k] = outTbl[idx];
+        s = static_cast<size_t>(tgt);
+    }
+    return len;
+}
+
+bool DfsmExecutionTable::pass(const int* inputs, const size_t inLen,
+                              const int* outputs, const size_t outLen) const
+{
+    if (initState < 0 or initState >= numStates)
+    {
+        return outLen == 0;
+    }
+
+    const int32_t* nextTbl = next.data();
+    const int32_t* outTbl = out.data();
+    size_t s = static_cast<size_t>(initState);
+
+    size_t k = 0;
+    for (; k < inLen; ++k)
+    {
+        int x = inputs[k];
+        if (x < 0 or x >= numInputs)
+        {
+            break;
+        }
+        size_t idx = s * numInputs + x;
+        int32_t tgt = nextTbl[idx];
+        if (tgt < 0)
+        {
+            break;
+        }
+        // The DFSM produces more outputs than expected, or a different one
+        if (k >= outLen or outTbl[idx] != outputs[k])
+        {
+            return false;
+        }
+        s = static_cast<size_t>(tgt);
+    }
+
+    // All expected outputs must have been produced
+    return k == outLen;
+}
+
+size_t DfsmExecutionTable::pass(const vector<int>& inputs,
+                                const vector<int>& outputs,
+                                const vector<size_t>& offsets,
+                                vector<bool>& verdicts) const
+{
+    size_t numPassed = 0;
+    size_t numTraces = offsets.empty() ? 0 : offsets.size() - 1;
+    verdicts.assign(numTraces, false);
+
+    for (size_t k = 0; k < numTraces; ++k)
+    {
+        size_t first = offsets[k];
+        size_t len = offsets[k + 1] - first;
+        if (pass(inputs.data() + first, len, outputs.data() + first, len))
+        {
+            verdicts[k] = true;
+            ++numPassed;
+        }
+    }
+    return numPassed;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#ifndef FSM_FSM_DFSMEXECUTIONTABLE_H_
+#define FSM_FSM_DFSMEXECUTIONTABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class CsrTransitionTable;
+
+/**
+ Dense execution table of a deterministic FSM: for state s and input x,
+ next[s*(maxInput+1)+x] is the post-state and out[s*(maxInput+1)+x]
+ the output of the transition triggered by x in s. Undefined transitions
+ are marked by -1 in both arrays. If a state has more than one transition
+ for the same input, the first one is taken, as in FsmNode::apply().
+
+ The table does not refer to any FsmNode instances, so that traces can
+ be executed without pointer chasing or memory allocation.
+ */
+class DfsmExecutionTable
+{
+private:
+    /** Number of states */
+    int numStates;
+
+    /** Number of inputs, that is, maxInput+1 */
+    int numInputs;
+
+    /** Index of the initial state */
+    int initState;
+
+    /** Post-states, -1 for undefined transitions */
+    std::vector<int32_t> next;
+
+    /** Outputs, -1 for undefined transitions */
+    std::vector<int32_t> out;
+
+public:
+    /**
+     * Create the execution table from the CSR table of a DFSM
+     * @param csr Transition table of the DFSM
+     * @param initState Index of the initial state in the CSR table
+     */
+    DfsmExecutionTable(const CsrTransitionTable& csr, const int initState);
+
+    int size() const { return numStates; }
+    int getInitState() const { return initState; }
+    int getNumInputs() const { return numInputs; }
+
+    /**
+     * Return the post-state reached from s under input x, or -1
+     * if no transition is defined.
+     */
+    int getNext(const int s, const int x) const
+    {
+        return (x < 0 or x >= numInputs) ? -1 : next[static_cast<size_t>(s) * numInputs + x];
+    }
+
+    /**
+     * Return the output produced in s under input x, or -1
+     * if no transition is defined.
+     */
+    int getOutput(const int s, const int x) const
+    {
+        return (x < 0 or x >= numInputs) ? -1 : out[static_cast<size_t>(s) * numInputs + x];
+    }
+
+    /**
+     * Apply an input trace to the initial state.
+     * @param inputs The input trace
+     * @param len Length of the input trace
+     * @param outputs Array of at least len elements, receiving the outputs
+     * @return Number of inputs that could be processed; this is less than
+     *         len if the DFSM is not completely specified.
+     */
+    size_t apply(const int* inputs, const size_t len, int* outputs) const;
+
+    /**
+     * Check whether an I/O trace is in the language of the DFSM.
+     * This is the case if the maximal processable prefix of the inputs
+     * produces exactly the given outputs.
+     * @param inputs The input trace
+     * @param inLen Length of the input trace
+     * @param outputs The expected outputs
+     * @param outLen Length of the output trace
+     * @return true if and only if the trace passes
+     */
+    bool pass(const int* inputs, const size_t inLen,
+              const int* outputs, const size_t outLen) const;
+
+    /**
+     * Check a batch of I/O traces stored back-to-back in flat arrays.
+     * Trace k occupies positions offsets[k]..offsets[k+1]-1 of both
+     * inputs and outputs.
+     * @param inputs Concatenated input traces
+     * @param outputs Concatenated output traces
+     * @param offsets Start positions of the traces, followed by the total length
+     * @param verdicts On return, verdicts[k] is true if and only if trace k passes
+     * @return Number of passed traces
+     */
+    size_t pass(const std::vector<int>& inputs,
+                const std::vector<int>& outputs,
+                const std::vector<size_t>& offsets,
+                std::vector<bool>& verdicts) const;
+};
+#endif //FSM_FSM_DFSMEXECUTIONTABLE_H_
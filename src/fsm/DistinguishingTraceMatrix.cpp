@@ -0,0 +1,275 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#include <algorithm>
+
+#include "fsm/DistinguishingTraceMatrix.h"
+#include "fsm/DfsmExecutionTable.h"
+#include "sets/ParallelFor.h"
+
+using namespace std;
+
+/** Number of states or state pairs a worker processes at a time */
+static const size_t chunk = 64;
+
+DistinguishingTraceMatrix::DistinguishingTraceMatrix(const DfsmExecutionTable& tbl,
+                                                     const unsigned int numThreads)
+    : numStates(tbl.size()), numInputs(tbl.getNumInputs())
+{
+    const size_t numPairs = static_cast<size_t>(numStates) * (numStates - 1) / 2;
+    lengths.assign(numPairs, 0);
+    begins.assign(numPairs, 0);
+    ends.assign(numPairs, 0);
+    calcTraces(tbl, calcLengths(tbl, numThreads), numThreads);
+}
+
+long long DistinguishingTraceMatrix::successorIndex(const DfsmExecutionTable& tbl,
+                                                    const int s1, const int s2, const int x) const
+{
+    int t1 = tbl.getNext(s1, x);
+    int t2 = tbl.getNext(s2, x);
+    if (t1 < 0 || t2 < 0 || t1 == t2 || tbl.getOutput(s1, x) != tbl.getOutput(s2, x))
+    {
+        return -1;
+    }
+    return static_cast<long long>(t1 < t2 ? pairIndex(t1, t2) : pairIndex(t2, t1));
+}
+
+vector<vector<pair<int,int>>> DistinguishingTraceMatrix::calcLengths(const DfsmExecutionTable& tbl,
+                                                                      const unsigned int numThreads)
+{
+    const unsigned int nThreads = numWorkerThreads(numThreads);
+
+    vector<vector<pair<int,int>>> rounds;
+
+    /* Round 1: the pairs distinguished by the output of a single input,
+     including the inputs defined in only one of the states */
+    rounds.emplace_back();
+    parallelForChunks(static_cast<size_t>(numStates), chunk, nThreads, [&](size_t begin, size_t end, unsigned int)
+    {
+        for (int s1 = static_cast<int>(begin); s1 < static_cast<int>(end); ++s1)
+        {
+            for (int s2 = s1 + 1; s2 < numStates; ++s2)
+            {
+                for (int x = 0; x < numInputs; ++x)
+                {
+                    if (tbl.getOutput(s1, x) != tbl.getOutput(s2, x))
+                    {
+                        lengths[pairIndex(s1, s2)] = 1;
+                        break;
+                    }
+                }
+            }
+        }
+    });
+    for (int s1 = 0; s1 < numStates; ++s1)
+    {
+        for (int s2 = s1 + 1; s2 < numStates; ++s2)
+        {
+            if (lengths[pairIndex(s1, s2)] == 1)
+            {
+                rounds.back().emplace_back(s1, s2);
+            }
+        }
+    }
+
+    /* Predecessors of state s reached with input x are stored at
+     predOffsets[s*numInputs+x]..predOffsets[s*numInputs+x+1]-1 of predStates */
+    vector<int> predOffsets(static_cast<size_t>(numStates) * numInputs + 1, 0);
+    for (int s = 0; s < numStates; ++s)
+    {
+        for (int x = 0; x < numInputs; ++x)
+        {
+            int t = tbl.getNext(s, x);
+            if (t >= 0)
+            {
+                ++predOffsets[static_cast<size_t>(t) * numInputs + x + 1];
+            }
+        }
+    }
+    for (size_t i = 1; i < predOffsets.size(); ++i)
+    {
+        predOffsets[i] += predOffsets[i - 1];
+    }
+    vector<int> predStates(predOffsets.back());
+    vector<int> nextPos(predOffsets);
+    for (int s = 0; s < numStates; ++s)
+    {
+        for (int x = 0; x < numInputs; ++x)
+        {
+            int t = tbl.getNext(s, x);
+            if (t >= 0)
+            {
+                predStates[nextPos[static_cast<size_t>(t) * numInputs + x]++] = s;
+            }
+        }
+    }
+
+    /* Round l+1: the undecided predecessor pairs of the pairs of round l.
+     The workers only read the lengths while expanding the frontier, the
+     candidates are decided afterwards. */
+    vector<vector<pair<int,int>>> candidates(nThreads);
+    while (!rounds.back().empty())
+    {
+        const vector<pair<int,int>>& frontier = rounds.back();
+        const uint32_t length = static_cast<uint32_t>(rounds.size()) + 1;
+        parallelForChunks(frontier.size(), chunk, nThreads, [&](size_t begin, size_t end, unsigned int w)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                for (int x = 0; x < numInputs; ++x)
+                {
+                    size_t i1 = static_cast<size_t>(frontier[i].first) * numInputs + x;
+                    size_t i2 = static_cast<size_t>(frontier[i].second) * numInputs + x;
+                    for (int k1 = predOffsets[i1]; k1 < predOffsets[i1 + 1]; ++k1)
+                    {
+                        for (int k2 = predOffsets[i2]; k2 < predOffsets[i2 + 1]; ++k2)
+                        {
+                            int q1 = predStates[k1];
+                            int q2 = predStates[k2];
+                            if (q1 == q2 || tbl.getOutput(q1, x) != tbl.getOutput(q2, x))
+                            {
+                                continue;
+                            }
+                            if (q1 > q2)
+                            {
+                                swap(q1, q2);
+                            }
+                            if (lengths[pairIndex(q1, q2)] == 0)
+                            {
+                                candidates[w].emplace_back(q1, q2);
+                            }
+                        }
+                    }
+                }
+            }
+        });
+
+        vector<pair<int,int>> nextFrontier;
+        for (auto& c : candidates)
+        {
+            for (const pair<int,int>& p : c)
+            {
+                uint32_t& l = lengths[pairIndex(p.first, p.second)];
+                if (l == 0)
+                {
+                    l = length;
+                    nextFrontier.push_back(p);
+                }
+            }
+            c.clear();
+        }
+        sort(nextFrontier.begin(), nextFrontier.end());
+        rounds.push_back(move(nextFrontier));
+    }
+    rounds.pop_back();
+    return rounds;
+}
+
+void DistinguishingTraceMatrix::calcTraces(const DfsmExecutionTable& tbl,
+                                           const vector<vector<pair<int,int>>>& rounds,
+                                           const unsigned int numThreads)
+{
+    for (size_t r = 0; r < rounds.size(); ++r)
+    {
+        const vector<pair<int,int>>& pairs = rounds[r];
+        const size_t length = r + 1;
+
+        // Number of traces of every pair of this round
+        vector<size_t> counts(pairs.size(), 0);
+        parallelForChunks(pairs.size(), chunk, numThreads, [&](size_t begin, size_t end, unsigned int)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const int s1 = pairs[i].first;
+                const int s2 = pairs[i].second;
+                for (int x = 0; x < numInputs; ++x)
+                {
+                    if (length == 1)
+                    {
+                        counts[i] += (tbl.getOutput(s1, x) != tbl.getOutput(s2, x)) ? 1 : 0;
+                        continue;
+                    }
+                    long long succ = successorIndex(tbl, s1, s2, x);
+                    if (succ >= 0 && lengths[succ] == length - 1)
+                    {
+                        counts[i] += (ends[succ] - begins[succ]) / (length - 1);
+                    }
+                }
+            }
+        });
+
+        // The traces of the pairs are appended in the order of the pairs
+        size_t pos = traces.size();
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            size_t p = pairIndex(pairs[i].first, pairs[i].second);
+            begins[p] = pos;
+            pos += counts[i] * length;
+            ends[p] = pos;
+        }
+        traces.resize(pos);
+
+        // The buffer is not reallocated while the traces of the pairs
+        // of this round are written and those of the last round are read
+        parallelForChunks(pairs.size(), chunk, numThreads, [&](size_t begin, size_t end, unsigned int)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const int s1 = pairs[i].first;
+                const int s2 = pairs[i].second;
+                size_t out = begins[pairIndex(s1, s2)];
+                for (int x = 0; x < numInputs; ++x)
+                {
+                    if (length == 1)
+                    {
+                        if (tbl.getOutput(s1, x) != tbl.getOutput(s2, x))
+                        {
+                            traces[out++] = x;
+                        }
+                        continue;
+                    }
+                    long long succ = successorIndex(tbl, s1, s2, x);
+                    if (succ < 0 || lengths[succ] != length - 1)
+                    {
+                        continue;
+                    }
+                    for (size_t in = begins[succ]; in < ends[succ]; in += length - 1)
+                    {
+                        traces[out++] = x;
+                        copy(traces.begin() + in, traces.begin() + in + (length - 1), traces.begin() + out);
+                        out += length - 1;
+                    }
+                }
+            }
+        });
+    }
+}
+
+size_t DistinguishingTraceMatrix::getTraceLength(const int s1, const int s2) const
+{
+    if (s1 == s2)
+    {
+        return 0;
+    }
+    return lengths[s1 < s2 ? pairIndex(s1, s2) : pairIndex(s2, s1)];
+}
+
+size_t DistinguishingTraceMatrix::getNumTraces(const int s1, const int s2) const
+{
+    size_t length = getTraceLength(s1, s2);
+    if (length == 0)
+    {
+        return 0;
+    }
+    size_t p = s1 < s2 ? pairIndex(s1, s2) : pairIndex(s2, s1);
+    return (ends[p] - begins[p]) / length;
+}
+
+const int* DistinguishingTraceMatrix::getTrace(const int s1, const int s2, const size_t k) const
+{
+    size_t p = s1 < s2 ? pairIndex(s1, s2) : pairIndex(s2, s1);
+    return traces.data() + begins[p] + k * lengths[p];
+}
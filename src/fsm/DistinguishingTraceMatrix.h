@@ -0,0 +1,118 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#ifndef FSM_FSM_DISTINGUISHINGTRACEMATRIX_H_
+#define FSM_FSM_DISTINGUISHINGTRACEMATRIX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class DfsmExecutionTable;
+
+/**
+ Shortest distinguishing traces of all state pairs of a DFSM.
+
+ The length of the shortest distinguishing traces of every state pair is
+ calculated by a single backward breadth-first search over the pair
+ graph: the pairs distinguished by a single input form the first
+ frontier, and the pairs of round l+1 are the undecided predecessor
+ pairs of the pairs of round l. The frontier of a round is expanded
+ concurrently in chunks.
+
+ For a pair distinguished in round l, the traces of length l are the
+ inputs x leading to a pair of round l-1, each followed by the traces of
+ that pair. They are enumerated in ascending order of x, as by the former
+ recursive calculation based on Pk-tables. All traces are stored back to
+ back in one shared buffer; a triangular matrix holds for every pair the
+ offsets of its traces in the buffer, so that the traces of a pair are
+ looked up in constant time.
+ */
+class DistinguishingTraceMatrix
+{
+private:
+    /** Number of states */
+    int numStates;
+
+    /** Number of inputs, that is, maxInput+1 */
+    int numInputs;
+
+    /** Concatenated distinguishing traces of all pairs */
+    std::vector<int> traces;
+
+    /**
+     * Length of the shortest distinguishing traces of every pair,
+     * 0 for indistinguishable pairs, indexed by pairIndex()
+     */
+    std::vector<uint32_t> lengths;
+
+    /**
+     * The traces of pair p occupy positions begins[p]..ends[p]-1
+     * of the trace buffer
+     */
+    std::vector<size_t> begins;
+    std::vector<size_t> ends;
+
+    /** Index of the pair s1 < s2 in the triangular matrix */
+    size_t pairIndex(const int s1, const int s2) const
+    {
+        return static_cast<size_t>(s1) * (2 * static_cast<size_t>(numStates) - s1 - 1) / 2
+            + (s2 - s1 - 1);
+    }
+
+    /**
+     * Index of the pair of post-states reached from s1 and s2 with input
+     * x, if x leads from both states to distinct states with the same
+     * output, otherwise -1
+     */
+    long long successorIndex(const DfsmExecutionTable& tbl,
+                             const int s1, const int s2, const int x) const;
+
+    /**
+     * Calculate the lengths of the shortest distinguishing traces
+     * @return The pairs s1 < s2 of every round of the search, ordered by
+     *         s1 and s2
+     */
+    std::vector<std::vector<std::pair<int,int>>> calcLengths(const DfsmExecutionTable& tbl,
+                                                             const unsigned int numThreads);
+
+    /**
+     * Fill the trace buffer with the traces of the pairs of every round
+     */
+    void calcTraces(const DfsmExecutionTable& tbl,
+                    const std::vector<std::vector<std::pair<int,int>>>& rounds,
+                    const unsigned int numThreads);
+
+public:
+    /**
+     * Calculate the shortest distinguishing traces of all state pairs
+     * @param tbl Execution table of the DFSM
+     * @param numThreads Number of worker threads (0: one per hardware thread)
+     */
+    DistinguishingTraceMatrix(const DfsmExecutionTable& tbl,
+                              const unsigned int numThreads = 1);
+
+    int size() const { return numStates; }
+
+    /**
+     * Return the length of the shortest traces distinguishing s1 and s2,
+     * or 0 if they are not distinguishable
+     */
+    size_t getTraceLength(const int s1, const int s2) const;
+
+    /**
+     * Return the number of shortest traces distinguishing s1 and s2
+     */
+    size_t getNumTraces(const int s1, const int s2) const;
+
+    /**
+     * Return the k-th shortest trace distinguishing s1 and s2. The trace
+     * consists of getTraceLength(s1, s2) inputs and remains valid as long
+     * as this matrix exists.
+     */
+    const int* getTrace(const int s1, const int s2, const size_t k) const;
+};
+#endif //FSM_FSM_DISTINGUISHINGTRACEMATRIX_H_
@@ -4,11 +4,26 @@
  * Licensed under the EUPL V.1.1
  */
 
+#include <atomic>
 #include <chrono>
 #include <deque>
 #include <algorithm>
 #include <regex>
+#include <cmath>
+#include <cstring>
+#include <functional>
 
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "fsm/CsrTransitionTable.h"
+#include "fsm/SignatureRefinement.h"
 #include "fsm/Dfsm.h"
 #include "fsm/Fsm.h"
 #include "fsm/FsmNode.h"
@@ -18,11 +33,14 @@
 #include "fsm/IOTraceContainer.h"
 #include "fsm/OFSMTable.h"
 #include "fsm/RDistinguishability.h"
+#include "fsm/RDistinguishabilityTable.h"
 #include "fsm/VPrimeLazy.h"
 #include "sets/HittingSet.h"
+#include "sets/ParallelFor.h"
 #include "trees/TreeNode.h"
 #include "trees/OutputTree.h"
 #include "trees/Tree.h"
+#include "trees/InputTrie.h"
 #include "trees/IOListContainer.h"
 #include "trees/IOTreeContainer.h"
 #include "trees/TestSuite.h"
@@ -34,6 +52,23 @@
 using namespace std;
 using namespace std::chrono;
 
+namespace {
+
+    /** Hash function for sorted sets of state indices */
+    struct SubsetHash {
+        size_t operator()(const vector<int>& v) const
+        {
+            size_t h = v.size();
+            for (int i : v)
+            {
+                h ^= static_cast<size_t>(i) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            }
+            return h;
+        }
+    };
+
+}
+
 too_many_transition_faults::too_many_transition_faults(const std::string& msg): runtime_error(msg)
 {
 
@@ -102,6 +137,195 @@ shared_ptr<FsmNode> Fsm::findp(const vector<shared_ptr<FsmNode>>& lst,
     return nullptr;
 }
 
+namespace
+{
+    /** Whitespace skipped by operator>> within a line */
+    inline bool isLineSpace(const char c)
+    {
+        return c == ' ' or c == '\t' or c == '\r' or c == '\v' or c == '\f';
+    }
+
+    /**
+     * Scan an integer the way operator>> does on an istringstream of the
+     * line: skip whitespace, accept an optional sign and at least one digit.
+     * Numbers of more than 9 digits are rejected, so that the value fits
+     * into an int.
+     * @return false if no integer could be scanned before eol
+     */
+    bool scanInt(const char*& p, const char* eol, int& value)
+    {
+        while (p < eol and isLineSpace(*p)) ++p;
+        bool negative = false;
+        if (p < eol and (*p == '-' or *p == '+'))
+        {
+            negative = (*p == '-');
+            ++p;
+        }
+        const char* digits = p;
+        int v = 0;
+        while (p < eol and *p >= '0' and *p <= '9')
+        {
+            v = v * 10 + (*p - '0');
+            ++p;
+        }
+        if (p == digits or p - digits > 9)
+        {
+            return false;
+        }
+        value = negative ? -v : v;
+        return true;
+    }
+    
+    /**
+     * Return the nodes of a set ordered by id. Iterating over the set
+     * itself visits the nodes in an order depending on their addresses.
+     */
+    vector<shared_ptr<FsmNode>> sortById(const unordered_set<shared_ptr<FsmNode>>& nodeSet)
+    {
+        vector<shared_ptr<FsmNode>> sorted(nodeSet.begin(), nodeSet.end());
+        sort(sorted.begin(), sorted.end(),
+             [](const shared_ptr<FsmNode>& a, const shared_ptr<FsmNode>& b) {
+                 return a->getId() < b->getId();
+             });
+        return sorted;
+    }
+}
+
+bool Fsm::readFsmFast(const string & fname)
+{
+#ifndef _WIN32
+    int fd = ::open(fname.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    const size_t len = static_cast<size_t>(st.st_size);
+    void* mapped = nullptr;
+    if (len > 0)
+    {
+        mapped = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        return false;
+    }
+    const char* data = static_cast<const char*>(mapped);
+#else
+    // No mmap(): read the whole file into a buffer instead
+    ifstream in(fname, ios::binary);
+    if (not in)
+    {
+        return false;
+    }
+    const string buffer((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    const char* data = buffer.data();
+    const size_t len = buffer.size();
+#endif
+    const char* end = data + len;
+    
+    // Counting pass: one row of four integers per line
+    vector<int> rows;
+    rows.reserve(4 * (static_cast<size_t>(count(data, end, '\n')) + 1));
+    bool simple = true;
+    for (const char* p = data; p < end and simple; )
+    {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (eol == nullptr) eol = end;
+        for (int k = 0; k < 4 and simple; ++k)
+        {
+            int v;
+            simple = scanInt(p, eol, v);
+            if (simple)
+            {
+                rows.push_back(v);
+            }
+        }
+        // Anything following the fourth integer is ignored
+        p = eol + 1;
+    }
+#ifndef _WIN32
+    if (mapped != nullptr)
+    {
+        munmap(mapped, len);
+    }
+#endif
+    if (not simple)
+    {
+        return false;
+    }
+    
+    // Determine maxInput, maxOutput, maxState as in parseLineInitial()
+    const size_t numRows = rows.size() / 4;
+    for (size_t r = 0; r < numRows; ++r)
+    {
+        const int* row = &rows[4 * r];
+        if ( row[0] > maxState ) maxState = row[0];
+        if ( row[3] > maxState ) maxState = row[3];
+        if ( row[1] > maxInput ) maxInput = row[1];
+        if ( row[2] > maxOutput ) maxOutput = row[2];
+    }
+    
+    nodes.resize(nodes.size() + static_cast<size_t>(maxState + 1), nullptr);
+    
+    // Drop the rows rejected by parseLine() and count the
+    // transitions of every state
+    const int numNodes = static_cast<int>(nodes.size());
+    vector<int> outDegree(nodes.size(), 0);
+    size_t numValid = 0;
+    for (size_t r = 0; r < numRows; ++r)
+    {
+        const int* row = &rows[4 * r];
+        if (row[0] < 0 or numNodes <= row[0] or
+            row[3] < 0 or numNodes <= row[3] or
+            row[1] < 0 or maxInput < row[1] or
+            row[2] < 0 or maxOutput < row[2])
+        {
+            continue;
+        }
+        copy(row, row + 4, &rows[4 * numValid++]);
+        ++outDegree[row[0]];
+    }
+    
+    // Build the nodes and transitions in one sweep, in the order
+    // in which parseLine() creates them
+    auto getNode = [&](const int id)
+    {
+        if (nodes[id] == nullptr)
+        {
+            nodes[id] = make_shared<FsmNode>(id, name, presentationLayer);
+            nodes[id]->getTransitions().reserve(outDegree[id]);
+        }
+        return nodes[id];
+    };
+    initStateIdx = -1;
+    for (size_t r = 0; r < numValid; ++r)
+    {
+        const int* row = &rows[4 * r];
+        
+        /*First node number occurring in the file defines the initial state*/
+        if (initStateIdx < 0)
+        {
+            initStateIdx = row[0];
+        }
+        currentParsedNode = getNode(row[0]);
+        shared_ptr<FsmNode> tgt = getNode(row[3]);
+        shared_ptr<FsmLabel> theLabel =
+        make_shared<FsmLabel>(row[1], row[2], presentationLayer);
+        currentParsedNode->addTransition(make_shared<FsmTransition>(currentParsedNode,
+                                                                    tgt,
+                                                                    theLabel));
+    }
+    
+    return true;
+}
+
 void Fsm::parseLine(const string & line)
 {
     stringstream ss(line);
@@ -187,6 +411,18 @@ void Fsm::parseLineInitial (const string & line)
 
 
 void Fsm::readFsm(const string & fname)
+{
+    
+    // Files consisting of well-formed lines only are parsed without
+    // streams; everything else is left to readFsmStream()
+    if (not readFsmFast(fname))
+    {
+        readFsmStream(fname);
+    }
+    
+}
+
+void Fsm::readFsmStream(const string & fname)
 {
     
     // Read the FSM file first to determine maxInput, maxOutput, maxState
@@ -411,18 +647,19 @@ void Fsm::readFsmFromDot (const string & fname, const string name)
 }
 
 
-string Fsm::labelString(unordered_set<shared_ptr<FsmNode>>& lbl) const
+string Fsm::labelString(const vector<int>& lbl, const CsrTransitionTable& csr) const
 {
     string s = "{ ";
     
     bool isFirst = true;
-    for (shared_ptr<FsmNode> n : lbl)
+    for (int idx : lbl)
     {
         if (!isFirst)
         {
             s += ",";
         }
         isFirst = false;
+        const shared_ptr<FsmNode>& n = csr.getNode(idx);
         s += n->getName() + "(" + to_string(n->getId()) + ")";
     }
     
@@ -616,22 +853,36 @@ void Fsm::dumpFsm(ofstream & outputFile) const
 
 vector<shared_ptr<FsmNode>> Fsm::calcDReachableStates(InputTraceSet& detStateCover)
 {
-    TIMED_FUNC(timerObj);
+    vector<shared_ptr<IOTrace>> dReachTraces;
+    vector<shared_ptr<FsmNode>> nodes = calcDReachableStates(detStateCover, dReachTraces);
+    for (const shared_ptr<FsmNode>& n : nodes)
+    {
+        n->setDReachable(dReachTraces.at(n->getId()));
+    }
+    dReachableStates = nodes;
+    return nodes;
+}
+
+vector<shared_ptr<FsmNode>> Fsm::calcDReachableStates(InputTraceSet& detStateCover,
+                                                      vector<shared_ptr<IOTrace>>& dReachTraces) const
+{
+    TIMED_FUNC_IF(timerObj, VLOG_IS_ON(2));
     VLOG(2) << "getDReachableStates()";
-    resetColor();
     deque<shared_ptr<FsmNode>> bfsLst;
     vector<shared_ptr<FsmNode>> nodes;
-    map<shared_ptr<FsmNode>, shared_ptr<IOTrace>> paths;
+    
+    // A state has been reached (is no longer 'white') if and only if
+    // a path to it exists, so the paths replace the node colours.
+    vector<shared_ptr<IOTrace>>& paths = dReachTraces;
+    paths.assign(this->nodes.size(), nullptr);
 
     shared_ptr<FsmNode> initState = getInitialState();
-    initState->setColor(FsmNode::grey);
     bfsLst.push_back(initState);
     nodes.push_back(initState);
     shared_ptr<IOTrace> emptyTrace = IOTrace::getEmptyTrace(presentationLayer);
     detStateCover.insert(make_shared<InputTrace>(FsmLabel::EPSILON, presentationLayer));
     emptyTrace->setTargetNode(initState);
-    initState->setDReachable(emptyTrace);
-    paths.insert(make_pair(initState, IOTrace::getEmptyTrace(presentationLayer)));
+    paths.at(initState->getId()) = emptyTrace;
 
     while (!bfsLst.empty())
     {
@@ -643,15 +894,8 @@ vector<shared_ptr<FsmNode>> Fsm::calcDReachableStates(InputTraceSet& detStateCov
 
         if (!thisNode->isInitial())
         {
-            try
-            {
-                thisNodePath = paths.at(thisNode);
-                VLOG(2) << "thisNodePath: " << *thisNodePath;
-            }
-            catch (out_of_range e)
-            {
-                // DO nothing.
-            }
+            thisNodePath = paths.at(thisNode->getId());
+            VLOG(2) << "thisNodePath: " << *thisNodePath;
         }
 
         for (int x = 0; x <= maxInput; ++x)
@@ -698,45 +942,37 @@ vector<shared_ptr<FsmNode>> Fsm::calcDReachableStates(InputTraceSet& detStateCov
             }
             shared_ptr<FsmNode> tgt = successorNodes.at(0);
             VLOG(2) << "tgt:" << tgt->getName();
-            try
+            if (paths.at(tgt->getId()))
             {
-                paths.at(tgt);
                 // Path already exists. Do nothing.
                 VLOG(2) << "Path already exists. Do nothing.";
+                continue;
             }
-            catch (out_of_range e)
+
+            // Create new path, since it doesn't exist.
+            shared_ptr<IOTrace> newPath;
+            if (thisNodePath)
             {
-                // Create new path, since it doesn't exist.
-                shared_ptr<IOTrace> newPath;
-                if (thisNodePath)
-                {
-                    newPath = make_shared<IOTrace>(*thisNodePath);
-                    newPath->append(x, producedOutputs.at(0));
-                    VLOG(2) << "newPath (appended): " << *newPath;
-                }
-                else
-                {
-                    InputTrace in = InputTrace({x}, presentationLayer);
-                    OutputTrace out = OutputTrace({producedOutputs.at(0)}, presentationLayer);
-                    newPath = make_shared<IOTrace>(in, out);
-                    VLOG(2) << "newPath (new): " << *newPath;
-                }
-                newPath->setTargetNode(tgt);
-                paths.insert(make_pair(tgt, newPath));
+                newPath = make_shared<IOTrace>(*thisNodePath);
+                newPath->append(x, producedOutputs.at(0));
+                VLOG(2) << "newPath (appended): " << *newPath;
             }
-            if (tgt->getColor() == FsmNode::white)
+            else
             {
-                VLOG(2) << "Target color is white. Setting grey, adding node, setting d-reach path.";
-                tgt->setColor(FsmNode::grey);
-                bfsLst.push_back(tgt);
-                nodes.push_back(tgt);
-                detStateCover.insert(make_shared<InputTrace>(paths.at(tgt)->getInputTrace()));
-                tgt->setDReachable(paths.at(tgt));
+                InputTrace in = InputTrace({x}, presentationLayer);
+                OutputTrace out = OutputTrace({producedOutputs.at(0)}, presentationLayer);
+                newPath = make_shared<IOTrace>(in, out);
+                VLOG(2) << "newPath (new): " << *newPath;
             }
+            newPath->setTargetNode(tgt);
+            paths.at(tgt->getId()) = newPath;
+
+            VLOG(2) << "Adding node with its d-reach path.";
+            bfsLst.push_back(tgt);
+            nodes.push_back(tgt);
+            detStateCover.insert(make_shared<InputTrace>(newPath->getInputTrace()));
         }
     }
-    resetColor();
-    dReachableStates = nodes;
     return nodes;
 }
 
@@ -781,6 +1017,26 @@ int Fsm::getInitStateIdx() const
     return initStateIdx;
 }
 
+shared_ptr<CsrTransitionTable> Fsm::getCsrTransitionTable() const
+{
+    shared_ptr<CsrTransitionTable> tbl = atomic_load(&csrTable);
+    if (tbl == nullptr or tbl->getGeneration() != FsmNode::getStructureGeneration())
+    {
+        // Concurrent readers may build the table at the same time;
+        // the one stored first is kept for later calls
+        shared_ptr<CsrTransitionTable> fresh =
+            make_shared<CsrTransitionTable>(nodes, maxInput, maxOutput);
+        atomic_compare_exchange_strong(&csrTable, &tbl, fresh);
+        return fresh;
+    }
+    return tbl;
+}
+
+void Fsm::resetCsrTransitionTable()
+{
+    atomic_store(&csrTable, shared_ptr<CsrTransitionTable>());
+}
+
 void Fsm::resetColor()
 {
     for (auto node : nodes)
@@ -964,24 +1220,33 @@ int Fsm::getNumberOfDifferentInputTransitions(vector<shared_ptr<FsmNode>> nodePo
     return result;
 }
 
-Fsm Fsm::intersect(const Fsm & f, string name)
+Fsm Fsm::intersect(const Fsm & f, string name, const bool stopAtFailure)
 {
-    // A list of node pairs which is used to
-    // control the breath-first search (BFS)
-    deque<shared_ptr<pair<shared_ptr<FsmNode>, shared_ptr<FsmNode>>>> nodeList;
+    // Compact views of both transition relations. The BFS below
+    // only works on the state indices of these tables.
+    shared_ptr<CsrTransitionTable> myCsr = getCsrTransitionTable();
+    shared_ptr<CsrTransitionTable> theirCsr = f.getCsrTransitionTable();
+    const size_t theirSize = static_cast<size_t>(theirCsr->size());
+    const size_t numPairs = static_cast<size_t>(myCsr->size()) * theirSize;
+    
+    // Map a pair of state indices (s1,s2) to the id of the new FSM state
+    // created for it. For moderate state numbers, the pairs are indexed
+    // densely by s1*|S2|+s2, otherwise a hash map is used.
+    const bool densePairIndex = numPairs <= (static_cast<size_t>(1) << 22);
+    vector<int> pairIdDense(densePairIndex ? numPairs : 0, -1);
+    unordered_map<size_t, int> pairIdSparse;
     
     // A list of new FSM states, each state created from a pair of
     // this-nodes and f-nodes. At the end of this operation,
     // the new FSM will be created from this list.
+    // The new states are processed in the order of their creation,
+    // so that the list also controls the breath-first search (BFS):
+    // the states at positions head..fsmInterNodes.size()-1 are still
+    // to be processed. pairs[i] holds the state indices of new state i.
     vector<shared_ptr<FsmNode>> fsmInterNodes;
-    int id = 0;
+    vector<pair<int, int>> pairs;
+    size_t head = 0;
     
-    // Initially, add the pair of initial this-node and f-node
-    // into the BFS list.
-    nodeList.push_back(make_shared<pair<shared_ptr<FsmNode>, shared_ptr<FsmNode>>>(getInitialState(), f.getInitialState()));
-
-    bool isInitialState = true;
-
     // We need a new presentation layer. It has the same inputs and
     // outputs as this Fsm, but the state names will be pairs of
     // state names from this FSM and f
@@ -991,117 +1256,173 @@ Fsm Fsm::intersect(const Fsm & f, string name)
                                       presentationLayer->getOut2String(),
                                       stateNames);
     
-    // This is the BFS loop, running over the (this,f)-node pairs
-    while (!nodeList.empty())
-    {
-        // Remove the head of the list and use p to refer to it
-        // p refers to the SOURCE node pair, from where all
-        // outgoing transitions are investigated in this loop cycle
-        shared_ptr<pair<shared_ptr<FsmNode>, shared_ptr<FsmNode>>>
-            p = nodeList.front();
-        nodeList.pop_front();
+    // Labels of the new FSM, shared by all transitions with the same
+    // input/output pair in range 0..maxInput, 0..maxOutput
+    vector<shared_ptr<FsmLabel>> labels((maxInput + 1) * (maxOutput + 1));
+    
+    // Set when a state (s1,s2) has been created where s2 has a
+    // transition label which does not exist in s1
+    bool failureFound = false;
+    
+    // Return the new FSM state associated with (s1,s2), or nullptr,
+    // if it does not exist yet
+    auto findPair = [&](const int s1, const int s2) -> shared_ptr<FsmNode>
+    {
+        size_t key = static_cast<size_t>(s1) * theirSize + s2;
+        int pairId = -1;
+        if (densePairIndex)
+        {
+            pairId = pairIdDense[key];
+        }
+        else
+        {
+            auto it = pairIdSparse.find(key);
+            if (it != pairIdSparse.end())
+            {
+                pairId = it->second;
+            }
+        }
+        return (pairId < 0) ? nullptr : fsmInterNodes[pairId];
+    };
+    
+    // Create the new FSM state associated with (s1,s2)
+    auto createPair = [&](const int s1, const int s2) -> shared_ptr<FsmNode>
+    {
+        const shared_ptr<FsmNode>& myNode = myCsr->getNode(s1);
+        const shared_ptr<FsmNode>& theirNode = theirCsr->getNode(s2);
         
-        // current node of this FSM
-        shared_ptr<FsmNode> myCurrentNode = p->first;
+        // Set the node name as pair of the individual node names
+        string newNodeName("(" + myNode->getName() + "," +
+                           theirNode->getName() + ")");
         
-        // current node of the f-FSM
-        shared_ptr<FsmNode> theirCurrentNode = p->second;
+        // Register node name in new presentation layer
+        newPl->addState2String(newNodeName);
         
-        // Do we already have an FSM state for the new FSM
-        // stored in fsmInterNodes, which is associated
-        // with the current pair p?
-        shared_ptr<FsmNode> nSource = findp(fsmInterNodes, p);
+        int pairId = static_cast<int>(fsmInterNodes.size());
+        size_t key = static_cast<size_t>(s1) * theirSize + s2;
+        if (densePairIndex)
+        {
+            pairIdDense[key] = pairId;
+        }
+        else
+        {
+            pairIdSparse[key] = pairId;
+        }
         
-        if (nSource == nullptr)
+        shared_ptr<FsmNode> n =
+        newNode(pairId,
+                make_shared<pair<shared_ptr<FsmNode>, shared_ptr<FsmNode>>>(myNode, theirNode),
+                newPl);
+        fsmInterNodes.push_back(n);
+        pairs.push_back(make_pair(s1, s2));
+        
+        if (stopAtFailure)
         {
-            // Set the node name as pair of the individual node names
-            string newNodeName("(" + myCurrentNode->getName() + "," +
-                               theirCurrentNode->getName() + ")");
-            
-            // Register node name in new presentation layer
-            newPl->addState2String(newNodeName);
-            
-            // We create the new FSM state associated with p:
-            // nSource is created from the state
-            // pair(myCurrentNode,theirCurrentNode)
-            // which is identified by p.
-            nSource = newNode(id++, p, newPl);
-            // Adding the trace that reaches the new state.
-            if (isInitialState)
+            // Same criterion as hasFailure(): every label of s2
+            // must also occur in s1
+            for (int t2 = theirCsr->begin(s2); t2 < theirCsr->end(s2) and not failureFound; ++t2)
             {
-                isInitialState = false;
-                nSource->setReachTrace(IOTrace::getEmptyTrace(newPl));
+                bool foundTransition = false;
+                int x = theirCsr->getInput(t2);
+                for (int t1 = myCsr->begin(s1, x); t1 < myCsr->end(s1, x); ++t1)
+                {
+                    if (myCsr->getOutput(t1) == theirCsr->getOutput(t2))
+                    {
+                        foundTransition = true;
+                        break;
+                    }
+                }
+                failureFound = not foundTransition;
             }
-            fsmInterNodes.push_back(nSource);
-            
         }
+        return n;
+    };
+    
+    // Initially, add the pair of initial this-node and f-node
+    // into the BFS list.
+    createPair(myCsr->getIndex(getInitialState().get()),
+               theirCsr->getIndex(f.getInitialState().get()))
+        ->setReachTrace(IOTrace::getEmptyTrace(newPl));
+    
+    // This is the BFS loop, running over the (this,f)-node pairs
+    while (head < fsmInterNodes.size() and not failureFound)
+    {
+        // Take the head of the list: nSource is the SOURCE node
+        // pair, from where all outgoing transitions are
+        // investigated in this loop cycle
+        shared_ptr<FsmNode> nSource = fsmInterNodes[head];
+        
+        // current node of this FSM
+        int myIdx = pairs[head].first;
+        
+        // current node of the f-FSM
+        int theirIdx = pairs[head].second;
+        ++head;
         
         // Mark this node: now all of its outgoing transitions are constructed
         nSource->setVisited();
         
         // Loop over all transitions emanating from myCurrentNode
-        for (auto tr : myCurrentNode->getTransitions())
+        for (int t = myCsr->begin(myIdx); t < myCsr->end(myIdx) and not failureFound; ++t)
         {
-            // Loop over all transitions emanating from theirCurrentNode
-            for (auto trOther : theirCurrentNode->getTransitions())
+            int x = myCsr->getInput(t);
+            int y = myCsr->getOutput(t);
+            
+            /* Only the transitions of theirCurrentNode with identical
+               label x/y lead to transitions of the new FSM.
+               The transition has source node (myCurrentNode,theirCurrentNode),
+               label x/y and target node (tr.getTarget(),trOther.getTarget()),
+               which is the pair of the target nodes
+               of each transition.*/
+            for (int tOther = theirCsr->begin(theirIdx, x); tOther < theirCsr->end(theirIdx, x); ++tOther)
             {
-                /* If tr and trOther have identical labels, we can create a
-                   transition for the new FSM to be created.
-                   The transition has source node (myCurrentNode,theirCurrentNode)
-                   and label tr.getLabel(), which is the same as
-                   the label associated with the other transition,
-                   and target node (tr.getTarget(),trOther.getTarget()),
-                   which is the pair of the target nodes
-                   of each transition.*/
+                if (theirCsr->getOutput(tOther) != y)
+                {
+                    continue;
+                }
                 
-                if (*tr->getLabel() == *trOther->getLabel())
+                shared_ptr<FsmLabel> lbl;
+                if (x >= 0 and x <= maxInput and y >= 0 and y <= maxOutput)
                 {
-                    // New target node represented as a pair (this-node,f-node)
-                    auto pTarget = make_shared<pair<shared_ptr<FsmNode>, shared_ptr<FsmNode>>>(tr->getTarget(), trOther->getTarget());
-                    
-                    // If the target node does not yet exist in the list
-                    // of state for the new FSM, then create it now
-                    shared_ptr<FsmNode> nTarget = findp(fsmInterNodes, pTarget);
-                    if (nTarget == nullptr)
+                    shared_ptr<FsmLabel>& cached = labels[x * (maxOutput + 1) + y];
+                    if (cached == nullptr)
                     {
-                        // Set the node name as pair of the individual node names
-                        string newNodeName("(" + tr->getTarget()->getName() +
-                                           "," +
-                                           trOther->getTarget()->getName() + ")");
-                        
-                        // Register node name in new presentation layer
-                        newPl->addState2String(newNodeName);
-                        
-                        nTarget = newNode(id++, pTarget, newPl);
-
-                        // Adding the trace that reaches the new state.
-                        shared_ptr<IOTrace> nSourceReachTrace = nSource->getReachTrace();
-                        shared_ptr<IOTrace> nTargetReachTrace = make_shared<IOTrace>(*tr->getLabel()->toIOTrace());
-                        nTargetReachTrace->prepend(*nSourceReachTrace);
-                        nTarget->setReachTrace(nTargetReachTrace);
-
-                        fsmInterNodes.push_back(nTarget);
+                        cached = make_shared<FsmLabel>(x, y, newPl);
                     }
-                    
-                    // Add transition from nSource to nTarget
-                    auto newTr = make_shared<FsmTransition>(nSource,
-                                                            nTarget,
-                                                            tr->getLabel());
+                    lbl = cached;
+                }
+                else
+                {
+                    lbl = make_shared<FsmLabel>(x, y, newPl);
+                }
+                
+                // If the target node does not yet exist in the list
+                // of state for the new FSM, then create it now.
+                // It is then also appended to the BFS list.
+                int myTarget = myCsr->getTarget(t);
+                int theirTarget = theirCsr->getTarget(tOther);
+                shared_ptr<FsmNode> nTarget = findPair(myTarget, theirTarget);
+                if (nTarget == nullptr)
+                {
+                    nTarget = createPair(myTarget, theirTarget);
 
-                    nSource->addTransition(newTr);
-                    
-                    /* Conditions for insertion of the target pair
-                       into the nodeList:
-                     1. the target node corresponding to the pair
-                        has not yet been processed
-                        (that is,  nTarget.hasBeenVisited() == false)
-                     2. The target pair is not already entered into the nodeList
-                     */
-                    if (not (nTarget->hasBeenVisited() or
-                             contains(nodeList, pTarget)))
-                    {
-                        nodeList.push_back(pTarget);
-                    }
+                    // Adding the trace that reaches the new state.
+                    shared_ptr<IOTrace> nSourceReachTrace = nSource->getReachTrace();
+                    shared_ptr<IOTrace> nTargetReachTrace = make_shared<IOTrace>(*lbl->toIOTrace());
+                    nTargetReachTrace->prepend(*nSourceReachTrace);
+                    nTarget->setReachTrace(nTargetReachTrace);
+                }
+                
+                // Add transition from nSource to nTarget
+                auto newTr = make_shared<FsmTransition>(nSource,
+                                                        nTarget,
+                                                        lbl);
+
+                nSource->addTransition(newTr);
+                
+                if (failureFound)
+                {
+                    break;
                 }
             }
         }
@@ -1116,49 +1437,53 @@ Fsm Fsm::intersect(const Fsm & f, string name)
 
 }
 
-shared_ptr<Tree> Fsm::getStateCover()
+shared_ptr<Tree> Fsm::getStateCover() const
 {
-    resetColor();
-    deque<shared_ptr<FsmNode>> bfsLst;
-    unordered_map<shared_ptr<FsmNode>, shared_ptr<TreeNode>> f2t;
+    return getStateCoverTrie().toTree();
+}
+
+shared_ptr<Tree> Fsm::getTransitionCover() const
+{
+    return getTransitionCoverTrie().toTree();
+}
+
+InputTrie Fsm::getStateCoverTrie() const
+{
+    shared_ptr<CsrTransitionTable> csr = getCsrTransitionTable();
+    deque<int> bfsLst;
+    vector<uint32_t> f2t(csr->size(), InputTrie::NIL);
     
-    shared_ptr<TreeNode> root = make_shared<TreeNode>();
-    shared_ptr<Tree> scov = make_shared<Tree>(root, presentationLayer);
+    InputTrie scov(maxInput, presentationLayer);
     
-    shared_ptr<FsmNode> initState = getInitialState();
-    initState->setColor(FsmNode::grey);
-    bfsLst.push_back(initState);
-    f2t[initState] = root;
+    // A state is reached when it has been associated with a tree node
+    bfsLst.push_back(initStateIdx);
+    f2t[initStateIdx] = scov.getRoot();
     
     while (!bfsLst.empty())
     {
-        shared_ptr<FsmNode> thisNode = bfsLst.front();
+        int thisNode = bfsLst.front();
         bfsLst.pop_front();
-        shared_ptr<TreeNode> currentTreeNode = f2t[thisNode];
+        uint32_t currentTreeNode = f2t[thisNode];
         
         for (int x = 0; x <= maxInput; ++x)
         {
-            for (shared_ptr<FsmNode> tgt : thisNode->after(x))
+            for (int t = csr->begin(thisNode, x); t < csr->end(thisNode, x); ++t)
             {
-                if (tgt->getColor() == FsmNode::white)
+                int tgt = csr->getTarget(t);
+                if (f2t[tgt] == InputTrie::NIL)
                 {
-                    tgt->setColor(FsmNode::grey);
-                    shared_ptr<TreeNode> itn = currentTreeNode->add(x);
+                    f2t[tgt] = scov.add(currentTreeNode, x);
                     bfsLst.push_back(tgt);
-                    f2t[tgt] = itn;
                 }
             }
         }
-        thisNode->setColor(FsmNode::black);
     }
-    resetColor();
     return scov;
 }
 
-shared_ptr<Tree> Fsm::getTransitionCover()
+InputTrie Fsm::getTransitionCoverTrie() const
 {
-    shared_ptr<Tree> scov = getStateCover();
-    resetColor();
+    InputTrie scov = getStateCoverTrie();
     
     shared_ptr<vector<vector<int>>> tlst = make_shared<vector<vector<int>>>();
     
@@ -1171,7 +1496,7 @@ shared_ptr<Tree> Fsm::getTransitionCover()
     
     IOListContainer tcl = IOListContainer(tlst, presentationLayer);
     
-    scov->add(tcl);
+    scov.add(tcl);
     
     return scov;
 }
@@ -1181,35 +1506,41 @@ OutputTree Fsm::apply(const InputTrace & itrc, bool markAsVisited)
     return getInitialState()->apply(itrc,markAsVisited);
 }
 
+OutputTree Fsm::apply(const InputTrace & itrc, vector<bool>& visited) const
+{
+    visited.resize(nodes.size(), false);
+    return getInitialState()->apply(itrc, visited);
+}
+
 void Fsm::apply(const InputTrace& input, vector<shared_ptr<OutputTrace>>& producedOutputs, vector<shared_ptr<FsmNode>>& reachedNodes) const
 {
-    TIMED_FUNC(timerObj);
+    TIMED_FUNC_IF(timerObj, VLOG_IS_ON(2));
     return getInitialState()->getPossibleOutputs(input, producedOutputs, reachedNodes);
 }
 
 Fsm Fsm::transformToObservableFSM(const string& nameSuffix) const
 {
+    // Compact view of the transition relation of this FSM
+    shared_ptr<CsrTransitionTable> csr = getCsrTransitionTable();
+    
+    const int numOutputs = maxOutput + 1;
+    
     // List to be filled with the new states to be created
-    // for the observable FSM
+    // for the observable FSM. The new states are processed
+    // in the order of their creation, so that nodeLst also
+    // serves as breadth first search queue: the nodes at positions
+    // head..nodeLst.size()-1 are still to be processed.
     vector<shared_ptr<FsmNode>> nodeLst;
+    size_t head = 0;
     
-    // Breadth first search list, containing the
-    // new FSM nodes, still to be processed by the algorithm
-    vector<shared_ptr<FsmNode>> bfsLst;
-    
-    // Map a newly created node to the set of nodes from the
-    // original FSM, comprised in the new FSM state
-    unordered_map<shared_ptr<FsmNode>, unordered_set<shared_ptr<FsmNode>>> node2NodeLabel;
+    // Map a set of nodes from the original FSM, given by their
+    // sorted state indices, to the new FSM state comprising them
+    unordered_map<vector<int>, int, SubsetHash> subset2Node;
     
-    // Set of nodes from the original FSM, comprised in the
-    // current new node
-    unordered_set<shared_ptr<FsmNode>> theNodeLabel;
-    
-    // For the first step of the algorithm, the initial
-    // state of the original FSM is the only state comprised
-    // in the initial state of the new FSM
-    theNodeLabel.insert(getInitialState());
-
+    // subsets[i] is the set of original states comprised in the new
+    // state i. The pointers refer to the keys of subset2Node, which
+    // remain valid when the map is rehashed.
+    vector<const vector<int>*> subsets;
     
     // Create a new presentation layer which has
     // the same names for the inputs and outputs as
@@ -1221,107 +1552,88 @@ Fsm Fsm::transformToObservableFSM(const string& nameSuffix) const
                                       presentationLayer->getOut2String(),
                                       obsState2String);
     
-    
-    // id to be taken for the next state of the new
-    // observable FSM to be created.
-    int id = 0;
+    // Return the new state comprising the given set of original
+    // states, create it if it does not exist yet
+    auto getNode = [&](vector<int>& theNodeLabel) -> shared_ptr<FsmNode>
+    {
+        auto it = subset2Node.find(theNodeLabel);
+        if (it != subset2Node.end())
+        {
+            return nodeLst[it->second];
+        }
+        
+        it = subset2Node.insert(make_pair(std::move(theNodeLabel),
+                                          static_cast<int>(nodeLst.size()))).first;
+        string nodeName = labelString(it->first, *csr);
+        nodeLst.push_back(make_shared<FsmNode>(it->second, nodeName, obsPl));
+        subsets.push_back(&it->first);
+        obsPl->addState2String(nodeName);
+        return nodeLst.back();
+    };
     
     // The initial state of the new FSM is labelled with
     // the set containing just the initial state of the old FSM
-    string nodeName = labelString(theNodeLabel);
-    shared_ptr<FsmNode> q0 = make_shared<FsmNode>(id++, nodeName, obsPl);
-    nodeLst.push_back(q0);
-    bfsLst.push_back(q0);
-    node2NodeLabel[q0] = theNodeLabel;
-    
-    // The node label is added to the presentation layer,
-    // as name of the initial state
-    obsPl->addState2String(nodeName);
-    
-    // Loop while there is at least one node in the BFS list.
-    // Initially, the list contains just the new initial state
-    // of the new FSM.
-    while (!bfsLst.empty())
+    vector<int> theNodeLabel;
+    theNodeLabel.push_back(csr->getIndex(getInitialState().get()));
+    getNode(theNodeLabel);
+    
+    // Pairs (label, target) of the outgoing transitions of all original
+    // states comprised by the node being processed, where the label
+    // x/y is encoded as x*(maxOutput+1)+y
+    vector<pair<int, int>> post;
+    
+    while (head < nodeLst.size())
     {
-        // Pop the first node from the list
-        shared_ptr<FsmNode> q = bfsLst.front();
-        bfsLst.erase(bfsLst.begin());
+        // Pop the first node from the queue
+        const size_t qIdx = head++;
+        shared_ptr<FsmNode> q = nodeLst[qIdx];
         
-        // Nested loop over all input/output labels that
-        // might be associated with one or more outgoing transitions
-        for (int x = 0; x <= maxInput; ++ x)
+        // Collect the transitions of all nodes of the original FSM
+        // which are comprised by q. Only labels that actually occur
+        // are considered.
+        post.clear();
+        for (int s : *subsets[qIdx])
         {
-            for (int y = 0; y <= maxOutput; ++ y)
+            for (int t = csr->begin(s); t < csr->end(s); ++t)
             {
-                // This is the transition label currently processed
-                shared_ptr<FsmLabel> lbl =
-                make_shared<FsmLabel>(x, y, obsPl);
-                
-                // Clear the set of node labels that may
-                // serve as node name for the target node to be
-                // created (or already exists). This target node
-                // comprises all nodes of the original FSM that
-                // can be reached from q under a transition labelled
-                // with lbl
-                theNodeLabel.clear();
-                
-                // Loop over all nodes of the original FSM which
-                // are comprised by q
-                for (shared_ptr<FsmNode> n : node2NodeLabel.at(q))
+                int x = csr->getInput(t);
+                int y = csr->getOutput(t);
+                if (x < 0 or x > maxInput or y < 0 or y > maxOutput)
                 {
-                    // For each node comprised by q, check
-                    // its outgoing transitions, whether they are
-                    // labelled by lbl
-                    for (auto tr : n->getTransitions())
-                    {
-                        if (*tr->getLabel() == *lbl)
-                        {
-                            // If so, insert the target node
-                            // into the node label set
-                            theNodeLabel.insert(tr->getTarget());
-                        }
-                    }
+                    continue;
                 }
-                
-                // Process only non-empty label sets.
-                // An empty label set means that no transition labelled
-                // by lbl exists.
-                if (!theNodeLabel.empty())
+                post.push_back(make_pair(x * numOutputs + y, csr->getTarget(t)));
+            }
+        }
+        
+        // Sorting groups the targets by label, in ascending order of
+        // x/y, and yields each target set in canonical sorted form
+        sort(post.begin(), post.end());
+        
+        for (size_t k = 0; k < post.size(); )
+        {
+            const int lblCode = post[k].first;
+            
+            // The target node comprises all nodes of the original FSM
+            // that can be reached from q under a transition labelled
+            // with x/y
+            theNodeLabel.clear();
+            for ( ; k < post.size() and post[k].first == lblCode; ++k)
+            {
+                if (theNodeLabel.empty() or theNodeLabel.back() != post[k].second)
                 {
-                    
-                    shared_ptr<FsmNode> tgtNode = nullptr;
-                    
-                    // Loop over the node-2-label map and check
-                    // if there exists already a node labelled
-                    // by theNodeLabel. If this is the case,
-                    // it will become the target node reached from q
-                    // under lbl
-                    for ( auto u : node2NodeLabel ) {
-                        
-                        if ( u.second == theNodeLabel ) {
-                            tgtNode = u.first;
-                            break;
-                        }
-                        
-                    }
-                    
-                    if (tgtNode == nullptr)
-                    {
-                        // We need to create a new target node, to be reached
-                        // from q under lbl
-                        nodeName = labelString(theNodeLabel);
-                        tgtNode = make_shared<FsmNode>(id++, nodeName, obsPl);
-                        nodeLst.push_back(tgtNode);
-                        bfsLst.push_back(tgtNode);
-                        node2NodeLabel[tgtNode] = theNodeLabel;
-                        obsPl->addState2String(nodeName);
-                    }
-                    
-                    // Create the transition from q to tgtNode
-                    auto trNew = make_shared<FsmTransition>(q, tgtNode, lbl);
-                    q->addTransition(trNew);
+                    theNodeLabel.push_back(post[k].second);
                 }
             }
+            
+            shared_ptr<FsmNode> tgtNode = getNode(theNodeLabel);
+            
+            // Create the transition from q to tgtNode
+            shared_ptr<FsmLabel> lbl = make_shared<FsmLabel>(lblCode / numOutputs,
+                                                             lblCode % numOutputs,
+                                                             obsPl);
+            auto trNew = make_shared<FsmTransition>(q, tgtNode, lbl);
+            q->addTransition(trNew);
         }
     }
     Fsm obsFsm(name + nameSuffix, maxInput, maxOutput, nodeLst, obsPl);
@@ -1331,14 +1643,7 @@ Fsm Fsm::transformToObservableFSM(const string& nameSuffix) const
 bool Fsm::isObservable() const
 {
     TIMED_FUNC(timerObj);
-    for (shared_ptr<FsmNode> node : nodes)
-    {
-        if (!node->isObservable())
-        {
-            return false;
-        }
-    }
-    return true;
+    return getCsrTransitionTable()->isObservable();
 }
 
 Minimal Fsm::isMinimal() const
@@ -1358,13 +1663,25 @@ void Fsm::calcOFSMTables() {
     // Create the initial OFSMTable representing the FSM,
     //  where all FSM states belong to the same class
     shared_ptr<OFSMTable> tbl = make_shared<OFSMTable>(nodes, maxInput, maxOutput, presentationLayer);
+    ofsmTableLst.push_back(tbl);
     
     // Create all possible OFSMTables, each new one from its
-    // predecessor, and add them to the ofsmTableLst
-    while (tbl != nullptr)
+    // predecessor, and add them to the ofsmTableLst. The classes
+    // are calculated by signature refinement, which yields the same
+    // tables as OFSMTable::next(), without comparing full table rows.
+    SignatureRefinement refinement(*getCsrTransitionTable());
+    S2CMap s2c = tbl->getS2C();
+    
+    // The second table distinguishes states by their sets of labels,
+    // it is always created
+    refinement.splitByLabels(s2c);
+    tbl = tbl->next(s2c);
+    ofsmTableLst.push_back(tbl);
+    
+    while (refinement.splitByPostClasses(s2c))
     {
+        tbl = tbl->next(s2c);
         ofsmTableLst.push_back(tbl);
-        tbl = tbl->next();
     }
 
 }
@@ -1537,72 +1854,65 @@ shared_ptr<FsmNode> Fsm::getNode(int id) const
 }
 
 void Fsm::calcROneDistinguishableStates()
+{
+    RDistinguishabilityTable tbl(getCsrTransitionTable());
+    calcROneDistinguishableStates(tbl, 1);
+}
+
+void Fsm::calcROneDistinguishableStates(RDistinguishabilityTable& tbl, const unsigned int numThreads)
 {
     for (size_t i = 0; i < nodes.size(); ++i)
     {
         nodes.at(i)->getRDistinguishability()->initRDistinguishable(1);
-        for (size_t j = i + 1; j < nodes.size(); ++j)
-        {
-            nodes.at(i)->getRDistinguishability()->addNotRDistinguishable(1, nodes.at(j));
-        }
     }
-    nodes.at(nodes.size() - 1)->getRDistinguishability()->addNotRDistinguishable(1);
 
-    for (size_t k = 0; k < nodes.size(); ++k)
+    shared_ptr<CsrTransitionTable> csr = getCsrTransitionTable();
+    for (const RDistinguishabilityTable::Entry& e : tbl.calcFirstLevel(numThreads))
     {
-        shared_ptr<FsmNode> q1 = nodes.at(k);
-        vector<int> notROneDist = q1->getRDistinguishability()->getNotRDistinguishableWith(1);
+        shared_ptr<FsmNode> q1 = nodes.at(e.q1);
+        shared_ptr<FsmNode> q2 = nodes.at(e.q2);
+        shared_ptr<AdaptiveTreeNode> q1Root = make_shared<AdaptiveTreeNode>(e.x);
+        shared_ptr<AdaptiveTreeNode> q2Root = make_shared<AdaptiveTreeNode>(e.x);
 
-        for (auto it = notROneDist.begin(); it != notROneDist.end(); ++it)
+        for (int t = csr->begin(e.q1, e.x); t < csr->end(e.q1, e.x); ++t)
         {
-            int q2Id = *it;
-            for (int x = 0; x <= maxInput; ++ x)
-            {
-                InputTrace input = InputTrace(vector<int>({x}), presentationLayer);
-                shared_ptr<FsmNode> q2 = getNode(q2Id);
-                vector<shared_ptr<OutputTrace>> intersection = getOutputIntersection(q1, q2, x);
-                if (intersection.size() == 0)
-                {
-                    vector<shared_ptr<OutputTrace>> q1Output;
-                    vector<shared_ptr<OutputTrace>> q2Output;
-                    q1->getPossibleOutputs(x, q1Output);
-                    q2->getPossibleOutputs(x, q2Output);
-                    shared_ptr<AdaptiveTreeNode> q1Root = make_shared<AdaptiveTreeNode>(x);
-                    shared_ptr<AdaptiveTreeNode> q2Root = make_shared<AdaptiveTreeNode>(x);
-
-                    for (shared_ptr<OutputTrace> trace : q1Output)
-                    {
-                        shared_ptr<AdaptiveTreeNode> target = make_shared<AdaptiveTreeNode>();
-                        shared_ptr<TreeEdge> edge = make_shared<TreeEdge>(trace->get()[0], target);
-                        q1Root->add(edge);
-                    }
-                    for (shared_ptr<OutputTrace> trace : q2Output)
-                    {
-                        shared_ptr<AdaptiveTreeNode> target = make_shared<AdaptiveTreeNode>();
-                        shared_ptr<TreeEdge> edge = make_shared<TreeEdge>(trace->get()[0], target);
-                        q2Root->add(edge);
-                    }
+            shared_ptr<AdaptiveTreeNode> target = make_shared<AdaptiveTreeNode>();
+            q1Root->add(make_shared<TreeEdge>(csr->getOutput(t), target));
+        }
+        for (int t = csr->begin(e.q2, e.x); t < csr->end(e.q2, e.x); ++t)
+        {
+            shared_ptr<AdaptiveTreeNode> target = make_shared<AdaptiveTreeNode>();
+            q2Root->add(make_shared<TreeEdge>(csr->getOutput(t), target));
+        }
 
-                    shared_ptr<InputOutputTree> q1Tree = make_shared<InputOutputTree>(q1Root, presentationLayer);
-                    shared_ptr<InputOutputTree> q2Tree = make_shared<InputOutputTree>(q2Root, presentationLayer);
-                    q1->getRDistinguishability()->addAdaptiveIOSequence(q2, q1Tree);
-                    q2->getRDistinguishability()->addAdaptiveIOSequence(q1, q2Tree);
+        shared_ptr<InputOutputTree> q1Tree = make_shared<InputOutputTree>(q1Root, presentationLayer);
+        shared_ptr<InputOutputTree> q2Tree = make_shared<InputOutputTree>(q2Root, presentationLayer);
+        q1->getRDistinguishability()->addAdaptiveIOSequence(q2, q1Tree);
+        q2->getRDistinguishability()->addAdaptiveIOSequence(q1, q2Tree);
 
-                    q1->getRDistinguishability()->addRDistinguishable(1, q2);
-                    q2->getRDistinguishability()->addRDistinguishable(1, q1);
+        q1->getRDistinguishability()->addRDistinguishable(1, q2);
+        q2->getRDistinguishability()->addRDistinguishable(1, q1);
+    }
 
-                    q1->getRDistinguishability()->removeNotRDistinguishable(1, q2);
-                    break;
-                }
+    // Every state keeps the states with a higher index that are not r(1)-distinguishable.
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        nodes.at(i)->getRDistinguishability()->addNotRDistinguishable(1);
+        for (size_t j = i + 1; j < nodes.size(); ++j)
+        {
+            if (!tbl.isDistinguished(static_cast<int>(i), static_cast<int>(j)))
+            {
+                nodes.at(i)->getRDistinguishability()->addNotRDistinguishable(1, nodes.at(j));
             }
         }
     }
 
-    for (size_t i = 0; i < nodes.size(); ++i)
+    if (VLOG_IS_ON(2))
     {
-        for (size_t j = 0; j < nodes.size(); ++j)
+        for (size_t i = 0; i < nodes.size(); ++i)
         {
-            try {
+            for (size_t j = 0; j < nodes.size(); ++j)
+            {
                 shared_ptr<InputOutputTree> tree = nodes.at(i)->getRDistinguishability()->getAdaptiveIOSequence(nodes.at(j));
                 if (tree->getRoot()->isLeaf())
                 {
@@ -1611,20 +1921,18 @@ void Fsm::calcROneDistinguishableStates()
                 std::stringstream ss;
                 ss << "σ(" << nodes.at(i)->getName() << "," << nodes.at(j)->getName() << ") = " << *tree;
                 VLOG(2) << ss.str();
-            } catch (std::out_of_range e) {
-               // Do nothing.
             }
-
         }
-
     }
 }
 
-void Fsm::calcRDistinguishableStates()
+void Fsm::calcRDistinguishableStates(const unsigned int numThreads)
 {
     TIMED_FUNC(timerObj);
     VLOG(2) << "calcRDistinguishableStates():";
-    calcROneDistinguishableStates();
+    shared_ptr<CsrTransitionTable> csr = getCsrTransitionTable();
+    RDistinguishabilityTable tbl(csr);
+    calcROneDistinguishableStates(tbl, numThreads);
 
     size_t limit = nodes.size() * (nodes.size() - 1) / 2;
     bool allRDistinguishable = false;
@@ -1634,154 +1942,87 @@ void Fsm::calcRDistinguishableStates()
     {
         maxL = l;
         VLOG(2) << "################ l = " << l << " (max " << limit << ") ################";
-        allRDistinguishable = true;
-        newDistinguishabilityCalculated = false;
         for (size_t k = 0; k < nodes.size(); ++k)
         {
             nodes.at(k)->getRDistinguishability()->inheritDistinguishability(l);
         }
-        for (size_t k = 0; k < nodes.size(); ++k)
+        // If there are still nodes that can not be r-distinguished from each other, do one more iteration.
+        allRDistinguishable = tbl.allDistinguished();
+
+        // Only pairs whose successor pairs became r(l-1)-distinguishable are examined.
+        vector<RDistinguishabilityTable::Entry> newPairs = tbl.calcNextLevel(numThreads);
+        newDistinguishabilityCalculated = !newPairs.empty();
+
+        for (const RDistinguishabilityTable::Entry& e : newPairs)
         {
-            shared_ptr<FsmNode> q1 = nodes.at(k);
-            VLOG(3) << "q1 = " << q1->getName() << ":";
-            vector<int> notROneDist = q1->getRDistinguishability()->getNotRDistinguishableWith(l);
-            for (auto it = notROneDist.begin(); it != notROneDist.end(); ++it)
+            shared_ptr<FsmNode> q1 = nodes.at(e.q1);
+            shared_ptr<FsmNode> q2 = nodes.at(e.q2);
+            shared_ptr<AdaptiveTreeNode> q1Root = make_shared<AdaptiveTreeNode>(e.x);
+            shared_ptr<AdaptiveTreeNode> q2Root = make_shared<AdaptiveTreeNode>(e.x);
+
+            // Outputs shared by q1 and q2 lead to r(l-1)-distinguishable states.
+            vector<int> intersection;
+            for (int t1 = csr->begin(e.q1, e.x); t1 < csr->end(e.q1, e.x); ++t1)
             {
-                // There are still nodes that can not be r-distuinguisehd from each other. Do one more iteration.
-                allRDistinguishable = false;
-                int q2Id = *it;
-                shared_ptr<FsmNode> q2 = getNode(q2Id);
-                VLOG(3) << "  q2 = " << q2->getName() << ":";
-                for (int x = 0; x <= maxInput; ++ x)
+                for (int t2 = csr->begin(e.q2, e.x); t2 < csr->end(e.q2, e.x); ++t2)
                 {
-                    vector<shared_ptr<OutputTrace>> intersection = getOutputIntersection(q1, q2, x);
-
-                    shared_ptr<AdaptiveTreeNode> q1Root = make_shared<AdaptiveTreeNode>(x);
-                    shared_ptr<AdaptiveTreeNode> q2Root = make_shared<AdaptiveTreeNode>(x);
-                    vector<shared_ptr<TreeEdge>> q1Edges;
-                    vector<shared_ptr<TreeEdge>> q2Edges;
-
-                    bool isDistinguishable = true;
-                    for (shared_ptr<OutputTrace> inter : intersection)
+                    int y = csr->getOutput(t1);
+                    if (y != csr->getOutput(t2))
                     {
-                        int y = inter->get()[0];
-                        unordered_set<shared_ptr<FsmNode>> afterQ1 = q1->afterAsSet(x, y);
-                        unordered_set<shared_ptr<FsmNode>> afterQ2 = q2->afterAsSet(x, y);
-                        shared_ptr<FsmNode> afterNode1 = *afterQ1.begin();
-                        shared_ptr<FsmNode> afterNode2 = *afterQ2.begin();
-                        if (afterNode1 == afterNode2 || !afterNode1->getRDistinguishability()->isRDistinguishableWith(l - 1, afterNode2))
-                        {
-
-                            isDistinguishable = false;
-                            break;
-                        }
-                        else
-                        {
-                            VLOG(3) << "    x = " << presentationLayer->getInId(x) << ":    "
-                            << afterNode1->getName() << " != " << afterNode2->getName()
-                            << "  ->  " << q1->getName() << " != " << q2->getName();
-
-                            //shared_ptr<TreeNode> target1 = make_shared<TreeNode>();
-                            shared_ptr<InputOutputTree> childTree1 = afterNode1->getRDistinguishability()->getAdaptiveIOSequence(afterNode2);
-                            // TODO Fix
-                            //      can't find linker symbol for virtual table for `TreeEdge' value
-                            // messages when debugging.
-                            // Put breakpoint at following line and debug.
-                            stringstream ss;
-                            ss << "      childIO1(" << afterNode1->getName() << "," << afterNode2->getName() << "): " << *childTree1;
-                            VLOG(3) << ss.str();
-                            ss.str(std::string());
-
-                            shared_ptr<AdaptiveTreeNode> childNode1 = static_pointer_cast<AdaptiveTreeNode>(childTree1->getRoot());
-                            shared_ptr<TreeEdge> edge1 = make_shared<TreeEdge>(y, childNode1);
-                            q1Edges.push_back(edge1);
-
-                            //shared_ptr<TreeNode> target2 = make_shared<TreeNode>();
-                            shared_ptr<InputOutputTree> childTree2 = afterNode2->getRDistinguishability()->getAdaptiveIOSequence(afterNode1);
-                            ss << "      childIO2(" << afterNode2->getName() << "," << afterNode1->getName() << "): " << *childTree2 << endl;
-                            VLOG(3) << ss.str();
-                            shared_ptr<AdaptiveTreeNode> childNode2 = static_pointer_cast<AdaptiveTreeNode>(childTree2->getRoot());
-                            shared_ptr<TreeEdge> edge2 = make_shared<TreeEdge>(y, childNode2);
-                            q2Edges.push_back(edge2);
-                        }
+                        continue;
                     }
-                    if (isDistinguishable)
-                    {
-                        for (shared_ptr<TreeEdge> edge : q1Edges)
-                        {
-                            q1Root->add(edge);
-                        }
-                        for (shared_ptr<TreeEdge> edge : q2Edges)
-                        {
-                            q2Root->add(edge);
-                        }
-                        vector<shared_ptr<OutputTrace>> q1Outputs;
-                        vector<shared_ptr<OutputTrace>> q2Outputs;
-                        q1->getPossibleOutputs(x, q1Outputs);
-                        q2->getPossibleOutputs(x, q2Outputs);
-
-                        for (auto it = q1Outputs.begin(); it != q1Outputs.end(); ++it)
-                        {
-                            bool disjunct = true;
-                            for (shared_ptr<OutputTrace> inter : intersection)
-                            {
-                                if (**it == *inter)
-                                {
-                                    disjunct = false;
-                                    break;
-                                }
-                            }
-                            if (disjunct)
-                            {
-                                shared_ptr<AdaptiveTreeNode> target = make_shared<AdaptiveTreeNode>();
-                                shared_ptr<TreeEdge> edge = make_shared<TreeEdge>((*it)->get()[0], target);
-                                q1Root->add(edge);
-                            }
-                        }
-
-                        for (auto it = q2Outputs.begin(); it != q2Outputs.end(); ++it)
-                        {
-                            bool disjunct = true;
-                            for (shared_ptr<OutputTrace> inter : intersection)
-                            {
-                                if (**it == *inter)
-                                {
-                                    disjunct = false;
-                                    break;
-                                }
-                            }
-                            if (disjunct)
-                            {
-                                shared_ptr<AdaptiveTreeNode> target = make_shared<AdaptiveTreeNode>();
-                                shared_ptr<TreeEdge> edge = make_shared<TreeEdge>((*it)->get()[0], target);
-                                q2Root->add(edge);
-                            }
-                        }
-
-                        //InputTrace input = InputTrace(vector<int>({x}), presentationLayer);
-                        shared_ptr<InputOutputTree> q1Tree = make_shared<InputOutputTree>(q1Root, presentationLayer);
-                        shared_ptr<InputOutputTree> q2Tree = make_shared<InputOutputTree>(q2Root, presentationLayer);
+                    intersection.push_back(y);
+                    shared_ptr<FsmNode> afterNode1 = csr->getNode(csr->getTarget(t1));
+                    shared_ptr<FsmNode> afterNode2 = csr->getNode(csr->getTarget(t2));
+                    VLOG(3) << "    x = " << presentationLayer->getInId(e.x) << ":    "
+                    << afterNode1->getName() << " != " << afterNode2->getName()
+                    << "  ->  " << q1->getName() << " != " << q2->getName();
+
+                    shared_ptr<InputOutputTree> childTree1 = afterNode1->getRDistinguishability()->getAdaptiveIOSequence(afterNode2);
+                    shared_ptr<AdaptiveTreeNode> childNode1 = static_pointer_cast<AdaptiveTreeNode>(childTree1->getRoot());
+                    q1Root->add(make_shared<TreeEdge>(y, childNode1));
+
+                    shared_ptr<InputOutputTree> childTree2 = afterNode2->getRDistinguishability()->getAdaptiveIOSequence(afterNode1);
+                    shared_ptr<AdaptiveTreeNode> childNode2 = static_pointer_cast<AdaptiveTreeNode>(childTree2->getRoot());
+                    q2Root->add(make_shared<TreeEdge>(y, childNode2));
+                }
+            }
 
-                        stringstream ss;
-                        ss << "    q1Tree: " << *q1Tree;
-                        VLOG(2) << ss.str();
-                        ss.str(std::string());
-                        ss << "    q2Tree: " << *q2Tree;
-                        VLOG(2) << ss.str();
+            // Outputs produced by only one of the states end the tree.
+            for (int t = csr->begin(e.q1, e.x); t < csr->end(e.q1, e.x); ++t)
+            {
+                if (find(intersection.begin(), intersection.end(), csr->getOutput(t)) == intersection.end())
+                {
+                    shared_ptr<AdaptiveTreeNode> target = make_shared<AdaptiveTreeNode>();
+                    q1Root->add(make_shared<TreeEdge>(csr->getOutput(t), target));
+                }
+            }
+            for (int t = csr->begin(e.q2, e.x); t < csr->end(e.q2, e.x); ++t)
+            {
+                if (find(intersection.begin(), intersection.end(), csr->getOutput(t)) == intersection.end())
+                {
+                    shared_ptr<AdaptiveTreeNode> target = make_shared<AdaptiveTreeNode>();
+                    q2Root->add(make_shared<TreeEdge>(csr->getOutput(t), target));
+                }
+            }
 
-                        q1->getRDistinguishability()->addAdaptiveIOSequence(q2, q1Tree);
-                        q2->getRDistinguishability()->addAdaptiveIOSequence(q1, q2Tree);
+            shared_ptr<InputOutputTree> q1Tree = make_shared<InputOutputTree>(q1Root, presentationLayer);
+            shared_ptr<InputOutputTree> q2Tree = make_shared<InputOutputTree>(q2Root, presentationLayer);
+            if (VLOG_IS_ON(2))
+            {
+                stringstream ss;
+                ss << "    q1Tree: " << *q1Tree;
+                VLOG(2) << ss.str();
+                ss.str(std::string());
+                ss << "    q2Tree: " << *q2Tree;
+                VLOG(2) << ss.str();
+            }
 
+            q1->getRDistinguishability()->addAdaptiveIOSequence(q2, q1Tree);
+            q2->getRDistinguishability()->addAdaptiveIOSequence(q1, q2Tree);
 
-                        q1->getRDistinguishability()->addRDistinguishable(l, q2);
-                        q2->getRDistinguishability()->addRDistinguishable(l, q1);
-                        q1->getRDistinguishability()->removeNotRDistinguishable(l, q2);
-                        q2->getRDistinguishability()->removeNotRDistinguishable(l, q1);
-                        newDistinguishabilityCalculated = true;
-                        break;
-                    }
-                }
-            }
+            q1->getRDistinguishability()->addRDistinguishable(l, q2);
+            q2->getRDistinguishability()->addRDistinguishable(l, q1);
         }
     }
     // Deducing non-r-distinguishability from r-distinguishability.
@@ -1790,10 +2031,9 @@ void Fsm::calcRDistinguishableStates()
         for (size_t l = 1; l <= maxL; ++l)
         {
             node->getRDistinguishability()->addNotRDistinguishable(l);
-            vector<int> dist = node->getRDistinguishability()->getRDistinguishableWith(l);
             for (auto n : nodes)
             {
-                if(node != n && find(dist.begin(), dist.end(), n->getId()) == dist.end()) {
+                if (node != n && !node->getRDistinguishability()->isRDistinguishableWith(l, n)) {
                     node->getRDistinguishability()->addNotRDistinguishable(l, n);
                 }
             }
@@ -2039,6 +2279,84 @@ bool Fsm::hasFailure() const
     return false;
 }
 
+bool Fsm::isReduction(const Fsm& spec, const Fsm& iut, shared_ptr<IOTrace>& failTrace)
+{
+    failTrace = nullptr;
+    
+    shared_ptr<CsrTransitionTable> specCsr = spec.getCsrTransitionTable();
+    shared_ptr<CsrTransitionTable> iutCsr = iut.getCsrTransitionTable();
+    const size_t iutSize = static_cast<size_t>(iutCsr->size());
+    
+    // Visited pairs (s1,s2) of spec and iut state indices,
+    // keyed by s1*|S2|+s2
+    unordered_set<size_t> visited;
+    
+    // The pairs in BFS order; the pairs at positions head..pairs.size()-1
+    // are still to be processed. For each pair, the index of its
+    // predecessor and the label x/y leading to it are recorded, so that
+    // traces can be reconstructed.
+    vector<pair<int, int>> pairs;
+    vector<int> pred;
+    vector<pair<int, int>> predLabel;
+    size_t head = 0;
+    
+    auto addPair = [&](const int s1, const int s2, const int p, const int x, const int y)
+    {
+        if (visited.insert(static_cast<size_t>(s1) * iutSize + s2).second)
+        {
+            pairs.push_back(make_pair(s1, s2));
+            pred.push_back(p);
+            predLabel.push_back(make_pair(x, y));
+        }
+    };
+    
+    addPair(specCsr->getIndex(spec.getInitialState().get()),
+            iutCsr->getIndex(iut.getInitialState().get()),
+            -1, 0, 0);
+    
+    while (head < pairs.size())
+    {
+        const int p = static_cast<int>(head++);
+        const int s1 = pairs[p].first;
+        const int s2 = pairs[p].second;
+        
+        for (int t2 = iutCsr->begin(s2); t2 < iutCsr->end(s2); ++t2)
+        {
+            const int x = iutCsr->getInput(t2);
+            const int y = iutCsr->getOutput(t2);
+            
+            bool foundTransition = false;
+            for (int t1 = specCsr->begin(s1, x); t1 < specCsr->end(s1, x); ++t1)
+            {
+                if (specCsr->getOutput(t1) == y)
+                {
+                    foundTransition = true;
+                    addPair(specCsr->getTarget(t1), iutCsr->getTarget(t2), p, x, y);
+                }
+            }
+            
+            if (not foundTransition)
+            {
+                // Pairs are processed in BFS order, so that the trace
+                // reaching pair p, extended by x/y, is a shortest failure
+                vector<int> inputs(1, x);
+                vector<int> outputs(1, y);
+                for (int q = p; pred[q] >= 0; q = pred[q])
+                {
+                    inputs.push_back(predLabel[q].first);
+                    outputs.push_back(predLabel[q].second);
+                }
+                reverse(inputs.begin(), inputs.end());
+                reverse(outputs.begin(), outputs.end());
+                failTrace = make_shared<IOTrace>(InputTrace(inputs, iut.presentationLayer),
+                                                 OutputTrace(outputs, iut.presentationLayer));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 IOTraceContainer Fsm::bOmega(const IOTreeContainer& adaptiveTestCases, const IOTrace& trace) const
 {
     TIMED_FUNC_IF(timerObj, VLOG_IS_ON(7));
@@ -2280,7 +2598,8 @@ size_t Fsm::lowerBound(const IOTrace& base,
 bool Fsm::adaptiveStateCounting(Fsm& spec, Fsm& iut, const size_t m,
                                 IOTraceContainer& observedTraces,
                                 shared_ptr<IOTrace>& failTrace,
-                                int& iterations)
+                                int& iterations,
+                                const unsigned int numThreads)
 {
     VLOG(1)<< "adaptiveStateCounting()";
     if (spec.isMinimal() != True)
@@ -2296,7 +2615,7 @@ bool Fsm::adaptiveStateCounting(Fsm& spec, Fsm& iut, const size_t m,
     const string dotPrefix = "../../../resources/adaptive-test/" + spec.getName() + "-";
 
 #endif
-    spec.calcRDistinguishableStates();
+    spec.calcRDistinguishableStates(numThreads);
     IOListContainer rCharacterisationSet = spec.getRCharacterisationSet();
     VLOG(1) << "Spec rCharacterisationSet:" << rCharacterisationSet;
 
@@ -2356,6 +2675,33 @@ bool Fsm::adaptiveStateCounting(Fsm& spec, Fsm& iut, const size_t m,
      * do not meet the termination criterion.
      */
     InputTraceSet tC = detStateCover;
+
+    const unsigned int nThreads = numWorkerThreads(numThreads);
+
+    /**
+     * Results of applying an element of T_c, merged in the order of T_c.
+     */
+    struct TCElementResult {
+        vector<shared_ptr<OutputTrace>> producedOutputs;
+        vector<shared_ptr<const IOTrace>> observedTraces;
+        vector<IOTraceContainer> observedAdaptiveTraces;
+        shared_ptr<IOTrace> failTrace;
+    };
+
+    /* Run task(idx, worker) for idx = 0..n-1 on nThreads workers. Once stopAt
+     has been lowered, the elements behind it are no longer started. */
+    auto runTCTasks = [nThreads](const size_t n, atomic<size_t>& stopAt,
+                                 const function<void(size_t, unsigned int)>& task)
+    {
+        parallelFor(n, nThreads, [&](const size_t idx, const unsigned int w)
+        {
+            if (idx <= stopAt.load())
+            {
+                task(idx, w);
+            }
+        });
+    };
+
     iterations = 0;
     while (tC.size() != 0)
     {
@@ -2379,22 +2725,28 @@ bool Fsm::adaptiveStateCounting(Fsm& spec, Fsm& iut, const size_t m,
 #endif
         VLOG(1) << "adaptiveTestCases as input traces:";
         VLOG(1) << adaptiveList;
-        map<shared_ptr<InputTrace>, vector<shared_ptr<OutputTrace>>> observedOutputsTCElements;
-        size_t numberInputTraces = tC.size();
-        size_t inputTraceCount = 0;
+        // The elements of T_c in the order in which their results are merged.
+        const vector<shared_ptr<InputTrace>> tCElements(tC.begin(), tC.end());
+        const size_t numberInputTraces = tCElements.size();
+        vector<TCElementResult> results(numberInputTraces);
+        atomic<size_t> failedAt(numberInputTraces);
+
         // Applying all input traces from T_c to this FSM.
         // All observed outputs are bein recorded.
         // If the FSM observes a failure, adaptive state counting terminates.
-        for (const shared_ptr<InputTrace>& inputTrace : tC)
+        auto applyInputTrace = [&](const size_t idx) -> bool
         {
-            TIMED_SCOPE(timerBlkObj, "apply inputTrace");
+            const shared_ptr<InputTrace>& inputTrace = tCElements.at(idx);
+            TCElementResult& res = results.at(idx);
+            stringstream ss;
+            TIMED_SCOPE_IF(timerBlkObj, "apply inputTrace", VLOG_IS_ON(1));
             VLOG(1) << "############################################################";
-            VLOG(1) << "  Applying inputTrace " << ++inputTraceCount << " of " << numberInputTraces << ": " << *inputTrace;
+            VLOG(1) << "  Applying inputTrace " << idx + 1 << " of " << numberInputTraces << ": " << *inputTrace;
             /**
              * Hold the produced output traces for the current input trace.
              */
             vector<shared_ptr<OutputTrace>> producedOutputsSpec;
-            vector<shared_ptr<OutputTrace>> producedOutputsIut;
+            vector<shared_ptr<OutputTrace>>& producedOutputsIut = res.producedOutputs;
             /**
              * Hold the reached nodes for the current input trace.
              */
@@ -2449,11 +2801,9 @@ bool Fsm::adaptiveStateCounting(Fsm& spec, Fsm& iut, const size_t m,
             VLOG(1) << ss.str();
             ss.str(std::string());
 #endif
-            observedOutputsTCElements.insert(make_pair(inputTrace, producedOutputsIut));
-
             for (const shared_ptr<OutputTrace>& oTrace : producedOutputsIut)
             {
-                observedTraces.add(make_shared<const IOTrace>(*inputTrace, *oTrace));
+                res.observedTraces.push_back(make_shared<const IOTrace>(*inputTrace, *oTrace));
             }
 
             VLOG(1) << "Checking produced outputs for failures";
@@ -2492,10 +2842,10 @@ bool Fsm::adaptiveStateCounting(Fsm& spec, Fsm& iut, const size_t m,
                                 if (!observedAdaptiveTracesSpec.contains(trace))
                                 {
                                     LOG(INFO) << "  Specification does not contain " << *trace;
-                                    failTrace = make_shared<IOTrace>(*inputTrace, *outIut);
+                                    res.failTrace = make_shared<IOTrace>(*inputTrace, *outIut);
                                     IOTrace traceCopy = IOTrace(*trace);
-                                    failTrace->append(traceCopy);
-                                    LOG(INFO) << "failTrace: " << *failTrace;
+                                    res.failTrace->append(traceCopy);
+                                    LOG(INFO) << "failTrace: " << *res.failTrace;
                                     failure = true;
                                     break;
                                 }
@@ -2504,7 +2854,7 @@ bool Fsm::adaptiveStateCounting(Fsm& spec, Fsm& iut, const size_t m,
                             VLOG(1) << "  concatenating: " << *inputTrace << "/" << *outIut;
                             observedAdaptiveTracesIut.concatenateToFront(inputTrace, outIut);
                             VLOG(1) << "  observedAdaptiveTraces after concatenation to front: " << observedAdaptiveTracesIut;
-                            observedTraces.add(observedAdaptiveTracesIut);
+                            res.observedAdaptiveTraces.push_back(observedAdaptiveTracesIut);
                             if (failure)
                             {
                                 // IUT produced an output that can not be produced by the specification.
@@ -2561,8 +2911,8 @@ bool Fsm::adaptiveStateCounting(Fsm& spec, Fsm& iut, const size_t m,
 #endif
                     VLOG(1) << "Specification does not produce output " << *outIut << ".";
                     VLOG(1) << "IUT is not a reduction of the specification.";
-                    failTrace = make_shared<IOTrace>(*inputTrace, *outIut);
-                    LOG(INFO) << "failTrace: " << *failTrace;
+                    res.failTrace = make_shared<IOTrace>(*inputTrace, *outIut);
+                    LOG(INFO) << "failTrace: " << *res.failTrace;
                     return false;
                 }
             }
@@ -2572,14 +2922,43 @@ bool Fsm::adaptiveStateCounting(Fsm& spec, Fsm& iut, const size_t m,
                 cerr << "Number of produced outputs and number of reached nodes do not match.";
                 exit(EXIT_FAILURE);
             }
+            return true;
+        };
+
+        runTCTasks(numberInputTraces, failedAt, [&](const size_t idx, const unsigned int)
+        {
+            if (!applyInputTrace(idx))
+            {
+                // Elements behind the first failing one are not needed any more.
+                size_t current = failedAt.load();
+                while (idx < current && !failedAt.compare_exchange_weak(current, idx)) { }
+            }
+        });
+
+        // Merging the observed traces in the order of T_c, up to the first failure.
+        for (size_t idx = 0; idx < numberInputTraces && idx <= failedAt.load(); ++idx)
+        {
+            for (const shared_ptr<const IOTrace>& trace : results.at(idx).observedTraces)
+            {
+                observedTraces.add(trace);
+            }
+            for (const IOTraceContainer& traces : results.at(idx).observedAdaptiveTraces)
+            {
+                observedTraces.add(traces);
+            }
+        }
+        if (failedAt.load() < numberInputTraces)
+        {
+            failTrace = results.at(failedAt.load()).failTrace;
+            return false;
         }
 
         long numberToCheck = 0;
         VLOG(1) << "observedOutputsTCElements:";
-        for (auto e : observedOutputsTCElements)
+        for (size_t idx = 0; idx < numberInputTraces; ++idx)
         {
-            VLOG(1) << "  " << *e.first << ":";
-            for (auto o : e.second)
+            VLOG(1) << "  " << *tCElements.at(idx) << ":";
+            for (auto o : results.at(idx).producedOutputs)
             {
                 VLOG(1) << "    " << *o;
                 ++numberToCheck;
@@ -2588,13 +2967,14 @@ bool Fsm::adaptiveStateCounting(Fsm& spec, Fsm& iut, const size_t m,
         VLOG(1) << "Number of input/output combinations: " << numberToCheck;
         InputTraceSet newT = t;
         InputTraceSet newTC;
-        inputTraceCount = 0;
-        for (shared_ptr<InputTrace> inputTrace : tC)
+
+        auto meetsCriteria = [&](const size_t idx, VPrimeLazy& vPrimeLazy) -> bool
         {
+            const shared_ptr<InputTrace>& inputTrace = tCElements.at(idx);
             bool inputTraceMeetsCriteria = true;
-            TIMED_SCOPE(timerBlkObj, "Check input trace");
-            LOG(INFO) << "check inputTrace: " << *inputTrace << " (" << ++inputTraceCount << " of " << numberInputTraces << ")";
-            vector<shared_ptr<OutputTrace>>& producedOutputs = observedOutputsTCElements.at(inputTrace);
+            TIMED_SCOPE_IF(timerBlkObj, "Check input trace", VLOG_IS_ON(1));
+            LOG(INFO) << "check inputTrace: " << *inputTrace << " (" << idx + 1 << " of " << numberInputTraces << ")";
+            const vector<shared_ptr<OutputTrace>>& producedOutputs = results.at(idx).producedOutputs;
             VLOG(1) << "producedOutputs:";
             for (shared_ptr<OutputTrace> outputTrace : producedOutputs)
             {
@@ -2682,14 +3062,26 @@ bool Fsm::adaptiveStateCounting(Fsm& spec, Fsm& iut, const size_t m,
                     inputTraceMeetsCriteria = false;
                 }
             }
+            return inputTraceMeetsCriteria;
+        };
+
+        // Every worker owns a copy of V', since it is being iterated.
+        vector<VPrimeLazy> vPrimeLazies(nThreads, vPrimeLazy);
+        vector<char> meetsCriteriaResults(numberInputTraces, 0);
+        atomic<size_t> noStop(numberInputTraces);
+        runTCTasks(numberInputTraces, noStop, [&](const size_t idx, const unsigned int worker)
+        {
+            meetsCriteriaResults[idx] = meetsCriteria(idx, vPrimeLazies.at(worker));
+        });
 
-            if (!inputTraceMeetsCriteria)
+        for (size_t idx = 0; idx < numberInputTraces; ++idx)
+        {
+            const shared_ptr<InputTrace>& inputTrace = tCElements.at(idx);
+            if (!meetsCriteriaResults.at(idx))
             {
                 // Keeping current input trace in T_C
                 VLOG(1) << "Keeping " << *inputTrace << " in T_C.";
                 newTC.insert(inputTrace);
-                // Next input trace.
-                continue;
             }
             else
             {
@@ -3171,7 +3563,8 @@ void Fsm::appendStateIdentificationSets(const shared_ptr<Tree>& Wp2) const
         
         /*Which are the target nodes reachable via input trace lli
          in this FSM?*/
-        unordered_set<shared_ptr<FsmNode>> tgtNodes = getInitialState()->after(itrc);
+        vector<shared_ptr<FsmNode>> tgtNodes =
+            sortById(getInitialState()->after(itrc));
         
         for (shared_ptr<FsmNode> n : tgtNodes)
         {
@@ -3187,62 +3580,99 @@ void Fsm::appendStateIdentificationSets(const shared_ptr<Tree>& Wp2) const
     }
 }
 
+void Fsm::appendStateIdentificationSets(InputTrie& Wp2) const
+{
+    IOListContainer cnt = Wp2.getIOLists();
+    
+    /*The I/O lists of each state identification set are needed
+     once per maximal trace reaching the state, so they are
+     extracted only once*/
+    vector<shared_ptr<IOListContainer>> wLsts(stateIdentificationSets.size());
+    
+    for (const vector<int>& lli : *cnt.getIOLists())
+    {
+        InputTrace itrc = InputTrace(lli, presentationLayer);
+        
+        /*Which are the target nodes reachable via input trace lli
+         in this FSM?*/
+        vector<shared_ptr<FsmNode>> tgtNodes =
+            sortById(getInitialState()->after(itrc));
+        
+        for (const shared_ptr<FsmNode>& n : tgtNodes)
+        {
+            int nodeId = n->getId();
+            
+            if (wLsts.at(nodeId) == nullptr)
+            {
+                wLsts[nodeId] = make_shared<IOListContainer>(stateIdentificationSets.at(nodeId)->getIOLists());
+            }
+            
+            /*Append state identification set to Wp2 tree node
+             reached after applying  itrc*/
+            Wp2.addAfter(lli, *wLsts[nodeId]);
+        }
+    }
+}
+
 
-IOListContainer Fsm::wMethod(const unsigned int numAddStates) {
+IOListContainer Fsm::wMethod(const unsigned int numAddStates,
+                             const unsigned int numThreads) {
     
     Fsm fo = transformToObservableFSM();
     Fsm fom = fo.minimise();
     
-    return fom.wMethodOnMinimisedFsm(numAddStates);
+    return fom.wMethodOnMinimisedFsm(numAddStates, numThreads);
 }
 
 
-IOListContainer Fsm::wMethodOnMinimisedFsm(const unsigned int numAddStates) {
+IOListContainer Fsm::wMethodOnMinimisedFsm(const unsigned int numAddStates,
+                                           const unsigned int numThreads) {
     
-    shared_ptr<Tree> iTree = getTransitionCover();
+    InputTrie iTree = getTransitionCoverTrie();
     
     if ( numAddStates > 0 ) {
         IOListContainer inputEnum = IOListContainer(maxInput,
                                                     1,
                                                     (int)numAddStates,
                                                     presentationLayer);
-        iTree->add(inputEnum);
+        iTree.add(inputEnum, numThreads);
     }
     
     
     IOListContainer w = getCharacterisationSet();
-    iTree->add(w);
+    iTree.add(w, numThreads);
     
-    return iTree->getIOLists();
+    return iTree.getIOLists();
     
 }
 
-IOListContainer Fsm::wpMethod(const unsigned int numAddStates)
+IOListContainer Fsm::wpMethod(const unsigned int numAddStates,
+                              const unsigned int numThreads)
 {
     
-    shared_ptr<Tree> scov = getStateCover();
+    InputTrie scov = getStateCoverTrie();
     
-    shared_ptr<Tree> tcov = getTransitionCover();
+    InputTrie tcov = getTransitionCoverTrie();
     
-    tcov->remove(scov);
-    shared_ptr<Tree> r = tcov;
+    tcov.remove(scov);
+    InputTrie& r = tcov;
     
     IOListContainer w = getCharacterisationSet();
         
     calcStateIdentificationSetsFast();
     
-    shared_ptr<Tree> Wp1 = scov;
+    InputTrie& Wp1 = scov;
     if (numAddStates > 0)
     {
         IOListContainer inputEnum = IOListContainer(maxInput, 1,
                                                     (int)numAddStates,
                                                     presentationLayer);
         
-        Wp1->add(inputEnum);
+        Wp1.add(inputEnum, numThreads);
     }
-    Wp1->add(w);
+    Wp1.add(w, numThreads);
     
-    shared_ptr<Tree> Wp2 = r;
+    InputTrie& Wp2 = r;
     if (numAddStates > 0)
     {
         IOListContainer inputEnum = IOListContainer(maxInput,
@@ -3250,16 +3680,17 @@ IOListContainer Fsm::wpMethod(const unsigned int numAddStates)
                                                     (int)numAddStates,
                                                     presentationLayer);
         
-        Wp2->add(inputEnum);
+        Wp2.add(inputEnum, numThreads);
     }
     appendStateIdentificationSets(Wp2);
 
-    Wp1->unionTree(Wp2);
-    return Wp1->getIOLists();
+    Wp1.unionTree(Wp2);
+    return Wp1.getIOLists();
 }
 
 
-IOListContainer Fsm::hsiMethod(const unsigned int numAddStates)
+IOListContainer Fsm::hsiMethod(const unsigned int numAddStates,
+                               const unsigned int numThreads)
 {
 
     if (!isObservable())
@@ -3269,15 +3700,15 @@ IOListContainer Fsm::hsiMethod(const unsigned int numAddStates)
     
     IOListContainer wSet = getCharacterisationSet();
 
-    shared_ptr<Tree> scov = getStateCover();
+    InputTrie scov = getStateCoverTrie();
 
     /* V.(Inputs from length 1 to m-n+1) */
-    shared_ptr<Tree> hsi = scov;
+    InputTrie& hsi = scov;
     IOListContainer inputEnum = IOListContainer(maxInput,
                                                     1,
                                                     (int)numAddStates + 1,
                                                     presentationLayer);
-    hsi->add(inputEnum);
+    hsi.add(inputEnum, numThreads);
 
     /* initialize HWi trees */
     std::vector<shared_ptr<Tree>> hwiTrees;
@@ -3316,14 +3747,15 @@ IOListContainer Fsm::hsiMethod(const unsigned int numAddStates)
     }
 
     /* Append harmonised state identification sets */
-    IOListContainer cnt = hsi->getIOLists();
+    IOListContainer cnt = hsi.getIOLists();
     for (auto lli : *cnt.getIOLists())
     {
         InputTrace itrc = InputTrace(lli, presentationLayer);
 
         /*Which are the target nodes reachable via input trace lli
          in this FSM?*/
-        unordered_set<shared_ptr<FsmNode>> tgtNodes = getInitialState()->after(itrc);
+        vector<shared_ptr<FsmNode>> tgtNodes =
+            sortById(getInitialState()->after(itrc));
 
         for (auto n : tgtNodes)
         {
@@ -3334,11 +3766,11 @@ IOListContainer Fsm::hsiMethod(const unsigned int numAddStates)
 
             /* Append harmonised state identification set to hsi tree node
                reached after applying itrc */
-            hsi->addAfter(itrc,hwNodeId->getIOLists());
+            hsi.addAfter(lli,hwNodeId->getIOLists());
         }
     }
 
-    return hsi->getIOLists();
+    return hsi.getIOLists();
 }
 
 TestSuite Fsm::createTestSuite(const IOListContainer & testCases)
@@ -3357,21 +3789,14 @@ TestSuite Fsm::createTestSuite(const IOListContainer & testCases)
 
 bool Fsm::isCompletelyDefined() const
 {
+    shared_ptr<CsrTransitionTable> csr = getCsrTransitionTable();
     bool cDefd = true;
-    for (shared_ptr<FsmNode> nn : nodes)
+    for (int s = 0; s < csr->size(); ++ s)
     {
+        const shared_ptr<FsmNode>& nn = csr->getNode(s);
         for (int x = 0; x <= maxInput; ++ x)
         {
-            bool found = false;
-            for (auto tr : nn->getTransitions())
-            {
-                if (tr->getLabel()->getInput() == x)
-                {
-                    found = true;
-                    break;
-                }
-            }
-            if (!found)
+            if (csr->begin(s, x) == csr->end(s, x))
             {
                 LOG(INFO) << "Incomplete FSM : for state " << nn->getName() << " (" << nn->getId() << "), input " << x << " does not have a transition." << endl;
                 cDefd = false;
@@ -3383,14 +3808,7 @@ bool Fsm::isCompletelyDefined() const
 
 bool Fsm::isDeterministic() const
 {
-    for (shared_ptr<FsmNode> node : nodes)
-    {
-        if (!node->isDeterministic())
-        {
-            return false;
-        }
-    }
-    return true;
+    return getCsrTransitionTable()->isDeterministic();
 }
 
 void Fsm::setPresentationLayer(const shared_ptr<FsmPresentationLayer>& ppresentationLayer)
@@ -4235,7 +4653,7 @@ void Fsm::addRandomTransitions(const float& maxDegreeOfNonDeterminism,
         }
         VLOG(2) << "keepGoing: " << boolalpha << keepGoing;
     }
-
+    resetCsrTransitionTable();
 }
 
 bool Fsm::meetDegreeOfCompleteness(const float& degreeOfCompleteness,
@@ -4405,6 +4823,7 @@ bool Fsm::meetDegreeOfCompleteness(const float& degreeOfCompleteness,
         }
     }
     VLOG(2) << "Finished with new degree of completeness: " << actualDegreeOfCompleteness;
+    resetCsrTransitionTable();
     return metRequirement;
 }
 
@@ -4539,6 +4958,7 @@ void Fsm::meetNumberOfStates(const int& maxState,
     }
 
     VLOG(2) << "Connected all nodes.";
+    resetCsrTransitionTable();
 }
 
 shared_ptr<FsmLabel> Fsm::createRandomLabel(const shared_ptr<FsmNode>& srcNode,
@@ -4797,6 +5217,7 @@ bool Fsm::removeUnreachableNodes(std::vector<shared_ptr<FsmNode>>& unreachableNo
     }
     
     nodes = newNodes;
+    resetCsrTransitionTable();
     
     return (unreachableNodes.size() > 0);
 }
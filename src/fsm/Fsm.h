@@ -25,6 +25,7 @@
 class Dfsm;
 class FsmNode;
 class Tree;
+class InputTrie;
 class OutputTree;
 class InputTrace;
 class FsmPresentationLayer;
@@ -36,6 +37,8 @@ class OutputTrace;
 class InputOutputTree;
 class IOTrace;
 class IOTraceContainer;
+class CsrTransitionTable;
+class RDistinguishabilityTable;
 
 enum Minimal
 {
@@ -67,6 +70,16 @@ public:
     reduction_not_possible(const std::string& msg);
 };
 
+/**
+ * Finite state machine.
+ *
+ * The const member functions only read the FSM and its nodes, so they
+ * may be called by several threads on the same instance at once, as long
+ * as no thread modifies the FSM at the same time. Traversals which store
+ * colours, visited flags or d-reach traces in the nodes are non-const;
+ * where a const variant exists, it keeps this data in caller-owned side
+ * arrays indexed by state id instead.
+ */
 class Fsm
 {
 protected:
@@ -82,6 +95,9 @@ protected:
     
     /** FSM states */
     std::vector<std::shared_ptr<FsmNode>> nodes;
+
+    /** Transition table of the states, created on first use */
+    mutable std::shared_ptr<CsrTransitionTable> csrTable;
     
     std::shared_ptr<FsmNode> currentParsedNode;
     
@@ -116,6 +132,24 @@ protected:
     void parseLine(const std::string & line);
     void readFsm(const std::string & fname);
     
+    /**
+     * Read an FSM file in the format of readFsm() from a memory-mapped
+     * copy (a buffered copy on Windows), scanning the integers directly
+     * instead of via streams.
+     * The nodes and their transition vectors are sized in a counting pass.
+     * @return false, without changing the FSM, if the file cannot be
+     *         mapped or contains a line that is not made of four integers,
+     *         optionally followed by arbitrary text; readFsm() then falls
+     *         back to parseLine()
+     */
+    bool readFsmFast(const std::string & fname);
+    
+    /**
+     * Read an FSM file in the format of readFsm() line by line,
+     * by means of readFsmInitial() and parseLine()
+     */
+    void readFsmStream(const std::string & fname);
+    
     void parseLineInitial (const std::string & line);
     void readFsmInitial (const std::string & fname);
     /**
@@ -124,7 +158,11 @@ protected:
      */
     void readFsmFromDot (const std::string & fname, const std::string name = "");
     
-    std::string labelString(std::unordered_set<std::shared_ptr<FsmNode>>& lbl) const;
+    /**
+     * Return the name "{ name(id),... }" of a set of states, given by
+     * their indices in a CSR transition table
+     */
+    std::string labelString(const std::vector<int>& lbl, const CsrTransitionTable& csr) const;
     
     /**
      *  Return a random seed to be used for random generation
@@ -181,6 +219,14 @@ protected:
 
     std::vector<std::shared_ptr<FsmTransition>> getNonDeterministicTransitions() const;
 
+    /**
+     * Calculates for every state the r(1)-distinguishable states, using the
+     * bit matrices of tbl, which is advanced to level 1.
+     * @param tbl The r-distinguishability table of this FSM
+     * @param numThreads Number of worker threads (0: one per hardware thread)
+     */
+    void calcROneDistinguishableStates(RDistinguishabilityTable& tbl, const unsigned int numThreads);
+
 public:
     
     
@@ -347,6 +393,20 @@ public:
     void dumpFsm(std::ofstream & outputFile) const;
     std::vector<std::shared_ptr<FsmNode>> getDReachableStates() { return dReachableStates; }
     std::vector<std::shared_ptr<FsmNode>> calcDReachableStates(InputTraceSet& detStateCover);
+
+    /**
+     * Calculate the d-reachable states without modifying the FSM or its
+     * nodes: neither node colours nor the d-reach traces of the nodes
+     * are written, and getDReachableStates() remains unchanged.
+     * @param detStateCover The input traces of the deterministic state
+     *        cover are added to this set
+     * @param dReachTraces Side array indexed by state id, which is resized
+     *        to the number of states. The entry of every d-reachable state
+     *        holds the trace d-reaching it, all other entries are nullptr.
+     * @return The d-reachable states in breadth-first order
+     */
+    std::vector<std::shared_ptr<FsmNode>> calcDReachableStates(InputTraceSet& detStateCover,
+                                                               std::vector<std::shared_ptr<IOTrace>>& dReachTraces) const;
     std::shared_ptr<FsmNode> getInitialState() const;
     
     /**
@@ -361,6 +421,18 @@ public:
     std::shared_ptr<FsmNode> getNode(int id) const;
     std::shared_ptr<FsmPresentationLayer> getPresentationLayer() const;
     int getInitStateIdx() const;
+
+    /**
+     *  Return a compressed-sparse-row snapshot of the transition relation.
+     *  State index s of the table refers to nodes[s]. The snapshot is
+     *  created on first use and shared by all callers, concurrent ones
+     *  included. It is re-created after the FSM methods changing states
+     *  and after any change made by the FsmNode and FsmTransition setters;
+     *  after modifying the node vector or a transitions vector directly,
+     *  resetCsrTransitionTable() has to be called.
+     */
+    std::shared_ptr<CsrTransitionTable> getCsrTransitionTable() const;
+    void resetCsrTransitionTable();
     void resetColor();
     void toDot(const std::string & fname);
     
@@ -371,21 +443,40 @@ public:
     /**
      Create a new FSM that represents the intersection of this and the other FSM
      @param f the other FSM
+     @param name name of the new FSM; if empty, the names of this and f
+            are combined
+     @param stopAtFailure if true, the construction stops as soon as a
+            state (s1,s2) has been reached where s2 has a transition label
+            that does not exist in s1. The resulting FSM is then only a
+            partial intersection, but hasFailure() still detects the failure.
      @return a new FSM which equals the intersection of this and f
      */
-    Fsm intersect(const Fsm & f, std::string name = "");
+    Fsm intersect(const Fsm & f, std::string name = "", const bool stopAtFailure = false);
 
     /**
      * Generate the state cover of an arbitrary FSM
      * (deterministic or nondeterministic, completely specified 
      *  or not, observable or not, minimised or not)
      */
-    std::shared_ptr<Tree> getStateCover();
+    std::shared_ptr<Tree> getStateCover() const;
     
     /**
      * Generate the transition cover of an arbitrary FSM
      */
-    std::shared_ptr<Tree> getTransitionCover();
+    std::shared_ptr<Tree> getTransitionCover() const;
+
+    /**
+     * Generate the state cover as an arena-backed input trie. The trie
+     * has the same structure and child order as getStateCover().
+     */
+    InputTrie getStateCoverTrie() const;
+
+    /**
+     * Generate the transition cover as an arena-backed input trie.
+     * The trie has the same structure and child order as
+     * getTransitionCover().
+     */
+    InputTrie getTransitionCoverTrie() const;
     
     /**
      *  Apply an input trace to an FSM and return its
@@ -403,6 +494,20 @@ public:
      */
     OutputTree apply(const InputTrace & itrc, bool markAsVisited = false);
 
+    /**
+     *  Apply an input trace to an FSM without modifying its nodes.
+     *
+     *  @param itrc Input trace to be processed on the FSM, starting in
+     *              the FSM's initial state
+     *  @param visited Side array indexed by state id: the entries of
+     *              all FSM nodes visited while executing the input trace
+     *              are set to true
+     *
+     *  @return The set of outputs created by input trace itrc;
+     *          the set is encoded as an OutputTree.
+     */
+    OutputTree apply(const InputTrace & itrc, std::vector<bool>& visited) const;
+
     /**
      * Calculates each output that can be generated by a given input trace and the corresponding target nodes.
      * @param input The given input trace.
@@ -488,8 +593,14 @@ public:
 
     /**
      * Calculates for every state the r-distinguishable states.
+     *
+     * The state pairs of each level are examined on numThreads worker
+     * threads; the adaptive input sequences are identical for every
+     * number of threads.
+     * \pre The FSM must be observable
+     * @param numThreads Number of worker threads (0: one per hardware thread)
      */
-    void calcRDistinguishableStates();
+    void calcRDistinguishableStates(const unsigned int numThreads = 1);
 
     /**
      * Calculates the state characterisation set for a given state, based on the
@@ -545,6 +656,23 @@ public:
 
     bool hasFailure() const;
 
+    /**
+     * Check whether iut is a reduction of spec, that is, whether every
+     * I/O trace of iut is also an I/O trace of spec. This yields the same
+     * verdict as !spec.intersect(iut).hasFailure(), but the pairs of
+     * spec and iut states are explored breadth-first on the fly, without
+     * creating the intersection FSM, and the exploration stops at the
+     * first failure.
+     * @param spec The given specification
+     * @param iut The given IUT
+     * @param failTrace Return parameter: if iut is not a reduction of spec,
+     *        a shortest I/O trace of iut which is not a trace of spec,
+     *        nullptr otherwise
+     * @return `true`, if iut is a reduction of spec, `false`, otherwise.
+     */
+    static bool isReduction(const Fsm& spec, const Fsm& iut,
+                            std::shared_ptr<IOTrace>& failTrace);
+
     /**
      * Returns a set of input/output sequences that can be produced by this
      * FSM when applying each element of the given adaptive test cases to
@@ -652,13 +780,18 @@ public:
      * suite creation.
      * @param observedTraces Return parameter for the trace that caused a failure during the test
      * suite creation.
+     * @param numThreads Number of worker threads the elements of T_c are distributed to in
+     * every iteration (0: one per hardware thread). The results are merged in the order of
+     * T_c, so that the observed traces, the fail trace and the next T_c do not depend on the
+     * number of threads. Once a failure has been found, no further elements are applied.
      * @return `true`, if no failure has been observed during the creation of the test suite,
      * `false`, otherwise.
      */
     static bool adaptiveStateCounting(Fsm& spec, Fsm& iut, const size_t m,
                                       IOTraceContainer& observedTraces,
                                       std::shared_ptr<IOTrace>& failTrace,
-                                      int& iterations);
+                                      int& iterations,
+                                      const unsigned int numThreads = 1);
 
     /**
      * Determines if the given adaptive test cases distinguish all states from
@@ -765,6 +898,7 @@ public:
     void calcStateIdentificationSetsFast();
 
     void appendStateIdentificationSets(const std::shared_ptr<Tree>& Wp2) const;
+    void appendStateIdentificationSets(InputTrie& Wp2) const;
     
     /**
      * Perform test generation by means of the W Method, as applicable
@@ -779,10 +913,14 @@ public:
      * first transformed into an observable minimised one. Then the
      * W-Method is applied on the minimised machine, using wMethodOnMinimisedFsm().
      *
+     * @param numThreads Number of worker threads used to expand the
+     *                   test tree (0: one per hardware thread). The
+     *                   test suite does not depend on this value.
      * @return A test suite
      *
      */
-    IOListContainer wMethod(const unsigned int numAddStates);
+    IOListContainer wMethod(const unsigned int numAddStates,
+                            const unsigned int numThreads = 1);
     
     
     /**
@@ -792,10 +930,14 @@ public:
      * reflecting the implementation behaviour. It is assumed that the
      * method is called on an observable, minimised FSM
      *
+     * @param numThreads Number of worker threads used to expand the
+     *                   test tree (0: one per hardware thread). The
+     *                   test suite does not depend on this value.
      * @return A test suite
      *
      */
-    IOListContainer wMethodOnMinimisedFsm(const unsigned int m);
+    IOListContainer wMethodOnMinimisedFsm(const unsigned int m,
+                                          const unsigned int numThreads = 1);
     
     
     /**
@@ -810,9 +952,13 @@ public:
      *                     which the implementation DFSM in minimised
      *                     form may have, when compared to the reference
      *                     model in minimised form.
+     * @param numThreads Number of worker threads used to expand the
+     *                   test tree (0: one per hardware thread). The
+     *                   test suite does not depend on this value.
      * @return A test suite
      */
-    IOListContainer wpMethod(const unsigned int numAddStates);
+    IOListContainer wpMethod(const unsigned int numAddStates,
+                             const unsigned int numThreads = 1);
 
     /**
      * WORK IN PROGRESS
@@ -823,9 +969,13 @@ public:
      *                     which the implementation DFSM in minimised
      *                     form may have, when compared to the reference
      *                     model in minimised form.
+     * @param numThreads Number of worker threads used to expand the
+     *                   test tree (0: one per hardware thread). The
+     *                   test suite does not depend on this value.
      * @return A test suite
      */
-    IOListContainer hsiMethod(const unsigned int numAddStates);
+    IOListContainer hsiMethod(const unsigned int numAddStates,
+                              const unsigned int numThreads = 1);
 
     
     /**
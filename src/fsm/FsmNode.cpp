@@ -24,6 +24,8 @@
 
 using namespace std;
 
+atomic<unsigned long> FsmNode::structureGeneration(0);
+
 FsmNode::FsmNode(const int id, const shared_ptr<FsmPresentationLayer>& presentationLayer)
 : id(id),
 visited(false),
@@ -57,6 +59,8 @@ void FsmNode::addTransition(std::shared_ptr<FsmTransition> transition)
     }
     
     transitions.push_back(transition);
+    indexTransition(transition.get());
+    structureChanged();
 }
 
 bool FsmNode::removeTransition(const std::shared_ptr<FsmTransition>& t)
@@ -64,7 +68,20 @@ bool FsmNode::removeTransition(const std::shared_ptr<FsmTransition>& t)
     auto it = find(transitions.begin(), transitions.end(), t);
     if (it != transitions.end())
     {
+        // t may refer to the element erased from transitions, so the
+        // index is updated first
+        int x = t->getLabel()->getInput();
+        if (x >= 0 and static_cast<size_t>(x) < inputIndex.size())
+        {
+            vector<FsmTransition*>& bucket = inputIndex[x];
+            auto bit = find(bucket.begin(), bucket.end(), t.get());
+            if (bit != bucket.end())
+            {
+                bucket.erase(bit);
+            }
+        }
         transitions.erase(it);
+        structureChanged();
         return true;
     }
     return false;
@@ -73,6 +90,41 @@ bool FsmNode::removeTransition(const std::shared_ptr<FsmTransition>& t)
 void FsmNode::setTransitions(std::vector<std::shared_ptr<FsmTransition>> transitions)
 {
     this->transitions = transitions;
+    reindexTransitions();
+}
+
+void FsmNode::reindexTransitions()
+{
+    inputIndex.clear();
+    for (const auto& tr : transitions)
+    {
+        indexTransition(tr.get());
+    }
+    structureChanged();
+}
+
+void FsmNode::indexTransition(FsmTransition* tr)
+{
+    int x = tr->getLabel()->getInput();
+    if (x < 0)
+    {
+        return;
+    }
+    if (static_cast<size_t>(x) >= inputIndex.size())
+    {
+        inputIndex.resize(x + 1);
+    }
+    inputIndex[x].push_back(tr);
+}
+
+const vector<FsmTransition*>& FsmNode::getTransitionsWithInput(const int x) const
+{
+    static const vector<FsmTransition*> noTransitions;
+    if (x < 0 or static_cast<size_t>(x) >= inputIndex.size())
+    {
+        return noTransitions;
+    }
+    return inputIndex[x];
 }
 
 vector<shared_ptr<FsmTransition> >& FsmNode::getTransitions()
@@ -211,15 +263,12 @@ vector<shared_ptr<FsmNode>> FsmNode::getPossibleOutputs(const int x, vector<shar
         return result;
     }
 
-    for (auto transition : transitions)
+    for (FsmTransition* transition : getTransitionsWithInput(x))
     {
-        if (transition->getLabel()->getInput() == x)
-        {
-            result.push_back(transition->getTarget());
-            vector<int> traceRaw({transition->getLabel()->getOutput()});
-            shared_ptr<OutputTrace> oT = make_shared<OutputTrace>(traceRaw, presentationLayer);
-            outputs.push_back(oT);
-        }
+        result.push_back(transition->getTarget());
+        vector<int> traceRaw({transition->getLabel()->getOutput()});
+        shared_ptr<OutputTrace> oT = make_shared<OutputTrace>(traceRaw, presentationLayer);
+        outputs.push_back(oT);
     }
     return result;
 }
@@ -303,40 +352,23 @@ void FsmNode::getPossibleOutputs(const InputTrace& input, vector<shared_ptr<Outp
 vector<shared_ptr<OutputTrace>> FsmNode::getPossibleOutputs(const int x) const
 {
     vector<shared_ptr<OutputTrace>> result;
-    for (auto transition : transitions)
+    for (FsmTransition* transition : getTransitionsWithInput(x))
     {
-        if (transition->getLabel()->getInput() == x)
-        {
-            vector<int> traceRaw({transition->getLabel()->getOutput()});
-            shared_ptr<OutputTrace> oT = make_shared<OutputTrace>(traceRaw, presentationLayer);
-            result.push_back(oT);
-        }
+        vector<int> traceRaw({transition->getLabel()->getOutput()});
+        shared_ptr<OutputTrace> oT = make_shared<OutputTrace>(traceRaw, presentationLayer);
+        result.push_back(oT);
     }
     return result;
 }
 
 bool FsmNode::hasTransition(const int input, const int output) const
 {
-    for (shared_ptr<FsmTransition> trans : transitions)
-    {
-        if (trans->getLabel()->getInput() == input && trans->getLabel()->getOutput() == output)
-        {
-            return true;
-        }
-    }
-    return false;
+    return isPossibleOutput(input, output);
 }
 
 bool FsmNode::hasTransition(const int input) const
 {
-    for (shared_ptr<FsmTransition> trans : transitions)
-    {
-        if (trans->getLabel()->getInput() == input)
-        {
-            return true;
-        }
-    }
-    return false;
+    return isPossibleInput(input);
 }
 
 vector<int> FsmNode::getNotDefinedInputs(const int& maxInput) const
@@ -345,16 +377,7 @@ vector<int> FsmNode::getNotDefinedInputs(const int& maxInput) const
     vector<int> result;
     for (int i = 0; i <= maxInput; ++i)
     {
-        bool inputDefined = false;
-        for (const shared_ptr<FsmTransition>& t : transitions)
-        {
-            if (t->getLabel()->getInput() == i)
-            {
-                inputDefined = true;
-                break;
-            }
-        }
-        if (!inputDefined){
+        if (getTransitionsWithInput(i).empty()){
             VLOG(2) << "  " << presentationLayer->getInId(static_cast<unsigned int>(i));
             result.push_back(i);
         }
@@ -368,16 +391,7 @@ vector<int> FsmNode::getNotDefinedOutputs(const int& input, const int& maxOutput
     vector<int> result;
     for (int o = 0; o <= maxOutput; ++o)
     {
-        bool outputDefined = false;
-        for (const shared_ptr<FsmTransition>& t : transitions)
-        {
-            if (t->getLabel()->getInput() == input && t->getLabel()->getOutput() == o)
-            {
-                outputDefined = true;
-                break;
-            }
-        }
-        if (!outputDefined)
+        if (!isPossibleOutput(input, o))
         {
             VLOG(2) << "  " << presentationLayer->getOutId(static_cast<unsigned int>(o));
             result.push_back(o);
@@ -388,9 +402,9 @@ vector<int> FsmNode::getNotDefinedOutputs(const int& input, const int& maxOutput
 
 bool FsmNode::isPossibleOutput(const int x, const int y) const
 {
-    for (auto transition : transitions)
+    for (FsmTransition* transition : getTransitionsWithInput(x))
     {
-        if (transition->getLabel()->getInput() == x && transition->getLabel()->getOutput() == y)
+        if (transition->getLabel()->getOutput() == y)
         {
             return true;
         }
@@ -400,43 +414,35 @@ bool FsmNode::isPossibleOutput(const int x, const int y) const
 
 bool FsmNode::isPossibleInput(const int x) const
 {
-    for (auto transition : transitions)
-    {
-        if (transition->getLabel()->getInput() == x)
-        {
-            return true;
-        }
-    }
-    return false;
+    return !getTransitionsWithInput(x).empty();
 }
 
 shared_ptr<FsmNode> FsmNode::apply(const int e, OutputTrace & o)
 {
-    for (shared_ptr<FsmTransition> tr : transitions)
+    const vector<FsmTransition*>& trs = getTransitionsWithInput(e);
+    if (trs.empty())
     {
-        if (tr->getLabel()->getInput() == e)
-        {
-            o.add(tr->getLabel()->getOutput());
-            return tr->getTarget();
-        }
+        return nullptr;
     }
-    return nullptr;
+    o.add(trs.front()->getLabel()->getOutput());
+    return trs.front()->getTarget();
 }
 
-OutputTree FsmNode::apply(const InputTrace& itrc, bool markAsVisited)
+template <typename Node, typename Visit>
+OutputTree FsmNode::applyTrace(Node& start, const InputTrace& itrc, Visit visit)
 {
     deque<shared_ptr<TreeNode>> tnl;
-    unordered_map<shared_ptr<TreeNode>, shared_ptr<FsmNode>> t2f;
+    unordered_map<shared_ptr<TreeNode>, Node*> t2f;
     
     shared_ptr<TreeNode> root = make_shared<TreeNode>();
-    OutputTree ot = OutputTree(root, itrc, presentationLayer);
+    OutputTree ot = OutputTree(root, itrc, start.presentationLayer);
     
     if (itrc.get().size() == 0)
     {
         return ot;
     }
     
-    t2f[root] = shared_from_this();
+    t2f[root] = &start;
     
     for (auto it = itrc.cbegin(); it != itrc.cend(); ++ it)
     {
@@ -453,27 +459,44 @@ OutputTree FsmNode::apply(const InputTrace& itrc, bool markAsVisited)
             shared_ptr<TreeNode> thisTreeNode = tnl.front();
             tnl.pop_front();
             
-            shared_ptr<FsmNode> thisState = t2f.at(thisTreeNode);
-            if ( markAsVisited ) thisState->setVisited();
+            Node* thisState = t2f.at(thisTreeNode);
+            visit(*thisState);
             
-            for (shared_ptr<FsmTransition> tr : thisState->getTransitions())
+            for (FsmTransition* tr : thisState->getTransitionsWithInput(x))
             {
-                if (tr->getLabel()->getInput() == x)
-                {
-                    int y = tr->getLabel()->getOutput();
-                    shared_ptr<FsmNode> tgtState = tr->getTarget();
-                    shared_ptr<TreeNode> tgtNode = make_shared<TreeNode>();
-                    shared_ptr<TreeEdge> te = make_shared<TreeEdge>(y, tgtNode);
-                    thisTreeNode->add(te);
-                    t2f[tgtNode] = tgtState;
-                    if ( markAsVisited ) tgtState->setVisited();
-                }
+                int y = tr->getLabel()->getOutput();
+                Node* tgtState = tr->getTarget().get();
+                shared_ptr<TreeNode> tgtNode = make_shared<TreeNode>();
+                shared_ptr<TreeEdge> te = make_shared<TreeEdge>(y, tgtNode);
+                thisTreeNode->add(te);
+                t2f[tgtNode] = tgtState;
+                visit(*tgtState);
             }
         }
     }
     return ot;
 }
 
+OutputTree FsmNode::apply(const InputTrace& itrc, bool markAsVisited)
+{
+    return applyTrace(*this, itrc, [markAsVisited](FsmNode& n)
+    {
+        if ( markAsVisited ) n.setVisited();
+    });
+}
+
+OutputTree FsmNode::apply(const InputTrace& itrc, vector<bool>& visited) const
+{
+    return applyTrace(*this, itrc, [&visited](const FsmNode& n)
+    {
+        if (static_cast<size_t>(n.id) >= visited.size())
+        {
+            visited.resize(n.id + 1, false);
+        }
+        visited[n.id] = true;
+    });
+}
+
 unordered_set<shared_ptr<FsmNode>> FsmNode::after(const vector<int>& itrc)
 {
     unordered_set<shared_ptr<FsmNode>> nodeSet;
@@ -583,12 +606,9 @@ vector<shared_ptr<FsmNode>> FsmNode::after(const int x)
         return lst;
     }
 
-    for (auto tr : transitions)
+    for (FsmTransition* tr : getTransitionsWithInput(x))
     {
-        if (tr->getLabel()->getInput() == x)
-        {
-            lst.push_back(tr->getTarget());
-        }
+        lst.push_back(tr->getTarget());
     }
     return lst;
 }
@@ -596,13 +616,10 @@ vector<shared_ptr<FsmNode>> FsmNode::after(const int x)
 vector<shared_ptr<FsmNode>> FsmNode::after(const int x, std::vector<int>& producedOutputs)
 {
     vector<shared_ptr<FsmNode> > lst;
-    for (auto tr : transitions)
+    for (FsmTransition* tr : getTransitionsWithInput(x))
     {
-        if (tr->getLabel()->getInput() == x)
-        {
-            lst.push_back(tr->getTarget());
-            producedOutputs.push_back(tr->getLabel()->getOutput());
-        }
+        lst.push_back(tr->getTarget());
+        producedOutputs.push_back(tr->getLabel()->getOutput());
     }
     return lst;
 }
@@ -617,12 +634,9 @@ unordered_set<shared_ptr<FsmNode>> FsmNode::afterAsSet(const int x)
         return nodeSet;
     }
     
-    for (auto tr : transitions)
+    for (FsmTransition* tr : getTransitionsWithInput(x))
     {
-        if (tr->getLabel()->getInput() == x)
-        {
-            nodeSet.insert(tr->getTarget());
-        }
+        nodeSet.insert(tr->getTarget());
     }
     return nodeSet;
 }
@@ -637,9 +651,9 @@ unordered_set<shared_ptr<FsmNode>> FsmNode::afterAsSet(const int x, const int y)
         return lst;
     }
 
-    for (auto tr : transitions)
+    for (FsmTransition* tr : getTransitionsWithInput(x))
     {
-        if (tr->getLabel()->getInput() == x && tr->getLabel()->getOutput() == y)
+        if (tr->getLabel()->getOutput() == y)
         {
             lst.insert(tr->getTarget());
         }
@@ -914,14 +928,11 @@ bool FsmNode::isObservable() const
 
 bool FsmNode::isDeterministic() const
 {
-    unordered_set<int> inputSet;
-    
     /*Check if more than one outgoing transition
      is labelled with the same input value*/
-    for (auto tr : transitions)
+    for (const auto& bucket : inputIndex)
     {
-        int inp = tr->getLabel()->getInput();
-        if (!inputSet.insert(inp).second)
+        if (bucket.size() > 1)
         {
             return false;
         }
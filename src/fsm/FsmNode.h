@@ -6,6 +6,7 @@
 #ifndef FSM_FSM_FSMNODE_H_
 #define FSM_FSM_FSMNODE_H_
 
+#include <atomic>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -35,6 +36,22 @@ class FsmNode : public std::enable_shared_from_this<FsmNode>
 {
 private:
     std::vector<std::shared_ptr<FsmTransition> > transitions;
+    
+    /**
+     *  Index of the outgoing transitions by input: inputIndex[x] lists
+     *  the transitions labelled with input x, in the order in which they
+     *  occur in the transitions vector. Transitions with negative
+     *  inputs (EPSILON) are not indexed. The index is kept in sync by
+     *  addTransition(), removeTransition(), setTransitions() and
+     *  FsmTransition::setLabel().
+     */
+    std::vector<std::vector<FsmTransition*>> inputIndex;
+    
+    /**
+     *  Counter incremented by every change of the transition graph of
+     *  any FsmNode, used to detect stale transition tables
+     */
+    static std::atomic<unsigned long> structureGeneration;
 	int id;
 	std::string name;
 	bool visited;
@@ -44,6 +61,24 @@ private:
     std::shared_ptr<RDistinguishability> rDistinguishability;
     
     bool isInitialNode;
+    
+    /**
+     *  Add a transition to the input index
+     */
+    void indexTransition(FsmTransition* tr);
+    
+    /**
+     *  Return the transitions labelled with input x
+     */
+    const std::vector<FsmTransition*>& getTransitionsWithInput(const int x) const;
+    
+    /**
+     *  Apply an input trace starting in node start, calling visit(node)
+     *  for every FSM node passed while executing the trace. Node is
+     *  either FsmNode or const FsmNode.
+     */
+    template <typename Node, typename Visit>
+    static OutputTree applyTrace(Node& start, const InputTrace& itrc, Visit visit);
     bool dReachable = false;
     std::shared_ptr<IOTrace> dReachTrace;
     std::shared_ptr<IOTrace> reachTrace;
@@ -74,13 +109,44 @@ public:
 
     void setTransitions(std::vector<std::shared_ptr<FsmTransition>> transitions);
     
+    /**
+     *  Re-create the index of outgoing transitions by input and record
+     *  the structure change. This is only required after the transitions
+     *  vector returned by getTransitions() has been modified directly.
+     */
+    void reindexTransitions();
+    
+    /**
+     *  Record that the transition graph has changed: transitions or
+     *  node ids have been modified. The FsmNode and FsmTransition
+     *  setters do this themselves.
+     */
+    static void structureChanged() { ++structureGeneration; }
+    
+    /**
+     *  Return the current structure generation. Transition tables
+     *  created at a different generation may be stale.
+     */
+    static unsigned long getStructureGeneration() { return structureGeneration.load(); }
     
+    /**
+     *  Return the outgoing transitions. Transitions should be added and
+     *  removed by means of addTransition() and removeTransition(),
+     *  so that the input index of this node stays in sync.
+     */
     std::vector<std::shared_ptr<FsmTransition> >& getTransitions();
     std::vector<std::shared_ptr<FsmTransition>> getDeterminisitcTransitions() const;
     std::vector<std::shared_ptr<FsmTransition>> getNonDeterminisitcTransitions() const;
     int getId() const;
-    void setId(const int id) { this->id = id; }
+    void setId(const int id) { this->id = id; structureChanged(); }
 	std::string getName() const;
+    
+    /**
+     *  Return the name the node has been created with, which getName()
+     *  uses as prefix of the id if the presentation layer does not
+     *  define a name for this state
+     */
+    const std::string& getNamePrefix() const { return name; }
 	bool hasBeenVisited() const;
 	void setVisited();
     void setUnvisited();
@@ -96,6 +162,21 @@ public:
 	std::shared_ptr<std::pair<std::shared_ptr<FsmNode>, std::shared_ptr<FsmNode>>> getPair() const;
 	std::shared_ptr<FsmNode> apply(const int e, OutputTrace & o);
 	OutputTree apply(const InputTrace & itrc, bool markAsVisited = false);
+    
+    /**
+     *  Apply an input trace starting in this node without modifying
+     *  any node. The nodes passed while executing the trace are
+     *  recorded in a caller-owned side array instead of being marked
+     *  as visited, so that several threads may apply traces to the
+     *  same FSM concurrently.
+     *
+     *  @param itrc Input trace to be processed
+     *  @param visited Side array indexed by state id; the entries of
+     *         the nodes passed are set to true. The array is enlarged
+     *         if it does not cover a state id.
+     *  @return The outputs created by itrc, encoded as an OutputTree
+     */
+    OutputTree apply(const InputTrace & itrc, std::vector<bool>& visited) const;
     std::shared_ptr<RDistinguishability> getRDistinguishability();
     /**
      *
@@ -0,0 +1,543 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "fsm/FsmSnapshot.h"
+#include "fsm/Dfsm.h"
+#include "fsm/Fsm.h"
+#include "fsm/FsmLabel.h"
+#include "fsm/FsmNode.h"
+#include "fsm/FsmTransition.h"
+#include "interface/FsmPresentationLayer.h"
+
+using namespace std;
+
+namespace
+{
+    const char snapshotMagic[8] = { 'F', 'S', 'M', 'S', 'N', 'A', 'P', '\0' };
+    const uint32_t byteOrderMark = 0x01020304;
+    const uint32_t flagDeterministic = 1;
+
+    enum SnapshotSection
+    {
+        STATE_OFFSETS,
+        INPUTS,
+        OUTPUTS,
+        TARGETS,
+        IN_NAMES,
+        OUT_NAMES,
+        STATE_NAMES,
+        NODE_IDS,
+        NODE_NAMES,
+        REQ_NAMES,
+        FSM_NAME,
+        NODE_REQ_OFFSETS,
+        NODE_REQS,
+        TRANS_REQ_OFFSETS,
+        TRANS_REQS,
+        NUM_SECTIONS
+    };
+
+    struct SnapshotHeader
+    {
+        char magic[8];
+        uint32_t byteOrder;
+        uint32_t version;
+        uint32_t flags;
+        int32_t numStates;
+        int32_t maxInput;
+        int32_t maxOutput;
+        int32_t initState;
+        uint32_t numTransitions;
+        uint64_t fileSize;
+        /** Byte offset of each section; section i ends where section i+1 starts */
+        uint64_t sections[NUM_SECTIONS];
+    };
+
+    /** Append a section to the file image, starting at an 8-byte boundary */
+    void appendSection(vector<char>& image, uint64_t& offset, const void* data, const size_t len)
+    {
+        image.resize((image.size() + 7) & ~static_cast<size_t>(7), 0);
+        offset = image.size();
+        const char* p = static_cast<const char*>(data);
+        image.insert(image.end(), p, p + len);
+    }
+
+    template <typename T>
+    void appendArray(vector<char>& image, uint64_t& offset, const vector<T>& v)
+    {
+        appendSection(image, offset, v.data(), v.size() * sizeof(T));
+    }
+
+    void appendStringTable(vector<char>& image, uint64_t& offset, const vector<string>& strings)
+    {
+        vector<uint32_t> table;
+        table.reserve(strings.size() + 2);
+        table.push_back(static_cast<uint32_t>(strings.size()));
+        uint32_t pos = 0;
+        table.push_back(pos);
+        for (const auto& s : strings)
+        {
+            pos += static_cast<uint32_t>(s.size());
+            table.push_back(pos);
+        }
+        appendArray(image, offset, table);
+        for (const auto& s : strings)
+        {
+            image.insert(image.end(), s.begin(), s.end());
+        }
+    }
+
+    /** Check that offsets[0..n] starts with 0, is ascending and ends with last */
+    bool checkOffsets(const uint32_t* offsets, const size_t n, const uint32_t last)
+    {
+        if (offsets[0] != 0 or offsets[n] != last)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (offsets[i] > offsets[i + 1])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** Check that every value of v[0..n-1] is in range lo..hi */
+    template <typename T>
+    bool checkRange(const T* v, const size_t n, const int64_t lo, const int64_t hi)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (static_cast<int64_t>(v[i]) < lo or static_cast<int64_t>(v[i]) > hi)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+FsmSnapshot::FsmSnapshot()
+    : base(nullptr), fileSize(0),
+      stateOffsets(nullptr), inputs(nullptr), outputs(nullptr), targets(nullptr),
+      inNames(nullptr), outNames(nullptr), stateNames(nullptr),
+      nodeIds(nullptr), nodeNames(nullptr), reqNames(nullptr),
+      fsmName(nullptr), nodeReqOffsets(nullptr), nodeReqs(nullptr),
+      transReqOffsets(nullptr), transReqs(nullptr),
+      numStates(0), maxInput(-1), maxOutput(-1), initState(0),
+      numTransitions(0), deterministic(false)
+{
+}
+
+FsmSnapshot::~FsmSnapshot()
+{
+#ifndef _WIN32
+    if (base != nullptr and buffer.empty())
+    {
+        munmap(const_cast<char*>(base), fileSize);
+    }
+#endif
+}
+
+bool FsmSnapshot::save(const Fsm& fsm, const string& fname)
+{
+    const vector<shared_ptr<FsmNode>> nodes = fsm.getNodes();
+    const shared_ptr<FsmPresentationLayer> pl = fsm.getPresentationLayer();
+
+    unordered_map<const FsmNode*, int32_t> nodeIndex;
+    for (size_t s = 0; s < nodes.size(); ++s)
+    {
+        nodeIndex[nodes[s].get()] = static_cast<int32_t>(s);
+    }
+
+    vector<uint32_t> stateOffsets { 0 };
+    vector<int32_t> inputs, outputs, targets;
+    vector<int32_t> nodeIds;
+    vector<string> nodeNames;
+    vector<string> reqNames;
+    unordered_map<string, uint32_t> reqIndex;
+    vector<uint32_t> nodeReqOffsets { 0 }, nodeReqs;
+    vector<uint32_t> transReqOffsets { 0 }, transReqs;
+
+    auto addRequirements = [&](const vector<string>& reqs,
+                               vector<uint32_t>& offsets,
+                               vector<uint32_t>& indices)
+    {
+        for (const auto& r : reqs)
+        {
+            auto it = reqIndex.find(r);
+            if (it == reqIndex.end())
+            {
+                it = reqIndex.emplace(r, static_cast<uint32_t>(reqNames.size())).first;
+                reqNames.push_back(r);
+            }
+            indices.push_back(it->second);
+        }
+        offsets.push_back(static_cast<uint32_t>(indices.size()));
+    };
+
+    for (const auto& n : nodes)
+    {
+        nodeIds.push_back(n->getId());
+        nodeNames.push_back(n->getNamePrefix());
+        addRequirements(n->getSatisfied(), nodeReqOffsets, nodeReqs);
+        for (const auto& tr : n->getTransitions())
+        {
+            auto it = nodeIndex.find(tr->getTarget().get());
+            if (it == nodeIndex.end())
+            {
+                cerr << "Cannot save FSM " << fsm.getName()
+                     << ": transition target is not a state of the FSM" << endl;
+                return false;
+            }
+            inputs.push_back(tr->getLabel()->getInput());
+            outputs.push_back(tr->getLabel()->getOutput());
+            targets.push_back(it->second);
+            addRequirements(tr->getSatisfied(), transReqOffsets, transReqs);
+        }
+        stateOffsets.push_back(static_cast<uint32_t>(targets.size()));
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+    header.byteOrder = byteOrderMark;
+    header.version = formatVersion;
+    header.flags = fsm.isDeterministic() ? flagDeterministic : 0;
+    header.numStates = static_cast<int32_t>(nodes.size());
+    header.maxInput = fsm.getMaxInput();
+    header.maxOutput = fsm.getMaxOutput();
+    header.initState = fsm.getInitStateIdx();
+    header.numTransitions = static_cast<uint32_t>(targets.size());
+
+    vector<char> image(sizeof(header), 0);
+    appendArray(image, header.sections[STATE_OFFSETS], stateOffsets);
+    appendArray(image, header.sections[INPUTS], inputs);
+    appendArray(image, header.sections[OUTPUTS], outputs);
+    appendArray(image, header.sections[TARGETS], targets);
+    appendStringTable(image, header.sections[IN_NAMES], pl->getIn2String());
+    appendStringTable(image, header.sections[OUT_NAMES], pl->getOut2String());
+    appendStringTable(image, header.sections[STATE_NAMES], pl->getState2String());
+    appendArray(image, header.sections[NODE_IDS], nodeIds);
+    appendStringTable(image, header.sections[NODE_NAMES], nodeNames);
+    appendStringTable(image, header.sections[REQ_NAMES], reqNames);
+    appendStringTable(image, header.sections[FSM_NAME], { fsm.getName() });
+    appendArray(image, header.sections[NODE_REQ_OFFSETS], nodeReqOffsets);
+    appendArray(image, header.sections[NODE_REQS], nodeReqs);
+    appendArray(image, header.sections[TRANS_REQ_OFFSETS], transReqOffsets);
+    appendArray(image, header.sections[TRANS_REQS], transReqs);
+    header.fileSize = image.size();
+    memcpy(image.data(), &header, sizeof(header));
+
+    ofstream out(fname, ios::binary | ios::trunc);
+    out.write(image.data(), static_cast<streamsize>(image.size()));
+    out.close();
+    if (not out)
+    {
+        cerr << "Could not write snapshot file " << fname << endl;
+        return false;
+    }
+    return true;
+}
+
+bool FsmSnapshot::isSnapshotFile(const string& fname)
+{
+    char magic[sizeof(snapshotMagic)];
+    ifstream in(fname, ios::binary);
+    in.read(magic, sizeof(magic));
+    return in and memcmp(magic, snapshotMagic, sizeof(magic)) == 0;
+}
+
+shared_ptr<FsmSnapshot> FsmSnapshot::open(const string& fname)
+{
+    shared_ptr<FsmSnapshot> snapshot(new FsmSnapshot());
+#ifndef _WIN32
+    int fd = ::open(fname.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        cerr << "Could not open snapshot file " << fname << endl;
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 or st.st_size < static_cast<off_t>(sizeof(SnapshotHeader)))
+    {
+        ::close(fd);
+        cerr << "Snapshot file " << fname << " is truncated" << endl;
+        return nullptr;
+    }
+    const size_t len = static_cast<size_t>(st.st_size);
+    void* p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+    {
+        cerr << "Could not map snapshot file " << fname << endl;
+        return nullptr;
+    }
+    snapshot->base = static_cast<const char*>(p);
+#else
+    // No mmap(): read the file into an 8-byte aligned buffer instead
+    ifstream in(fname, ios::binary | ios::ate);
+    if (not in)
+    {
+        cerr << "Could not open snapshot file " << fname << endl;
+        return nullptr;
+    }
+    const size_t len = static_cast<size_t>(in.tellg());
+    if (len < sizeof(SnapshotHeader))
+    {
+        cerr << "Snapshot file " << fname << " is truncated" << endl;
+        return nullptr;
+    }
+    snapshot->buffer.resize((len + 7) / 8);
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(snapshot->buffer.data()), static_cast<streamsize>(len));
+    if (not in)
+    {
+        cerr << "Could not read snapshot file " << fname << endl;
+        return nullptr;
+    }
+    snapshot->base = reinterpret_cast<const char*>(snapshot->buffer.data());
+#endif
+    snapshot->fileSize = len;
+    string error = snapshot->validate();
+    if (not error.empty())
+    {
+        cerr << "Invalid snapshot file " << fname << ": " << error << endl;
+        return nullptr;
+    }
+    return snapshot;
+}
+
+string FsmSnapshot::validate()
+{
+    const SnapshotHeader* header = reinterpret_cast<const SnapshotHeader*>(base);
+    if (memcmp(header->magic, snapshotMagic, sizeof(snapshotMagic)) != 0)
+    {
+        return "missing magic number";
+    }
+    if (header->byteOrder != byteOrderMark)
+    {
+        return "written on a host with different byte order";
+    }
+    if (header->version != formatVersion)
+    {
+        return "unsupported format version " + to_string(header->version);
+    }
+    if (header->fileSize != fileSize)
+    {
+        return "file size does not match the header";
+    }
+
+    numStates = header->numStates;
+    maxInput = header->maxInput;
+    maxOutput = header->maxOutput;
+    initState = header->initState;
+    numTransitions = header->numTransitions;
+    deterministic = (header->flags & flagDeterministic) != 0;
+    if (numStates < 0 or (numStates > 0 and (initState < 0 or initState >= numStates)))
+    {
+        return "illegal number of states or initial state";
+    }
+
+    // Section sizes follow from the section offsets
+    size_t sectionSize[NUM_SECTIONS];
+    for (int i = 0; i < NUM_SECTIONS; ++i)
+    {
+        const uint64_t from = header->sections[i];
+        const uint64_t to = (i + 1 < NUM_SECTIONS) ? header->sections[i + 1] : fileSize;
+        if (from < sizeof(SnapshotHeader) or from % 8 != 0 or from > to or to > fileSize)
+        {
+            return "corrupt section table";
+        }
+        sectionSize[i] = static_cast<size_t>(to - from);
+    }
+    auto section = [&](const SnapshotSection i) { return base + header->sections[i]; };
+
+    // Arrays may be followed by up to 7 bytes of padding
+    auto fits = [&](const SnapshotSection i, const size_t bytes)
+    {
+        return sectionSize[i] >= bytes and sectionSize[i] < bytes + 8;
+    };
+    auto checkTable = [&](const SnapshotSection i)
+    {
+        if (sectionSize[i] < sizeof(uint32_t))
+        {
+            return false;
+        }
+        const uint32_t* t = reinterpret_cast<const uint32_t*>(section(i));
+        const size_t n = t[0];
+        if (sectionSize[i] < (n + 2) * sizeof(uint32_t))
+        {
+            return false;
+        }
+        const size_t chars = sectionSize[i] - (n + 2) * sizeof(uint32_t);
+        return checkOffsets(t + 1, n, t[n + 1]) and t[n + 1] <= chars;
+    };
+
+    const size_t states = static_cast<size_t>(numStates);
+    const size_t transitions = numTransitions;
+    stateOffsets = reinterpret_cast<const uint32_t*>(section(STATE_OFFSETS));
+    inputs = reinterpret_cast<const int32_t*>(section(INPUTS));
+    outputs = reinterpret_cast<const int32_t*>(section(OUTPUTS));
+    targets = reinterpret_cast<const int32_t*>(section(TARGETS));
+    if (not fits(STATE_OFFSETS, (states + 1) * sizeof(uint32_t))
+        or not checkOffsets(stateOffsets, states, numTransitions)
+        or not fits(INPUTS, transitions * sizeof(int32_t))
+        or not fits(OUTPUTS, transitions * sizeof(int32_t))
+        or not fits(TARGETS, transitions * sizeof(int32_t))
+        or not checkRange(inputs, transitions, 0, maxInput)
+        or not checkRange(outputs, transitions, 0, maxOutput)
+        or not checkRange(targets, transitions, 0, numStates - 1))
+    {
+        return "corrupt transition table";
+    }
+
+    for (SnapshotSection i : { IN_NAMES, OUT_NAMES, STATE_NAMES, NODE_NAMES, REQ_NAMES, FSM_NAME })
+    {
+        if (not checkTable(i))
+        {
+            return "corrupt string table";
+        }
+    }
+    inNames = section(IN_NAMES);
+    outNames = section(OUT_NAMES);
+    stateNames = section(STATE_NAMES);
+    nodeNames = section(NODE_NAMES);
+    reqNames = section(REQ_NAMES);
+    fsmName = section(FSM_NAME);
+    if (tableSize(nodeNames) != states or tableSize(fsmName) != 1)
+    {
+        return "corrupt string table";
+    }
+
+    nodeIds = reinterpret_cast<const int32_t*>(section(NODE_IDS));
+    if (not fits(NODE_IDS, states * sizeof(int32_t))
+        or not checkRange(nodeIds, states, 0, INT32_MAX))
+    {
+        return "corrupt state table";
+    }
+
+    nodeReqOffsets = reinterpret_cast<const uint32_t*>(section(NODE_REQ_OFFSETS));
+    nodeReqs = reinterpret_cast<const uint32_t*>(section(NODE_REQS));
+    transReqOffsets = reinterpret_cast<const uint32_t*>(section(TRANS_REQ_OFFSETS));
+    transReqs = reinterpret_cast<const uint32_t*>(section(TRANS_REQS));
+    const int64_t maxReq = static_cast<int64_t>(tableSize(reqNames)) - 1;
+    if (not fits(NODE_REQ_OFFSETS, (states + 1) * sizeof(uint32_t))
+        or not checkOffsets(nodeReqOffsets, states, nodeReqOffsets[states])
+        or not fits(NODE_REQS, nodeReqOffsets[states] * sizeof(uint32_t))
+        or not checkRange(nodeReqs, nodeReqOffsets[states], 0, maxReq)
+        or not fits(TRANS_REQ_OFFSETS, (transitions + 1) * sizeof(uint32_t))
+        or not checkOffsets(transReqOffsets, transitions, transReqOffsets[transitions])
+        or not fits(TRANS_REQS, transReqOffsets[transitions] * sizeof(uint32_t))
+        or not checkRange(transReqs, transReqOffsets[transitions], 0, maxReq))
+    {
+        return "corrupt requirement table";
+    }
+
+    return "";
+}
+
+uint32_t FsmSnapshot::tableSize(const char* table)
+{
+    return reinterpret_cast<const uint32_t*>(table)[0];
+}
+
+string FsmSnapshot::tableEntry(const char* table, const uint32_t i)
+{
+    const uint32_t* t = reinterpret_cast<const uint32_t*>(table);
+    const char* chars = reinterpret_cast<const char*>(t + t[0] + 2);
+    return string(chars + t[i + 1], t[i + 2] - t[i + 1]);
+}
+
+string FsmSnapshot::getName() const
+{
+    return tableEntry(fsmName, 0);
+}
+
+shared_ptr<FsmPresentationLayer> FsmSnapshot::createPresentationLayer() const
+{
+    auto toVector = [](const char* table)
+    {
+        vector<string> v;
+        v.reserve(tableSize(table));
+        for (uint32_t i = 0; i < tableSize(table); ++i)
+        {
+            v.push_back(tableEntry(table, i));
+        }
+        return v;
+    };
+    return make_shared<FsmPresentationLayer>(toVector(inNames),
+                                             toVector(outNames),
+                                             toVector(stateNames));
+}
+
+shared_ptr<Fsm> FsmSnapshot::buildFsm(const string& name) const
+{
+    const shared_ptr<FsmPresentationLayer> pl = createPresentationLayer();
+
+    vector<string> reqs;
+    reqs.reserve(tableSize(reqNames));
+    for (uint32_t i = 0; i < tableSize(reqNames); ++i)
+    {
+        reqs.push_back(tableEntry(reqNames, i));
+    }
+
+    vector<shared_ptr<FsmNode>> nodes;
+    nodes.reserve(static_cast<size_t>(numStates));
+    for (int s = 0; s < numStates; ++s)
+    {
+        nodes.push_back(make_shared<FsmNode>(nodeIds[s], tableEntry(nodeNames, s), pl));
+        for (uint32_t r = nodeReqOffsets[s]; r < nodeReqOffsets[s + 1]; ++r)
+        {
+            nodes.back()->addSatisfies(reqs[nodeReqs[r]]);
+        }
+    }
+
+    for (int s = 0; s < numStates; ++s)
+    {
+        for (int t = begin(s); t < end(s); ++t)
+        {
+            auto tr = make_shared<FsmTransition>(nodes[s], nodes[targets[t]],
+                                                 make_shared<FsmLabel>(inputs[t], outputs[t], pl));
+            for (uint32_t r = transReqOffsets[t]; r < transReqOffsets[t + 1]; ++r)
+            {
+                tr->addSatisfies(reqs[transReqs[r]]);
+            }
+            nodes[s]->addTransition(tr);
+        }
+    }
+
+    return make_shared<Fsm>(name.empty() ? getName() : name,
+                            maxInput, maxOutput, nodes, initState, pl);
+}
+
+shared_ptr<Fsm> FsmSnapshot::createFsm(const string& name) const
+{
+    return buildFsm(name);
+}
+
+shared_ptr<Dfsm> FsmSnapshot::createDfsm(const string& name) const
+{
+    if (not deterministic)
+    {
+        return nullptr;
+    }
+    return make_shared<Dfsm>(*buildFsm(name));
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#ifndef FSM_FSM_FSMSNAPSHOT_H_
+#define FSM_FSM_FSMSNAPSHOT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Fsm;
+class Dfsm;
+class FsmPresentationLayer;
+
+/**
+ Read-only view of an FSM stored in the binary snapshot format.
+
+ A snapshot file consists of a fixed-size header followed by sections,
+ each starting at an 8-byte aligned offset recorded in the header:
+ - the transitions in CSR layout: the transitions of state s occupy
+   positions stateOffsets[s]..stateOffsets[s+1]-1 of the packed input,
+   output and target arrays, in the order in which they are stored in
+   the FsmNode;
+ - string tables for the input, output and state names of the
+   presentation layer, the requirement names and the FSM name;
+ - the id and the name prefix of each state, from which FsmNode::getName()
+   derives the state name if the presentation layer does not define it;
+ - the requirement tags of the states and of the transitions, given as
+   indices into the requirement name table, again in CSR layout.
+
+ A string table is a count n, followed by n+1 offsets into the
+ character data which follows them; string i occupies characters
+ offsets[i]..offsets[i+1]-1 and is not null-terminated.
+ All numbers are stored in host byte order, which is recorded in the
+ header, so that snapshots are only loaded on hosts of the same order.
+
+ open() maps the file into memory (on Windows, reads it into a buffer)
+ and checks the header and the section bounds; the accessors read directly from the mapping, without
+ copying or allocating anything. Only createFsm()/createDfsm(), which
+ build the FsmNode graph, allocate per state and per transition.
+ */
+class FsmSnapshot
+{
+private:
+    /** Start of the mapped file */
+    const char* base;
+
+    /** Size of the mapped file in bytes */
+    size_t fileSize;
+
+    /** Copy of the file if it cannot be mapped (Windows), empty otherwise */
+    std::vector<uint64_t> buffer;
+
+    const uint32_t* stateOffsets;
+    const int32_t* inputs;
+    const int32_t* outputs;
+    const int32_t* targets;
+    const char* inNames;
+    const char* outNames;
+    const char* stateNames;
+    const int32_t* nodeIds;
+    const char* nodeNames;
+    const char* reqNames;
+    const char* fsmName;
+    const uint32_t* nodeReqOffsets;
+    const uint32_t* nodeReqs;
+    const uint32_t* transReqOffsets;
+    const uint32_t* transReqs;
+
+    int32_t numStates;
+    int32_t maxInput;
+    int32_t maxOutput;
+    int32_t initState;
+    uint32_t numTransitions;
+    bool deterministic;
+
+    FsmSnapshot();
+    FsmSnapshot(const FsmSnapshot&) = delete;
+    FsmSnapshot& operator=(const FsmSnapshot&) = delete;
+
+    /**
+     * Check the header and the section bounds of the mapped file
+     * and set up the section pointers.
+     * @return An error message, empty if the snapshot is valid
+     */
+    std::string validate();
+
+    /** Number of strings of a string table */
+    static uint32_t tableSize(const char* table);
+
+    /** String i of a string table */
+    static std::string tableEntry(const char* table, const uint32_t i);
+
+    /** Build the FsmNode graph shared by createFsm() and createDfsm() */
+    std::shared_ptr<Fsm> buildFsm(const std::string& name) const;
+
+public:
+    /** Version of the snapshot format written by save() */
+    static const uint32_t formatVersion = 1;
+
+    ~FsmSnapshot();
+
+    /**
+     * Write an FSM to a snapshot file. The states are numbered by
+     * their position in the node list of the FSM; the node ids are
+     * stored separately.
+     * @return false if the file could not be written
+     */
+    static bool save(const Fsm& fsm, const std::string& fname);
+
+    /**
+     * Map a snapshot file into memory.
+     * @return The snapshot, or nullptr if the file could not be mapped
+     *         or is not a valid snapshot; the reason is written to cerr
+     */
+    static std::shared_ptr<FsmSnapshot> open(const std::string& fname);
+
+    /** Check whether a file starts with the snapshot magic number */
+    static bool isSnapshotFile(const std::string& fname);
+
+    int size() const { return numStates; }
+    int getMaxInput() const { return maxInput; }
+    int getMaxOutput() const { return maxOutput; }
+    int getInitStateIdx() const { return initState; }
+    int getNumTransitions() const { return static_cast<int>(numTransitions); }
+
+    /** True if the FSM was deterministic when it was saved */
+    bool isDeterministic() const { return deterministic; }
+
+    /** First transition of state s */
+    int begin(const int s) const { return static_cast<int>(stateOffsets[s]); }
+
+    /** One past the last transition of state s */
+    int end(const int s) const { return static_cast<int>(stateOffsets[s + 1]); }
+
+    int getInput(const int t) const { return inputs[t]; }
+    int getOutput(const int t) const { return outputs[t]; }
+    int getTarget(const int t) const { return targets[t]; }
+
+    std::string getName() const;
+
+    /** Create a presentation layer from the name tables */
+    std::shared_ptr<FsmPresentationLayer> createPresentationLayer() const;
+
+    /**
+     * Create the FSM stored in the snapshot, including the
+     * requirements satisfied by its states and transitions
+     * @param name Name of the FSM, the stored name if empty
+     */
+    std::shared_ptr<Fsm> createFsm(const std::string& name = "") const;
+
+    /**
+     * Create the DFSM stored in the snapshot
+     * @param name Name of the DFSM, the stored name if empty
+     * @return The DFSM, or nullptr if the snapshot is not deterministic
+     */
+    std::shared_ptr<Dfsm> createDfsm(const std::string& name = "") const;
+};
+#endif //FSM_FSM_FSMSNAPSHOT_H_
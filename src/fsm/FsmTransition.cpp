@@ -44,10 +44,22 @@ shared_ptr<FsmNode> FsmTransition::getTarget()
 
 void FsmTransition::setTarget(shared_ptr<FsmNode> tgt) {
     target = tgt;
+    FsmNode::structureChanged();
 }
 
 void FsmTransition::setLabel(std::shared_ptr<FsmLabel> lbl) {
+    bool inputChanged = (label->getInput() != lbl->getInput());
     label = lbl;
+    
+    // The source node indexes its transitions by input
+    if (inputChanged)
+    {
+        if (auto src = getSource())
+        {
+            src->reindexTransitions();
+        }
+    }
+    FsmNode::structureChanged();
 }
 
 
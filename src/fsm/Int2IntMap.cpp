@@ -6,9 +6,6 @@
 #include "fsm/Int2IntMap.h"
 
 Int2IntMap::Int2IntMap(const int maxInput)
+	: values(static_cast<size_t>(maxInput + 1), -1)
 {
-	for (int i = 0; i <= maxInput; ++ i)
-	{
-		this->insert(std::pair<int, int>(i, -1));
-	}
 }
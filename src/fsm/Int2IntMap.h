@@ -6,15 +6,59 @@
 #ifndef FSM_FSM_INT2INTMAP_H_
 #define FSM_FSM_INT2INTMAP_H_
 
-#include <map>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
 
-class Int2IntMap : public std::map<int, int>
+/**
+ Map from the dense key range 0..size()-1 to int values. The values
+ are stored contiguously, so that lookups are plain array accesses and
+ a map costs a single allocation, instead of one tree node per key.
+ */
+class Int2IntMap
 {
+private:
+    /** values[k] is the value associated with key k */
+    std::vector<int> values;
+    
 public:
     /**
-     * Create a standard map and initialise every element to -1
-     * @param maxInput The size of the map
+     * Create a map for the keys 0..maxInput and initialise every element to -1
+     * @param maxInput The maximal key of the map
      */
     Int2IntMap(const int maxInput);
+    
+    /** Return the number of keys, that is, maxInput+1 */
+    size_t size() const { return values.size(); }
+    
+    /**
+     * Access the value of key k.
+     * @throws std::out_of_range if k is not a key of the map
+     */
+    int& at(const int k) { return values.at(static_cast<size_t>(k)); }
+    const int& at(const int k) const { return values.at(static_cast<size_t>(k)); }
+    
+    /**
+     * Access the value of key k. If k exceeds the current key range,
+     * the range is extended to 0..k and the new values are set to -1.
+     * @param k The key, k >= 0. Negative keys, such as the -1 used for
+     *          missing values, are not keys of the map.
+     * @throws std::out_of_range if k is negative
+     */
+    int& operator[](const int k)
+    {
+        if (k < 0)
+        {
+            throw std::out_of_range("Int2IntMap: negative key");
+        }
+        if (static_cast<size_t>(k) >= values.size())
+        {
+            values.resize(static_cast<size_t>(k) + 1, -1);
+        }
+        return values[k];
+    }
+    
+    bool operator==(const Int2IntMap& other) const { return values == other.values; }
+    bool operator!=(const Int2IntMap& other) const { return values != other.values; }
 };
 #endif //FSM_FSM_INT2INTMAP_H_
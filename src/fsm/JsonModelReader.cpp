@@ -0,0 +1,774 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#include <cstdlib>
+#include <map>
+#include <stdexcept>
+
+#include "fsm/JsonModelReader.h"
+
+using namespace std;
+
+/** Size of the chunks read from the stream */
+static const size_t chunkSize = 1 << 16;
+
+/** Maximal nesting depth, as for Json::Reader */
+static const int maxDepth = 1000;
+
+JsonFsmModel::JsonFsmModel()
+    : isObject(false), haveInputs(false), haveOutputs(false), haveStates(false),
+      haveTransitions(false), haveRequirements(false)
+{
+}
+
+JsonFsmModel::JsonFsmModel(const Json::Value& fsmExport) : JsonFsmModel()
+{
+    isObject = fsmExport.isObject();
+    if (not isObject)
+    {
+        return;
+    }
+
+    const Json::Value& inputsVal = fsmExport["inputs"];
+    const Json::Value& outputsVal = fsmExport["outputs"];
+    const Json::Value& statesVal = fsmExport["states"];
+    const Json::Value& transitionsVal = fsmExport["transitions"];
+    haveInputs = inputsVal.isArray();
+    haveOutputs = outputsVal.isArray();
+    haveStates = statesVal.isArray();
+    haveTransitions = transitionsVal.isArray();
+    haveRequirements = fsmExport["requirements"].isArray();
+
+    // The Dfsm constructors do not look at the model if it is incomplete
+    if (not (haveInputs and haveOutputs and haveStates and haveTransitions and haveRequirements))
+    {
+        return;
+    }
+
+    for (const auto& input : inputsVal)
+    {
+        inputs.push_back(intern(input.asString()));
+    }
+    for (const auto& output : outputsVal)
+    {
+        outputs.push_back(intern(output.asString()));
+    }
+    for (const auto& state : statesVal)
+    {
+        State st;
+        st.name = intern(state["name"].asString());
+        st.initial = state["initial"].asBool();
+        appendList(state["requirements"], st.reqBegin, st.reqEnd);
+        states.push_back(st);
+    }
+    for (const auto& transition : transitionsVal)
+    {
+        Transition tr;
+        tr.source = intern(transition["source"].asString());
+        tr.target = intern(transition["target"].asString());
+        tr.output = intern(transition["output"].asString());
+        appendList(transition["input"], tr.inBegin, tr.inEnd);
+        appendList(transition["requirements"], tr.reqBegin, tr.reqEnd);
+        transitions.push_back(tr);
+    }
+}
+
+int JsonFsmModel::intern(const string& s)
+{
+    auto it = stringIndex.find(s);
+    if (it != stringIndex.end())
+    {
+        return it->second;
+    }
+    int idx = static_cast<int>(strings.size());
+    stringIndex.emplace(s, idx);
+    strings.push_back(s);
+    return idx;
+}
+
+void JsonFsmModel::appendList(const Json::Value& lst, int& begin, int& end)
+{
+    begin = static_cast<int>(pool.size());
+    for (const auto& elem : lst)
+    {
+        pool.push_back(intern(elem.asString()));
+    }
+    end = static_cast<int>(pool.size());
+}
+
+JsonModelReader::JsonModelReader()
+    : in(nullptr), buffer(chunkSize), pos(0), len(0), line(1)
+{
+}
+
+bool JsonModelReader::fill()
+{
+    if (pos < len)
+    {
+        return true;
+    }
+    if (in == nullptr or not *in)
+    {
+        return false;
+    }
+    in->read(buffer.data(), static_cast<streamsize>(buffer.size()));
+    len = static_cast<size_t>(in->gcount());
+    pos = 0;
+    return len > 0;
+}
+
+int JsonModelReader::peek()
+{
+    return fill() ? static_cast<unsigned char>(buffer[pos]) : -1;
+}
+
+int JsonModelReader::get()
+{
+    if (not fill())
+    {
+        return -1;
+    }
+    char c = buffer[pos++];
+    if (c == '\n')
+    {
+        ++line;
+    }
+    return static_cast<unsigned char>(c);
+}
+
+bool JsonModelReader::fail(const string& msg)
+{
+    if (error.empty())
+    {
+        error = "Line " + to_string(line) + ": " + msg;
+    }
+    return false;
+}
+
+int JsonModelReader::skipSpace()
+{
+    for (;;)
+    {
+        int c = peek();
+        if (c == ' ' or c == '\t' or c == '\r' or c == '\n')
+        {
+            get();
+        }
+        else if (c == '/')
+        {
+            get();
+            c = get();
+            if (c == '/')
+            {
+                while (c != '\n' and c != '\r' and c != -1) c = get();
+            }
+            else if (c == '*')
+            {
+                int prev = 0;
+                for (c = get(); c != -1 and not (prev == '*' and c == '/'); c = get())
+                {
+                    prev = c;
+                }
+                if (c == -1)
+                {
+                    fail("Unterminated comment");
+                    return -1;
+                }
+            }
+            else
+            {
+                fail("Syntax error: value, object or array expected.");
+                return -1;
+            }
+        }
+        else
+        {
+            return c;
+        }
+    }
+}
+
+bool JsonModelReader::expect(const char c)
+{
+    if (skipSpace() != c)
+    {
+        return fail(string("Missing '") + c + "'");
+    }
+    get();
+    return true;
+}
+
+bool JsonModelReader::readString(string& s)
+{
+    s.clear();
+    get(); // opening quote
+    for (;;)
+    {
+        int c = get();
+        if (c == -1)
+        {
+            return fail("Missing '\"' at end of string");
+        }
+        if (c == '"')
+        {
+            return true;
+        }
+        if (c != '\\')
+        {
+            s.push_back(static_cast<char>(c));
+            continue;
+        }
+        c = get();
+        switch (c)
+        {
+            case '"': s.push_back('"'); break;
+            case '/': s.push_back('/'); break;
+            case '\\': s.push_back('\\'); break;
+            case 'b': s.push_back('\b'); break;
+            case 'f': s.push_back('\f'); break;
+            case 'n': s.push_back('\n'); break;
+            case 'r': s.push_back('\r'); break;
+            case 't': s.push_back('\t'); break;
+            case 'u':
+            {
+                auto hex4 = [&](unsigned int& cp)
+                {
+                    cp = 0;
+                    for (int i = 0; i < 4; ++i)
+                    {
+                        int h = get();
+                        cp <<= 4;
+                        if (h >= '0' and h <= '9') cp += h - '0';
+                        else if (h >= 'a' and h <= 'f') cp += h - 'a' + 10;
+                        else if (h >= 'A' and h <= 'F') cp += h - 'A' + 10;
+                        else return false;
+                    }
+                    return true;
+                };
+                unsigned int cp;
+                if (not hex4(cp))
+                {
+                    return fail("Bad unicode escape sequence in string");
+                }
+                if (cp >= 0xD800 and cp <= 0xDBFF)
+                {
+                    unsigned int low;
+                    if (get() != '\\' or get() != 'u' or not hex4(low))
+                    {
+                        return fail("expecting another \\u token to begin the second half of a unicode surrogate pair");
+                    }
+                    cp = 0x10000 + ((cp & 0x3FF) << 10) + (low & 0x3FF);
+                }
+                // Encode as UTF-8
+                if (cp <= 0x7F)
+                {
+                    s.push_back(static_cast<char>(cp));
+                }
+                else if (cp <= 0x7FF)
+                {
+                    s.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+                    s.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+                }
+                else if (cp <= 0xFFFF)
+                {
+                    s.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+                    s.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                    s.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+                }
+                else
+                {
+                    s.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+                    s.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+                    s.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                    s.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+                }
+                break;
+            }
+            default:
+                return fail("Bad escape sequence in string");
+        }
+    }
+}
+
+bool JsonModelReader::readLiteral(const char* literal)
+{
+    for (const char* p = literal; *p; ++p)
+    {
+        if (get() != *p)
+        {
+            return fail("Syntax error: value, object or array expected.");
+        }
+    }
+    return true;
+}
+
+bool JsonModelReader::readNumber(Json::Value& v)
+{
+    // Same token boundaries as Json::Reader::readNumber()
+    string token;
+    auto digits = [&]()
+    {
+        for (int c = peek(); c >= '0' and c <= '9'; c = peek())
+        {
+            token.push_back(static_cast<char>(get()));
+        }
+    };
+    if (peek() == '-')
+    {
+        token.push_back(static_cast<char>(get()));
+    }
+    digits();
+    bool integral = true;
+    if (peek() == '.')
+    {
+        integral = false;
+        token.push_back(static_cast<char>(get()));
+        digits();
+    }
+    if (peek() == 'e' or peek() == 'E')
+    {
+        integral = false;
+        token.push_back(static_cast<char>(get()));
+        if (peek() == '+' or peek() == '-')
+        {
+            token.push_back(static_cast<char>(get()));
+        }
+        digits();
+    }
+
+    // Same decoding as Json::Reader::decodeNumber(): integers which do
+    // not fit into the largest integer type are decoded as doubles
+    if (integral)
+    {
+        const bool negative = token[0] == '-';
+        const Json::Value::LargestUInt maxValue = negative ?
+            Json::Value::LargestUInt(-Json::Value::minLargestInt) : Json::Value::maxLargestUInt;
+        Json::Value::LargestUInt value = 0;
+        bool fits = true;
+        for (size_t i = negative ? 1 : 0; i < token.size() and fits; ++i)
+        {
+            Json::Value::UInt digit(token[i] - '0');
+            fits = value < maxValue / 10 or
+                   (value == maxValue / 10 and i + 1 == token.size() and digit <= maxValue % 10);
+            value = value * 10 + digit;
+        }
+        if (fits)
+        {
+            if (negative)
+                v = -Json::Value::LargestInt(value);
+            else if (value <= Json::Value::LargestUInt(Json::Value::maxInt))
+                v = Json::Value::LargestInt(value);
+            else
+                v = value;
+            return true;
+        }
+    }
+    char* end = nullptr;
+    double d = strtod(token.c_str(), &end);
+    if (end == token.c_str())
+    {
+        return fail("'" + token + "' is not a number.");
+    }
+    v = d;
+    return true;
+}
+
+bool JsonModelReader::readScalar(Json::Value& v)
+{
+    int c = skipSpace();
+    switch (c)
+    {
+        case '"':
+        {
+            string s;
+            if (not readString(s)) return false;
+            v = s;
+            return true;
+        }
+        case 't':
+            v = true;
+            return readLiteral("true");
+        case 'f':
+            v = false;
+            return readLiteral("false");
+        case 'n':
+            v = Json::Value();
+            return readLiteral("null");
+        case '{':
+        case '[':
+            return fail("Type is not convertible to string");
+        default:
+            if (c == '-' or (c >= '0' and c <= '9'))
+            {
+                return readNumber(v);
+            }
+            return fail("Syntax error: value, object or array expected.");
+    }
+}
+
+template <typename F>
+bool JsonModelReader::readObject(F member)
+{
+    get(); // opening brace
+    if (skipSpace() == '}')
+    {
+        get();
+        return true;
+    }
+    string key;
+    for (;;)
+    {
+        if (skipSpace() != '"')
+        {
+            return fail("Missing '}' or object member name");
+        }
+        if (not readString(key) or not expect(':') or not member(key))
+        {
+            return false;
+        }
+        int c = skipSpace();
+        get();
+        if (c == '}')
+        {
+            return true;
+        }
+        if (c != ',')
+        {
+            return fail("Missing ',' or '}' in object declaration");
+        }
+    }
+}
+
+template <typename F>
+bool JsonModelReader::readArray(F element)
+{
+    get(); // opening bracket
+    if (skipSpace() == ']')
+    {
+        get();
+        return true;
+    }
+    for (;;)
+    {
+        if (not element())
+        {
+            return false;
+        }
+        int c = skipSpace();
+        get();
+        if (c == ']')
+        {
+            return true;
+        }
+        if (c != ',')
+        {
+            return fail("Missing ',' or ']' in array declaration");
+        }
+    }
+}
+
+bool JsonModelReader::skipValue()
+{
+    // Explicit stack of the open brackets, so that deeply nested
+    // values do not exhaust the call stack
+    vector<char> open;
+    for (;;)
+    {
+        int c = skipSpace();
+        if (c == '{' or c == '[')
+        {
+            if (open.size() >= static_cast<size_t>(maxDepth))
+            {
+                return fail("Exceeded stackLimit in readValue().");
+            }
+            get();
+            open.push_back(c == '{' ? '}' : ']');
+            c = skipSpace();
+            if (c == open.back())
+            {
+                get();
+                open.pop_back();
+            }
+            else
+            {
+                if (open.back() == '}')
+                {
+                    string key;
+                    if (c != '"' or not readString(key) or not expect(':'))
+                    {
+                        return fail("Missing '}' or object member name");
+                    }
+                }
+                continue;
+            }
+        }
+        else
+        {
+            Json::Value v;
+            if (not readScalar(v))
+            {
+                return false;
+            }
+        }
+
+        // A value has been completed: continue with the enclosing
+        // array or object
+        for (;;)
+        {
+            if (open.empty())
+            {
+                return true;
+            }
+            c = skipSpace();
+            get();
+            if (c == open.back())
+            {
+                open.pop_back();
+                continue;
+            }
+            if (c != ',')
+            {
+                return fail(open.back() == '}' ? "Missing ',' or '}' in object declaration"
+                                               : "Missing ',' or ']' in array declaration");
+            }
+            if (open.back() == '}')
+            {
+                string key;
+                if (skipSpace() != '"' or not readString(key) or not expect(':'))
+                {
+                    return fail("Missing '}' or object member name");
+                }
+            }
+            break;
+        }
+    }
+}
+
+bool JsonModelReader::readList(JsonFsmModel& model, int& begin, int& end)
+{
+    begin = end = static_cast<int>(model.pool.size());
+    int c = skipSpace();
+    if (c == '[')
+    {
+        bool ok = readArray([&]()
+        {
+            Json::Value v;
+            if (not readScalar(v)) return false;
+            model.pool.push_back(model.intern(v.asString()));
+            return true;
+        });
+        end = static_cast<int>(model.pool.size());
+        return ok;
+    }
+    if (c == '{')
+    {
+        // Json::Value iterates over the member values ordered by name;
+        // a repeated member replaces the earlier one
+        map<string, int> members;
+        bool ok = readObject([&](const string& key)
+        {
+            Json::Value v;
+            if (not readScalar(v)) return false;
+            members[key] = model.intern(v.asString());
+            return true;
+        });
+        for (const auto& m : members)
+        {
+            model.pool.push_back(m.second);
+        }
+        end = static_cast<int>(model.pool.size());
+        return ok;
+    }
+    return skipValue();
+}
+
+bool JsonModelReader::readStringArray(JsonFsmModel& model, vector<int>& lst, bool& isArray)
+{
+    lst.clear();
+    isArray = (skipSpace() == '[');
+    if (not isArray)
+    {
+        return skipValue();
+    }
+    return readArray([&]()
+    {
+        Json::Value v;
+        if (not readScalar(v)) return false;
+        lst.push_back(model.intern(v.asString()));
+        return true;
+    });
+}
+
+bool JsonModelReader::readState(JsonFsmModel& model)
+{
+    JsonFsmModel::State st;
+    st.name = -1;
+    st.initial = false;
+    st.reqBegin = st.reqEnd = static_cast<int>(model.pool.size());
+
+    int c = skipSpace();
+    if (c == '{')
+    {
+        bool ok = readObject([&](const string& key)
+        {
+            Json::Value v;
+            if (key == "name")
+            {
+                if (not readScalar(v)) return false;
+                st.name = model.intern(v.asString());
+                return true;
+            }
+            if (key == "initial")
+            {
+                if (not readScalar(v)) return false;
+                if (v.isString())
+                {
+                    return fail("Value is not convertible to bool.");
+                }
+                st.initial = v.asBool();
+                return true;
+            }
+            if (key == "requirements")
+            {
+                return readList(model, st.reqBegin, st.reqEnd);
+            }
+            return skipValue();
+        });
+        if (not ok) return false;
+    }
+    else if (c == 'n')
+    {
+        // A null element behaves like an empty object
+        if (not readLiteral("null")) return false;
+    }
+    else
+    {
+        return fail("Value is not an object");
+    }
+
+    if (st.name < 0)
+    {
+        st.name = model.intern("");
+    }
+    model.states.push_back(st);
+    return true;
+}
+
+bool JsonModelReader::readStates(JsonFsmModel& model)
+{
+    model.states.clear();
+    model.haveStates = (skipSpace() == '[');
+    if (not model.haveStates)
+    {
+        return skipValue();
+    }
+    return readArray([&]() { return readState(model); });
+}
+
+bool JsonModelReader::readTransition(JsonFsmModel& model)
+{
+    JsonFsmModel::Transition tr;
+    tr.source = tr.target = tr.output = -1;
+    tr.inBegin = tr.inEnd = tr.reqBegin = tr.reqEnd = static_cast<int>(model.pool.size());
+
+    int c = skipSpace();
+    if (c == '{')
+    {
+        bool ok = readObject([&](const string& key)
+        {
+            Json::Value v;
+            int* field = nullptr;
+            if (key == "source") field = &tr.source;
+            else if (key == "target") field = &tr.target;
+            else if (key == "output") field = &tr.output;
+            if (field != nullptr)
+            {
+                if (not readScalar(v)) return false;
+                *field = model.intern(v.asString());
+                return true;
+            }
+            if (key == "input")
+            {
+                return readList(model, tr.inBegin, tr.inEnd);
+            }
+            if (key == "requirements")
+            {
+                return readList(model, tr.reqBegin, tr.reqEnd);
+            }
+            return skipValue();
+        });
+        if (not ok) return false;
+    }
+    else if (c == 'n')
+    {
+        if (not readLiteral("null")) return false;
+    }
+    else
+    {
+        return fail("Value is not an object");
+    }
+
+    for (int* field : { &tr.source, &tr.target, &tr.output })
+    {
+        if (*field < 0)
+        {
+            *field = model.intern("");
+        }
+    }
+    model.transitions.push_back(tr);
+    return true;
+}
+
+bool JsonModelReader::readTransitions(JsonFsmModel& model)
+{
+    model.transitions.clear();
+    model.haveTransitions = (skipSpace() == '[');
+    if (not model.haveTransitions)
+    {
+        return skipValue();
+    }
+    return readArray([&]() { return readTransition(model); });
+}
+
+bool JsonModelReader::read(istream& input, JsonFsmModel& model)
+{
+    model = JsonFsmModel();
+    in = &input;
+    pos = len = 0;
+    line = 1;
+    error.clear();
+
+    // As for Json::Reader, anything following the top-level value is ignored
+    model.isObject = (skipSpace() == '{');
+    if (not model.isObject)
+    {
+        return skipValue();
+    }
+
+    return readObject([&](const string& key)
+    {
+        if (key == "inputs")
+        {
+            return readStringArray(model, model.inputs, model.haveInputs);
+        }
+        if (key == "outputs")
+        {
+            return readStringArray(model, model.outputs, model.haveOutputs);
+        }
+        if (key == "states")
+        {
+            return readStates(model);
+        }
+        if (key == "transitions")
+        {
+            return readTransitions(model);
+        }
+        if (key == "requirements")
+        {
+            model.haveRequirements = (skipSpace() == '[');
+        }
+        return skipValue();
+    });
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#ifndef FSM_FSM_JSONMODELREADER_H_
+#define FSM_FSM_JSONMODELREADER_H_
+
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "json/json.h"
+
+/**
+ Compact form of an FSM exported in JSON format, holding exactly the
+ data used by the Dfsm JSON constructors: the "inputs", "outputs",
+ "states" and "transitions" arrays, and whether "requirements" is
+ present. All strings are stored once in a string table and referred
+ to by their index. The lists of a transition or state are stored as
+ ranges of a common index pool.
+
+ The model can be filled from a jsoncpp DOM or, without building a DOM,
+ by JsonModelReader. Scalars are converted to strings and booleans as
+ Json::Value::asString() and Json::Value::asBool() do.
+ */
+struct JsonFsmModel
+{
+    struct State
+    {
+        int name;
+        bool initial;
+        /** Requirements at pool positions reqBegin..reqEnd-1 */
+        int reqBegin;
+        int reqEnd;
+    };
+
+    struct Transition
+    {
+        int source;
+        int target;
+        int output;
+        /** Inputs at pool positions inBegin..inEnd-1 */
+        int inBegin;
+        int inEnd;
+        /** Requirements at pool positions reqBegin..reqEnd-1 */
+        int reqBegin;
+        int reqEnd;
+    };
+
+    /** True if the top-level value is an object */
+    bool isObject;
+
+    /** True if the respective top-level member is an array */
+    bool haveInputs;
+    bool haveOutputs;
+    bool haveStates;
+    bool haveTransitions;
+    bool haveRequirements;
+
+    /** String table */
+    std::vector<std::string> strings;
+
+    std::vector<int> inputs;
+    std::vector<int> outputs;
+    std::vector<State> states;
+    std::vector<Transition> transitions;
+
+    /** String indices of the input and requirement lists */
+    std::vector<int> pool;
+
+    JsonFsmModel();
+
+    /** Extract the model from a parsed JSON document */
+    explicit JsonFsmModel(const Json::Value& fsmExport);
+
+    /** Return the index of a string, adding it to the string table if needed */
+    int intern(const std::string& s);
+
+private:
+    std::unordered_map<std::string, int> stringIndex;
+
+    /** Append the strings of a JSON list to the pool */
+    void appendList(const Json::Value& lst, int& begin, int& end);
+};
+
+/**
+ Event-driven reader for FSMs exported in JSON format.
+
+ The document is tokenised from a stream in fixed-size chunks. The
+ tokens are consumed as they are produced: the members of the model
+ are stored in a JsonFsmModel, all other values are skipped, so that
+ memory use is bounded by the size of the model instead of the size
+ of a jsoncpp DOM. The reader accepts the syntax accepted by
+ Json::Reader with default features, including comments; as there,
+ a repeated object member replaces the earlier one.
+ */
+class JsonModelReader
+{
+private:
+    std::istream* in;
+
+    /** Chunk of the stream currently tokenised */
+    std::vector<char> buffer;
+    size_t pos;
+    size_t len;
+
+    /** Line of the current position, for error messages */
+    size_t line;
+
+    std::string error;
+
+    /** Current character, or -1 at the end of the stream */
+    int peek();
+    int get();
+    bool fill();
+
+    /** Skip whitespace and comments, then return the current character */
+    int skipSpace();
+
+    bool expect(const char c);
+    bool fail(const std::string& msg);
+
+    /** Scalar token, converted to a jsoncpp value */
+    bool readScalar(Json::Value& v);
+    bool readString(std::string& s);
+    bool readLiteral(const char* literal);
+    bool readNumber(Json::Value& v);
+
+    /** Skip any value without storing it */
+    bool skipValue();
+
+    /**
+     * Read a list of scalars converted to strings, as iterated by
+     * a range-based for loop over a Json::Value: the elements of an
+     * array, the member values of an object in key order, nothing
+     * for null or a scalar
+     */
+    bool readList(JsonFsmModel& model, int& begin, int& end);
+
+    /** Read a string array member of the top-level object */
+    bool readStringArray(JsonFsmModel& model, std::vector<int>& lst, bool& isArray);
+
+    bool readStates(JsonFsmModel& model);
+    bool readState(JsonFsmModel& model);
+    bool readTransitions(JsonFsmModel& model);
+    bool readTransition(JsonFsmModel& model);
+
+    /**
+     * Iterate over the members of an object; the current position
+     * must be at the opening brace
+     * @param member Called with the name of each member, positioned at its value
+     */
+    template <typename F>
+    bool readObject(F member);
+
+    /**
+     * Iterate over the elements of an array; the current position
+     * must be at the opening bracket
+     * @param element Called for each element, positioned at its value
+     */
+    template <typename F>
+    bool readArray(F element);
+
+public:
+    JsonModelReader();
+
+    /**
+     * Read a JSON model from a stream
+     * @param input The stream containing the JSON document
+     * @param model Receives the model
+     * @return false if the document is not valid JSON, or if a
+     *         member of the model has a type that Json::Value
+     *         cannot convert as required
+     */
+    bool read(std::istream& input, JsonFsmModel& model);
+
+    /** Description of the error detected by read() */
+    const std::string& getError() const { return error; }
+};
+#endif //FSM_FSM_JSONMODELREADER_H_
@@ -0,0 +1,201 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#include <algorithm>
+
+#include "fsm/MutationAnalysis.h"
+#include "sets/ParallelFor.h"
+
+using namespace std;
+
+/** Number of mutants simulated together */
+static const size_t lanes = 64;
+
+MutationAnalysis::MutationAnalysis(const DfsmExecutionTable& reference,
+                                   const vector<DfsmExecutionTable>& mutants,
+                                   const vector<vector<int>>& testCases)
+    : numInputs(reference.getNumInputs()), mutants(mutants),
+      words((mutants.size() + lanes - 1) / lanes)
+{
+    offsets.reserve(testCases.size() + 1);
+    offsets.push_back(0);
+    for (const auto& tc : testCases)
+    {
+        inputs.insert(inputs.end(), tc.begin(), tc.end());
+        offsets.push_back(inputs.size());
+    }
+
+    expected.assign(inputs.size(), -1);
+    expectedLengths.reserve(testCases.size());
+    for (size_t k = 0; k < testCases.size(); ++k)
+    {
+        expectedLengths.push_back(reference.apply(inputs.data() + offsets[k],
+                                                  offsets[k + 1] - offsets[k],
+                                                  expected.data() + offsets[k]));
+    }
+
+    killBitmaps.assign(testCases.size() * words, 0);
+    killed.assign(words, 0);
+}
+
+void MutationAnalysis::runBatch(const size_t b, const bool dropKilled)
+{
+    const size_t first = b * lanes;
+    const size_t numLanes = min(lanes, mutants.size() - first);
+
+    /* Interleaved tables of the batch. An additional sink state is entered
+     by undefined transitions and never left; its outputs are -1, so that
+     every mutant entering the sink differs from the reference. */
+    int sink = 0;
+    for (size_t lane = 0; lane < numLanes; ++lane)
+    {
+        sink = max(sink, mutants[first + lane].size());
+    }
+    const size_t rows = (static_cast<size_t>(sink) + 1) * numInputs;
+    vector<int32_t> next(rows * lanes, sink);
+    vector<int32_t> out(rows * lanes, -1);
+    vector<int32_t> init(lanes, sink);
+    for (size_t lane = 0; lane < numLanes; ++lane)
+    {
+        const DfsmExecutionTable& m = mutants[first + lane];
+        for (int s = 0; s < m.size(); ++s)
+        {
+            for (int x = 0; x < numInputs; ++x)
+            {
+                int t = m.getNext(s, x);
+                if (t >= 0)
+                {
+                    size_t idx = (static_cast<size_t>(s) * numInputs + x) * lanes + lane;
+                    next[idx] = t;
+                    out[idx] = m.getOutput(s, x);
+                }
+            }
+        }
+        if (m.getInitState() >= 0 and m.getInitState() < m.size())
+        {
+            init[lane] = m.getInitState();
+        }
+    }
+
+    const uint64_t batchMask = (numLanes == lanes) ? ~uint64_t(0) : ((uint64_t(1) << numLanes) - 1);
+    uint64_t notKilled = batchMask;
+    vector<int32_t> state(lanes);
+
+    for (size_t k = 0; k < expectedLengths.size(); ++k)
+    {
+        if (dropKilled and notKilled == 0)
+        {
+            break;
+        }
+        const int* in = inputs.data() + offsets[k];
+        const int* exp = expected.data() + offsets[k];
+        const size_t len = offsets[k + 1] - offsets[k];
+        const size_t expLen = expectedLengths[k];
+
+        uint64_t alive = dropKilled ? notKilled : batchMask;
+        uint64_t killedByTc = 0;
+        copy(init.begin(), init.end(), state.begin());
+
+        /* All lanes are simulated, including the retired ones, so that the
+         loop has no branches; the retired lanes are masked out. */
+        for (size_t i = 0; i < expLen and alive != 0; ++i)
+        {
+            const size_t x = static_cast<size_t>(in[i]);
+            const int32_t y = exp[i];
+            uint64_t diverged = 0;
+            for (size_t lane = 0; lane < lanes; ++lane)
+            {
+                size_t idx = (static_cast<size_t>(state[lane]) * numInputs + x) * lanes + lane;
+                diverged |= static_cast<uint64_t>(out[idx] != y) << lane;
+                state[lane] = next[idx];
+            }
+            diverged &= alive;
+            killedByTc |= diverged;
+            alive &= ~diverged;
+        }
+
+        /* The reference does not accept input expLen, so a mutant
+         accepting it produces an unexpected output */
+        if (alive != 0 and expLen < len and in[expLen] >= 0 and in[expLen] < numInputs)
+        {
+            const size_t x = static_cast<size_t>(in[expLen]);
+            uint64_t accepted = 0;
+            for (size_t lane = 0; lane < lanes; ++lane)
+            {
+                size_t idx = (static_cast<size_t>(state[lane]) * numInputs + x) * lanes + lane;
+                accepted |= static_cast<uint64_t>(out[idx] >= 0) << lane;
+            }
+            killedByTc |= accepted & alive;
+        }
+
+        killBitmaps[k * words + b] = killedByTc;
+        notKilled &= ~killedByTc;
+    }
+
+    killed[b] = batchMask & ~notKilled;
+}
+
+void MutationAnalysis::run(const unsigned int numThreads, const bool dropKilled)
+{
+    fill(killBitmaps.begin(), killBitmaps.end(), 0);
+    fill(killed.begin(), killed.end(), 0);
+
+    // Every batch writes its own word of the bitmaps only
+    parallelFor(words, numThreads, [&](size_t b, unsigned int)
+    {
+        runBatch(b, dropKilled);
+    });
+}
+
+const uint64_t* MutationAnalysis::getKillBitmap(const size_t k) const
+{
+    return killBitmaps.data() + k * words;
+}
+
+bool MutationAnalysis::kills(const size_t k, const size_t m) const
+{
+    return (killBitmaps[k * words + m / lanes] >> (m % lanes)) & 1;
+}
+
+bool MutationAnalysis::isKilled(const size_t m) const
+{
+    return (killed[m / lanes] >> (m % lanes)) & 1;
+}
+
+size_t MutationAnalysis::getNumKilled() const
+{
+    size_t n = 0;
+    for (uint64_t w : killed)
+    {
+        // Count the bits by clearing the lowest one repeatedly
+        for (; w != 0; w &= w - 1)
+        {
+            ++n;
+        }
+    }
+    return n;
+}
+
+double MutationAnalysis::getMutationScore() const
+{
+    if (mutants.empty())
+    {
+        return 1.0;
+    }
+    return static_cast<double>(getNumKilled()) / static_cast<double>(mutants.size());
+}
+
+void MutationAnalysis::printKillMatrix(ostream& out) const
+{
+    for (size_t k = 0; k < getNumTestCases(); ++k)
+    {
+        out << k << " ";
+        for (size_t m = 0; m < mutants.size(); ++m)
+        {
+            out << (kills(k, m) ? 'x' : '.');
+        }
+        out << endl;
+    }
+}
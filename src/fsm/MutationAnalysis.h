@@ -0,0 +1,134 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#ifndef FSM_FSM_MUTATIONANALYSIS_H_
+#define FSM_FSM_MUTATIONANALYSIS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "fsm/DfsmExecutionTable.h"
+
+/**
+ Kill matrix of a test suite against a set of DFSM mutants.
+
+ Test case t kills mutant m if the mutant does not pass the I/O trace
+ produced by the reference DFSM for the inputs of t, in the sense of
+ DfsmExecutionTable::pass(): the mutant has to process exactly the maximal
+ prefix of the inputs accepted by the reference, producing the same
+ outputs.
+
+ The mutants are simulated in batches of 64. The transition tables of
+ the mutants of a batch are interleaved, so that entry (s, x) of all
+ mutants is stored in one block of 64 lanes, and the current states of
+ the batch are kept in an array of 64 lanes as well. An input is applied
+ to all mutants of the batch at once, and the lanes whose output
+ differs from the expected one are collected in a 64-bit word. Killed
+ mutants are retired from the simulation of the test case, and a test
+ case is aborted as soon as all mutants of the batch are killed.
+ The batches are processed concurrently.
+ */
+class MutationAnalysis
+{
+private:
+    /** Number of inputs, that is, maxInput+1 */
+    int numInputs;
+
+    /** Execution tables of the mutants */
+    std::vector<DfsmExecutionTable> mutants;
+
+    /** Concatenated inputs of all test cases */
+    std::vector<int> inputs;
+
+    /** Test case k occupies positions offsets[k]..offsets[k+1]-1 of inputs */
+    std::vector<size_t> offsets;
+
+    /**
+     * Outputs of the reference DFSM, stored at the positions of the inputs;
+     * only the first expectedLengths[k] outputs of test case k are defined.
+     */
+    std::vector<int> expected;
+
+    /** Length of the maximal prefix of test case k accepted by the reference */
+    std::vector<size_t> expectedLengths;
+
+    /** Number of 64-bit words of a kill bitmap */
+    size_t words;
+
+    /**
+     * Kill bitmaps: bit m%64 of word killBitmaps[k*words + m/64] is set
+     * if test case k kills mutant m
+     */
+    std::vector<uint64_t> killBitmaps;
+
+    /** Union of the kill bitmaps of all test cases */
+    std::vector<uint64_t> killed;
+
+    /**
+     * Run all test cases against batch b of the mutants and set the
+     * bits of word b of the kill bitmaps
+     * @param dropKilled If true, a mutant is only run until it is killed
+     */
+    void runBatch(const size_t b, const bool dropKilled);
+
+public:
+    /**
+     * Prepare the analysis of a test suite against a set of mutants
+     * @param reference Execution table of the reference DFSM
+     * @param mutants Execution tables of the mutants
+     * @param testCases Input traces of the test suite
+     */
+    MutationAnalysis(const DfsmExecutionTable& reference,
+                     const std::vector<DfsmExecutionTable>& mutants,
+                     const std::vector<std::vector<int>>& testCases);
+
+    /**
+     * Calculate the kill matrix
+     * @param numThreads Number of worker threads, each processing one batch
+     *        of 64 mutants at a time (0: one per hardware thread)
+     * @param dropKilled If true, a mutant is not run against the test cases
+     *        following the first one killing it. Then the kill bitmap of a
+     *        test case only contains the mutants killed first by this test
+     *        case, but the mutation score is the same.
+     */
+    void run(const unsigned int numThreads = 1, const bool dropKilled = false);
+
+    size_t getNumMutants() const { return mutants.size(); }
+    size_t getNumTestCases() const { return expectedLengths.size(); }
+
+    /** Number of 64-bit words of a kill bitmap */
+    size_t getNumWords() const { return words; }
+
+    /**
+     * Return the kill bitmap of test case k: bit m%64 of word m/64 is set
+     * if the test case kills mutant m
+     */
+    const uint64_t* getKillBitmap(const size_t k) const;
+
+    /** Check whether test case k kills mutant m */
+    bool kills(const size_t k, const size_t m) const;
+
+    /** Check whether mutant m is killed by any test case */
+    bool isKilled(const size_t m) const;
+
+    /** Number of mutants killed by the test suite */
+    size_t getNumKilled() const;
+
+    /**
+     * Return the mutation score, that is, the fraction of the mutants
+     * killed by the test suite, or 1 if there are no mutants
+     */
+    double getMutationScore() const;
+
+    /**
+     * Write the kill matrix, one line per test case: the number of the
+     * test case, followed by one character per mutant, 'x' if the mutant
+     * is killed by the test case, '.' otherwise.
+     */
+    void printKillMatrix(std::ostream& out) const;
+};
+#endif //FSM_FSM_MUTATIONANALYSIS_H_
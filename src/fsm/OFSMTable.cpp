@@ -210,6 +210,14 @@ shared_ptr<OFSMTable> OFSMTable::next()
 	return haveNewClasses ? next : nullptr;
 }
 
+shared_ptr<OFSMTable> OFSMTable::next(const S2CMap & nextS2C) const
+{
+	shared_ptr<OFSMTable> next = make_shared<OFSMTable>(numStates, maxInput, maxOutput, rows, presentationLayer);
+	next->tblId = tblId + 1;
+	next->setS2C(nextS2C);
+	return next;
+}
+
 string OFSMTable::getMembers(const int c) const
 {
 	string memSet = "{";
@@ -255,9 +263,31 @@ Fsm OFSMTable::toFsm(const string & name, bool prependFsmName) const
      * but states should have new names including the set of
      *  original nodes that are equivalent.
      */
+    const int numClasses = maxClassId() + 1;
+    
+    /* Collect the members of all classes in a single pass over the
+     * states, this yields the same strings as getMembers(). The first
+     * member of each class is used as its representative below.
+     */
+    vector<string> members(numClasses, "{");
+    vector<int> classRep(numClasses, -1);
+    for (int i = 0; i < numStates; ++ i)
+    {
+        int c = s2c.at(i);
+        if (classRep[c] < 0)
+        {
+            classRep[c] = i;
+        }
+        else
+        {
+            members[c] += ",";
+        }
+        members[c] += presentationLayer->getStateId(i,"");
+    }
+    
     vector<string> minState2String;
-    for (int i = 0; i <= maxClassId(); ++i) {
-        string newName(getMembers(i));
+    for (int i = 0; i < numClasses; ++i) {
+        string newName(members[i] + "}");
         if (prependFsmName)
         {
             newName = minFsmName + " " + newName;
@@ -275,7 +305,7 @@ Fsm OFSMTable::toFsm(const string & name, bool prependFsmName) const
      * For external names of the new states, we use their
      * sets of equivalent states, as stored in minState2String
      */
-	for (int i = 0; i <= maxClassId(); ++ i)
+	for (int i = 0; i < numClasses; ++ i)
 	{
 		shared_ptr<FsmNode> newNode =
             make_shared<FsmNode>(i, minState2String[i], minPl);
@@ -292,20 +322,13 @@ Fsm OFSMTable::toFsm(const string & name, bool prependFsmName) const
          */
         int classId = srcNode->getId();
 
-		/* Find the first OFSMTableRow where the associated original
+		/* Take the first OFSMTableRow where the associated original
          * FsmState belongs to class classId.
          * Since other rows associated with the same class have
          * equivalent post-states, we only need to
-		 * find one representative row.
+		 * use one representative row.
          */
-		shared_ptr<OFSMTableRow> row = nullptr;
-		for (int i = 0; i < numStates && row == nullptr; i++)
-		{
-			if (classId == s2c.at(i))
-			{
-				row = rows[i];
-			}
-		}
+		shared_ptr<OFSMTableRow> row = rows[classRep[classId]];
 
 		/*
          * Process all outgoing transitions of the original
@@ -322,26 +345,15 @@ Fsm OFSMTable::toFsm(const string & name, bool prependFsmName) const
 					/* Get the class id of the target node in the original FSM */
 					int tgtClassId = s2c.at(tgtStateId);
 
-					/* Find the new FsmNode in the minimised FSM
-                     * which has tgtClassId as node id
+					/* Remember: all nodes in nodeLst have an id
+                     * which equals their class id and their position.
+                     * Create the transition with label x/y
+                     * and target node of class tgtClassId
                      */
-					for (shared_ptr<FsmNode> tgtNode : nodeLst)
-                    {
-                        /* Remember: all nodes in nodeLst have an id
-                         * which equals their class id.
-                         */
-                        if (tgtNode->getId() == tgtClassId)
-						{
-							/* Create the transition with label x/y
-                             * and target node tgtNode
-                             */
-							shared_ptr<FsmTransition> tr = make_shared<FsmTransition>(srcNode,
-                                                                                      tgtNode,
-                                                                                      make_shared<FsmLabel>(x, y, minPl));
-							srcNode->addTransition(tr);
-							break;
-						}
-					}
+					shared_ptr<FsmTransition> tr = make_shared<FsmTransition>(srcNode,
+                                                                              nodeLst[tgtClassId],
+                                                                              make_shared<FsmLabel>(x, y, minPl));
+					srcNode->addTransition(tr);
 				}
 			}
 		}
@@ -122,6 +122,15 @@ public:
 	*/
 	std::shared_ptr<OFSMTable> next();
 
+	/**
+	Create the next OFSMTable on the basis of the current table,
+	using a mapping from states to classes that has already been
+	calculated, e.g. by a SignatureRefinement.
+	@param nextS2C The mapping from states to classes of the new table
+	@return The next OFSMTable
+	*/
+	std::shared_ptr<OFSMTable> next(const S2CMap & nextS2C) const;
+
 	/**
 	Return members of an equivalence class c as set string
 	*/
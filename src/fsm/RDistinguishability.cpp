@@ -35,6 +35,13 @@ void RDistinguishability::initRDistinguishable(size_t i)
     {
         LOG(WARNING) << "Overwriting r-distinguishability.";
         rDistinguishableWith[i] = {};
+        for (size_t& at : distinguishedAt)
+        {
+            if (at == i)
+            {
+                at = 0;
+            }
+        }
     }
 }
 
@@ -49,6 +56,24 @@ void RDistinguishability::addRDistinguishable(size_t i, std::shared_ptr<FsmNode>
     {
         it->second.push_back(node->getId());
     }
+    size_t id = static_cast<size_t>(node->getId());
+    if (id >= distinguishedAt.size())
+    {
+        distinguishedAt.resize(id + 1, 0);
+    }
+    if (distinguishedAt[id] == 0 || distinguishedAt[id] > i)
+    {
+        distinguishedAt[id] = i;
+    }
+}
+
+size_t RDistinguishability::getDistinguishedAt(int id) const
+{
+    if (id < 0 || static_cast<size_t>(id) >= distinguishedAt.size())
+    {
+        return 0;
+    }
+    return distinguishedAt[id];
 }
 
 void RDistinguishability::addNotRDistinguishable(size_t i, std::shared_ptr<FsmNode> node)
@@ -104,33 +129,13 @@ bool RDistinguishability::isNotRDistinguishable()
 
 bool RDistinguishability::isRDistinguishableWith(size_t i, std::shared_ptr<FsmNode> node)
 {
-    for (; i > 0; --i)
-    {
-        try {
-            auto dist = rDistinguishableWith.at(i);
-            if ( std::find(dist.begin(), dist.end(), node->getId()) != dist.end() )
-            {
-                return true;
-            }
-        } catch (out_of_range e) {
-            continue;
-        }
-
-    }
-    return false;
+    size_t at = getDistinguishedAt(node->getId());
+    return at != 0 && at <= i;
 }
 
 bool RDistinguishability::isRDistinguishableWith(std::shared_ptr<FsmNode> node)
 {
-    for (auto it = rDistinguishableWith.rbegin(); it != rDistinguishableWith.rend(); ++it)
-    {
-        vector<int> dist = it->second;
-        if ( std::find(dist.begin(), dist.end(), node->getId()) != dist.end() )
-        {
-            return true;
-        }
-    }
-    return false;
+    return getDistinguishedAt(node->getId()) != 0;
 }
 
 bool RDistinguishability::isRDistinguishableWith(vector<shared_ptr<FsmNode>> nodes)
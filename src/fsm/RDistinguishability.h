@@ -38,6 +38,19 @@ protected:
      * that state from the state that corresponds to the `RDistinguishability` instance.
      */
     std::map<int, std::shared_ptr<InputOutputTree>> adaptiveIOSequences;
+
+    /**
+     * This vector holds for every state id the smallest `i` such that the state is
+     * r(i)-distinguishable from the state that corresponds to the `RDistinguishability`
+     * instance, or 0, if no such `i` is known.
+     */
+    std::vector<size_t> distinguishedAt;
+
+    /**
+     * Returns the smallest `i` such that the state with the given id is
+     * r(i)-distinguishable, 0 if there is none.
+     */
+    size_t getDistinguishedAt(int id) const;
 public:
     /**
      * Removes a given state from the set that holds the states that are not r(i)-distinguishable
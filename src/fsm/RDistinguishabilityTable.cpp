@@ -0,0 +1,223 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#include <algorithm>
+
+#include "fsm/RDistinguishabilityTable.h"
+#include "fsm/CsrTransitionTable.h"
+#include "sets/ParallelFor.h"
+
+using namespace std;
+
+RDistinguishabilityTable::RDistinguishabilityTable(const shared_ptr<CsrTransitionTable>& csr)
+    : csr(csr), numStates(csr->size()), level(0), numDistinguished(0)
+{
+    words = (static_cast<size_t>(numStates) + 63) / 64;
+    distinguished.assign(static_cast<size_t>(numStates) * words, 0);
+    lastDistinguished.assign(static_cast<size_t>(numStates) * words, 0);
+
+    /* Invert the transition relation, grouping the predecessors of
+     every state by input */
+    const size_t stride = static_cast<size_t>(csr->getMaxInput()) + 2;
+    predOffsets.assign(static_cast<size_t>(numStates) * stride, 0);
+    for (int t = 0; t < csr->getNumTransitions(); ++t)
+    {
+        ++predOffsets[csr->getTarget(t) * stride + csr->getInput(t) + 1];
+    }
+    for (size_t i = 1; i < predOffsets.size(); ++i)
+    {
+        predOffsets[i] += predOffsets[i - 1];
+    }
+    predStates.resize(csr->getNumTransitions());
+    predOutputs.resize(csr->getNumTransitions());
+    vector<int> nextPos(predOffsets);
+    for (int s = 0; s < numStates; ++s)
+    {
+        for (int t = csr->begin(s); t < csr->end(s); ++t)
+        {
+            int pos = nextPos[csr->getTarget(t) * stride + csr->getInput(t)]++;
+            predStates[pos] = s;
+            predOutputs[pos] = csr->getOutput(t);
+        }
+    }
+}
+
+int RDistinguishabilityTable::calcFirstLevelInput(const int q1, const int q2) const
+{
+    for (int x = 0; x <= csr->getMaxInput(); ++x)
+    {
+        bool disjoint = true;
+        for (int t1 = csr->begin(q1, x); disjoint && t1 < csr->end(q1, x); ++t1)
+        {
+            for (int t2 = csr->begin(q2, x); t2 < csr->end(q2, x); ++t2)
+            {
+                if (csr->getOutput(t1) == csr->getOutput(t2))
+                {
+                    disjoint = false;
+                    break;
+                }
+            }
+        }
+        if (disjoint)
+        {
+            return x;
+        }
+    }
+    return -1;
+}
+
+int RDistinguishabilityTable::calcNextLevelInput(const int q1, const int q2) const
+{
+    for (int x = 0; x <= csr->getMaxInput(); ++x)
+    {
+        bool isDistinguishable = true;
+        for (int t1 = csr->begin(q1, x); isDistinguishable && t1 < csr->end(q1, x); ++t1)
+        {
+            for (int t2 = csr->begin(q2, x); t2 < csr->end(q2, x); ++t2)
+            {
+                if (csr->getOutput(t1) != csr->getOutput(t2))
+                {
+                    continue;
+                }
+                int s1 = csr->getTarget(t1);
+                int s2 = csr->getTarget(t2);
+                if (s1 == s2 || !test(distinguished, s1, s2))
+                {
+                    isDistinguishable = false;
+                    break;
+                }
+            }
+        }
+        if (isDistinguishable)
+        {
+            return x;
+        }
+    }
+    return -1;
+}
+
+template <typename F>
+vector<RDistinguishabilityTable::Entry>
+RDistinguishabilityTable::evaluate(const vector<pair<int,int>>& candidates,
+                                   const unsigned int numThreads,
+                                   F calcInput)
+{
+    /* The candidates only read the bit matrices of the current level,
+     so they are examined concurrently in chunks */
+    vector<int> inputs(candidates.size(), -1);
+    parallelForChunks(candidates.size(), 256, numThreads, [&](size_t begin, size_t end, unsigned int)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            inputs[i] = calcInput(candidates[i].first, candidates[i].second);
+        }
+    });
+
+    vector<Entry> result;
+    fill(lastDistinguished.begin(), lastDistinguished.end(), 0);
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        if (inputs[i] < 0)
+        {
+            continue;
+        }
+        result.push_back({candidates[i].first, candidates[i].second, inputs[i]});
+        set(distinguished, candidates[i].first, candidates[i].second);
+        set(lastDistinguished, candidates[i].first, candidates[i].second);
+    }
+    numDistinguished += result.size();
+    ++level;
+    return result;
+}
+
+vector<RDistinguishabilityTable::Entry> RDistinguishabilityTable::calcFirstLevel(const unsigned int numThreads)
+{
+    vector<pair<int,int>> candidates;
+    candidates.reserve(static_cast<size_t>(numStates) * (numStates - 1) / 2);
+    for (int q1 = 0; q1 < numStates; ++q1)
+    {
+        for (int q2 = q1 + 1; q2 < numStates; ++q2)
+        {
+            candidates.emplace_back(q1, q2);
+        }
+    }
+    return evaluate(candidates, numThreads, [this](int q1, int q2)
+    {
+        return calcFirstLevelInput(q1, q2);
+    });
+}
+
+vector<RDistinguishabilityTable::Entry> RDistinguishabilityTable::calcNextLevel(const unsigned int numThreads)
+{
+    /* Mark the pairs having a successor pair which has become
+     distinguishable in the last round, in row min(q1,q2) only */
+    const size_t stride = static_cast<size_t>(csr->getMaxInput()) + 2;
+    vector<uint64_t> marked(distinguished.size(), 0);
+    for (int p1 = 0; p1 < numStates; ++p1)
+    {
+        for (size_t w = static_cast<size_t>(p1) >> 6; w < words; ++w)
+        {
+            uint64_t bits = lastDistinguished[p1 * words + w];
+            for (int b = 0; bits != 0; ++b, bits >>= 1)
+            {
+                int p2 = static_cast<int>(w * 64) + b;
+                if ((bits & 1) == 0 || p2 <= p1)
+                {
+                    continue;
+                }
+                for (int x = 0; x <= csr->getMaxInput(); ++x)
+                {
+                    size_t i1 = p1 * stride + x;
+                    size_t i2 = p2 * stride + x;
+                    for (int k1 = predOffsets[i1]; k1 < predOffsets[i1 + 1]; ++k1)
+                    {
+                        for (int k2 = predOffsets[i2]; k2 < predOffsets[i2 + 1]; ++k2)
+                        {
+                            int q1 = predStates[k1];
+                            int q2 = predStates[k2];
+                            if (q1 == q2 || predOutputs[k1] != predOutputs[k2])
+                            {
+                                continue;
+                            }
+                            if (q1 > q2)
+                            {
+                                swap(q1, q2);
+                            }
+                            if (!test(distinguished, q1, q2))
+                            {
+                                marked[q1 * words + (q2 >> 6)] |= uint64_t(1) << (q2 & 63);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    vector<pair<int,int>> candidates;
+    for (int q1 = 0; q1 < numStates; ++q1)
+    {
+        for (size_t w = 0; w < words; ++w)
+        {
+            uint64_t bits = marked[q1 * words + w];
+            for (int b = 0; bits != 0; ++b, bits >>= 1)
+            {
+                if ((bits & 1) != 0)
+                {
+                    candidates.emplace_back(q1, static_cast<int>(w * 64) + b);
+                }
+            }
+        }
+    }
+    return evaluate(candidates, numThreads, [this](int q1, int q2)
+    {
+        return calcNextLevelInput(q1, q2);
+    });
+}
+
+bool RDistinguishabilityTable::allDistinguished() const
+{
+    return numDistinguished == static_cast<size_t>(numStates) * (numStates - 1) / 2;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#ifndef FSM_FSM_RDISTINGUISHABILITYTABLE_H_
+#define FSM_FSM_RDISTINGUISHABILITYTABLE_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class CsrTransitionTable;
+
+/**
+ Fixpoint engine for the r(l)-distinguishability of the states of an
+ observable FSM, operating on state indices of a CsrTransitionTable.
+
+ The pairs which are r(l)-distinguishable for the current level l are
+ kept in a symmetric bit matrix, the pairs that became distinguishable
+ in the last round in a second one. A state pair can only become
+ r(l+1)-distinguishable if one of its successor pairs became
+ r(l)-distinguishable in the last round, so each round only examines
+ the predecessor pairs of the last round's pairs. The examination of
+ these candidates only reads the bit matrices of the previous level,
+ so it is distributed over worker threads.
+ */
+class RDistinguishabilityTable
+{
+public:
+    /** A state pair q1 < q2 which is r-distinguished by input x */
+    struct Entry {
+        int q1;
+        int q2;
+        int x;
+    };
+
+private:
+    std::shared_ptr<CsrTransitionTable> csr;
+
+    /** Number of states */
+    int numStates;
+
+    /** Number of 64-bit words per row of a bit matrix */
+    size_t words;
+
+    /** Pairs which are r(level)-distinguishable */
+    std::vector<uint64_t> distinguished;
+
+    /** Pairs which became r-distinguishable at the current level */
+    std::vector<uint64_t> lastDistinguished;
+
+    /** The current level, 0 before calcFirstLevel() has been called */
+    size_t level;
+
+    /** Number of unordered state pairs which are distinguishable */
+    size_t numDistinguished;
+
+    /**
+     * Predecessors of state s reached with input x are stored at
+     * predOffsets[s*(maxInput+2)+x]..predOffsets[s*(maxInput+2)+x+1]-1
+     * of predStates and predOutputs.
+     */
+    std::vector<int> predOffsets;
+    std::vector<int> predStates;
+    std::vector<int> predOutputs;
+
+    bool test(const std::vector<uint64_t>& m, const int q1, const int q2) const
+    {
+        return (m[q1 * words + (q2 >> 6)] >> (q2 & 63)) & 1;
+    }
+
+    void set(std::vector<uint64_t>& m, const int q1, const int q2)
+    {
+        m[q1 * words + (q2 >> 6)] |= uint64_t(1) << (q2 & 63);
+        m[q2 * words + (q1 >> 6)] |= uint64_t(1) << (q1 & 63);
+    }
+
+    /**
+     * Return the smallest input x for which q1 and q2 share no output
+     * (level 1), or -1 if no such input exists.
+     */
+    int calcFirstLevelInput(const int q1, const int q2) const;
+
+    /**
+     * Return the smallest input x such that all pairs of states reached
+     * from q1 and q2 with x and a common output are distinct and
+     * r(level)-distinguishable, or -1 if no such input exists.
+     */
+    int calcNextLevelInput(const int q1, const int q2) const;
+
+    /**
+     * Evaluate calcInput on every candidate pair, using numThreads
+     * worker threads, and record the distinguished ones as the pairs
+     * of the next level.
+     * @return The newly distinguished pairs, in the order of candidates
+     */
+    template <typename F>
+    std::vector<Entry> evaluate(const std::vector<std::pair<int,int>>& candidates,
+                                const unsigned int numThreads,
+                                F calcInput);
+
+public:
+    /**
+     * Create the engine for an observable FSM
+     * @param csr Transition table of the FSM
+     */
+    RDistinguishabilityTable(const std::shared_ptr<CsrTransitionTable>& csr);
+
+    /**
+     * Calculate the r(1)-distinguishable pairs: pairs having an input
+     * for which both states do not share any output.
+     * @param numThreads Number of worker threads (0: one per hardware thread)
+     * @return The r(1)-distinguishable pairs ordered by q1 and q2, each
+     *         with the smallest input distinguishing it
+     */
+    std::vector<Entry> calcFirstLevel(const unsigned int numThreads = 1);
+
+    /**
+     * Calculate the pairs which are r(l+1)-distinguishable, but not
+     * r(l)-distinguishable, where l is the current level, and advance
+     * to level l+1.
+     * @param numThreads Number of worker threads (0: one per hardware thread)
+     * @return The new pairs ordered by q1 and q2, each with the smallest
+     *         input distinguishing it
+     */
+    std::vector<Entry> calcNextLevel(const unsigned int numThreads = 1);
+
+    /** The current level */
+    size_t getLevel() const { return level; }
+
+    /** Return true if and only if q1 and q2 are r(level)-distinguishable */
+    bool isDistinguished(const int q1, const int q2) const
+    {
+        return test(distinguished, q1, q2);
+    }
+
+    /** Return true if and only if all pairs of distinct states are distinguishable */
+    bool allDistinguished() const;
+};
+#endif //FSM_FSM_RDISTINGUISHABILITYTABLE_H_
@@ -0,0 +1,143 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#include <algorithm>
+#include <unordered_map>
+
+#include "fsm/SignatureRefinement.h"
+#include "fsm/CsrTransitionTable.h"
+
+using namespace std;
+
+SignatureRefinement::SignatureRefinement(const CsrTransitionTable& csr)
+: numStates(csr.size())
+{
+    const int numOutputs = csr.getMaxOutput() + 1;
+    
+    offsets.reserve(numStates + 1);
+    labels.reserve(csr.getNumTransitions());
+    targets.reserve(csr.getNumTransitions());
+    
+    vector<pair<int, int>> entries;
+    for (int s = 0; s < numStates; ++s)
+    {
+        offsets.push_back(static_cast<int>(labels.size()));
+        
+        entries.clear();
+        for (int t = csr.begin(s); t < csr.end(s); ++t)
+        {
+            entries.push_back(make_pair(csr.getInput(t) * numOutputs + csr.getOutput(t),
+                                        csr.getTarget(t)));
+        }
+        sort(entries.begin(), entries.end());
+        
+        for (const auto& e : entries)
+        {
+            labels.push_back(e.first);
+            targets.push_back(e.second);
+        }
+    }
+    offsets.push_back(static_cast<int>(labels.size()));
+    signature.resize(labels.size());
+}
+
+bool SignatureRefinement::splitByLabels(S2CMap& s2c)
+{
+    signature = labels;
+    return split(s2c);
+}
+
+bool SignatureRefinement::splitByPostClasses(S2CMap& s2c)
+{
+    for (size_t t = 0; t < targets.size(); ++t)
+    {
+        signature[t] = s2c.at(targets[t]);
+    }
+    return split(s2c);
+}
+
+size_t SignatureRefinement::hash(const int s, const int c) const
+{
+    size_t h = static_cast<size_t>(c) * 0x9e3779b97f4a7c15ULL;
+    for (int t = offsets[s]; t < offsets[s + 1]; ++t)
+    {
+        h = (h ^ static_cast<size_t>(signature[t])) * 0x100000001b3ULL;
+    }
+    return h ^ static_cast<size_t>(offsets[s + 1] - offsets[s]);
+}
+
+bool SignatureRefinement::sameSignature(const int s1, const int s2) const
+{
+    if (offsets[s1 + 1] - offsets[s1] != offsets[s2 + 1] - offsets[s2])
+    {
+        return false;
+    }
+    return equal(signature.begin() + offsets[s1],
+                 signature.begin() + offsets[s1 + 1],
+                 signature.begin() + offsets[s2]);
+}
+
+bool SignatureRefinement::split(S2CMap& s2c) const
+{
+    int maxClassId = 0;
+    for (int s = 0; s < numStates; ++s)
+    {
+        maxClassId = max(maxClassId, s2c.at(s));
+    }
+    
+    // Number the subsets of each class in the order of their
+    // smallest state: subset[s] is the number of the subset of s
+    // within its class, numSubsets[c] the number of subsets of class c
+    vector<int> subset(numStates);
+    vector<int> numSubsets(maxClassId + 1, 0);
+    unordered_map<size_t, vector<int>> buckets;
+    buckets.reserve(numStates);
+    
+    for (int s = 0; s < numStates; ++s)
+    {
+        const int c = s2c.at(s);
+        vector<int>& reps = buckets[hash(s, c)];
+        
+        int found = -1;
+        for (int r : reps)
+        {
+            if (s2c.at(r) == c and sameSignature(r, s))
+            {
+                found = r;
+                break;
+            }
+        }
+        
+        if (found >= 0)
+        {
+            subset[s] = subset[found];
+        }
+        else
+        {
+            subset[s] = numSubsets[c]++;
+            reps.push_back(s);
+        }
+    }
+    
+    // The first subset of class c keeps id c, the others get
+    // consecutive new ids, class by class
+    vector<int> firstNewId(maxClassId + 1);
+    int nextId = maxClassId + 1;
+    for (int c = 0; c <= maxClassId; ++c)
+    {
+        firstNewId[c] = nextId;
+        nextId += max(0, numSubsets[c] - 1);
+    }
+    
+    for (int s = 0; s < numStates; ++s)
+    {
+        if (subset[s] > 0)
+        {
+            s2c[s] = firstNewId[s2c.at(s)] + subset[s] - 1;
+        }
+    }
+    
+    return nextId > maxClassId + 1;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#ifndef FSM_FSM_SIGNATUREREFINEMENT_H_
+#define FSM_FSM_SIGNATUREREFINEMENT_H_
+
+#include <vector>
+
+#include "fsm/typedef.inc"
+
+class CsrTransitionTable;
+
+/**
+ Partition refinement for observable FSMs, calculating the same
+ sequence of state-to-class mappings as the OFSMTable::next() chain.
+
+ In each round, every state gets a signature over its defined labels
+ x/y only: in the first round the labels themselves, in later rounds
+ the classes of the post-states reached by these labels. States of the
+ same class are split according to their signatures, using a hash of
+ the signature for bucketing. The new classes are numbered as in
+ OFSMTable::next(): the subset containing the smallest state of a
+ class keeps the class id, the other subsets get the next unused ids,
+ ordered by class and by their smallest state.
+ */
+class SignatureRefinement
+{
+private:
+    /** Number of states */
+    int numStates;
+
+    /** Labels of state s are stored at offsets[s]..offsets[s+1]-1 */
+    std::vector<int> offsets;
+
+    /** Packed labels x*(maxOutput+1)+y, sorted by x and y for each state */
+    std::vector<int> labels;
+
+    /** Packed post-state indices associated with the labels */
+    std::vector<int> targets;
+
+    /** Signature values of the current round, same layout as labels */
+    std::vector<int> signature;
+
+    /**
+     * Split the classes of s2c according to the current signatures
+     * @return true if and only if new classes have been created
+     */
+    bool split(S2CMap& s2c) const;
+
+    /** Hash value of the signature of state s in class c */
+    size_t hash(const int s, const int c) const;
+
+    /** Return true if and only if s1 and s2 have the same signature */
+    bool sameSignature(const int s1, const int s2) const;
+
+public:
+    /**
+     * Create the refinement engine for an observable FSM
+     * @param csr Transition table of the FSM
+     */
+    SignatureRefinement(const CsrTransitionTable& csr);
+
+    /**
+     * Split the classes of s2c such that states remain in the same
+     * class if and only if they have outgoing transitions for exactly
+     * the same set of labels. This corresponds to the step from the
+     * initial OFSMTable to the second one.
+     * @param s2c Mapping from states to classes, refined in place
+     * @return true if and only if new classes have been created
+     */
+    bool splitByLabels(S2CMap& s2c);
+
+    /**
+     * Split the classes of s2c such that states remain in the same
+     * class if and only if their post-states under every label are in
+     * the same class. This corresponds to OFSMTable::next() after the
+     * second table.
+     * @param s2c Mapping from states to classes, refined in place
+     * @return true if and only if new classes have been created
+     */
+    bool splitByPostClasses(S2CMap& s2c);
+};
+#endif //FSM_FSM_SIGNATUREREFINEMENT_H_
@@ -10,17 +10,27 @@
 #include <cstdlib>
 #include <cstring>
 #include <utility>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <vector>
 
+#include "logging/easylogging++.h"
 #include "interface/FsmPresentationLayer.h"
 #include "fsm/Dfsm.h"
+#include "fsm/FsmSnapshot.h"
+#include "fsm/JsonModelReader.h"
 #include "fsm/PkTable.h"
 #include "fsm/FsmNode.h"
 #include "fsm/IOTrace.h"
 #include "fsm/SegmentedTrace.h"
 
+#include "sets/ParallelFor.h"
 #include "trees/IOListContainer.h"
 #include "trees/OutputTree.h"
 #include "trees/TestSuite.h"
+#include "trees/TestSuiteWriter.h"
 
 #define DBG 0
 using namespace std;
@@ -33,7 +43,8 @@ using namespace Json;
 typedef enum {
     FSM_CSV,
     FSM_JSON,
-    FSM_BASIC
+    FSM_BASIC,
+    FSM_SNAPSHOT
 } model_type_t;
 
 typedef enum {
@@ -47,30 +58,75 @@ typedef enum {
 } generation_method_t;
 
 
-/** File containing the reference model */
-static model_type_t modelType;
-static string modelFile;
-
-/** only for generation method SAFE_WPMETHOD */
-static model_type_t modelAbstractionType;
-static string modelAbstractionFile;
-static string plStateFile;
-static string plInputFile;
-static string plOutputFile;
-static string fsmName;
-static string testSuiteFileName;
-static string tcFilePrefix;
-static generation_method_t genMethod;
-static unsigned int numAddStates;
-
-static shared_ptr<FsmPresentationLayer> pl = nullptr;
-static shared_ptr<Dfsm> dfsm = nullptr;
-static shared_ptr<Dfsm> dfsmAbstraction = nullptr;
-static shared_ptr<Fsm> fsm = nullptr;
-static shared_ptr<Fsm> fsmAbstraction = nullptr;
+/**
+ *   Configuration and models of one test suite generation job.
+ *   A single generator run processes one context, a batch run
+ *   processes one context per job of the batch manifest.
+ */
+struct GeneratorContext {
+    
+    /** File containing the reference model */
+    model_type_t modelType;
+    string modelFile;
+    
+    /** only for generation method SAFE_WPMETHOD */
+    model_type_t modelAbstractionType;
+    string modelAbstractionFile;
+    string plStateFile;
+    string plInputFile;
+    string plOutputFile;
+    string fsmName;
+    string testSuiteFileName;
+    string tcFilePrefix;
+    generation_method_t genMethod;
+    unsigned int numAddStates;
+    unsigned int numThreads;
+    
+    shared_ptr<FsmPresentationLayer> pl;
+    shared_ptr<Dfsm> dfsm;
+    shared_ptr<Dfsm> dfsmAbstraction;
+    shared_ptr<Fsm> fsm;
+    shared_ptr<Fsm> fsmAbstraction;
+    
+    bool isDeterministic;
+    bool rttMbtStyle;
+    
+    /** Write the model in dot and csv format after reading it */
+    bool writeModelFiles;
+    
+    /** If not empty, save the model in binary snapshot format to this file */
+    string snapshotFile;
+    
+    /** Write the test suite in prefix tree format instead of text format */
+    bool trieFormat;
+    
+    GeneratorContext() :
+    modelType(FSM_BASIC),
+    modelAbstractionType(FSM_BASIC),
+    fsmName("FSM"),
+    testSuiteFileName("testsuite.txt"),
+    genMethod(WPMETHOD),
+    numAddStates(0),
+    numThreads(1),
+    isDeterministic(false),
+    rttMbtStyle(false),
+    writeModelFiles(true),
+    trieFormat(false) { }
+};
 
-static bool isDeterministic = false;
-static bool rttMbtStyle = false;
+/**
+ *   Options of a batch run, see runBatch()
+ */
+struct BatchOptions {
+    /** Manifest listing the jobs, empty if not in batch mode */
+    string manifestFile;
+    /** File receiving one timing record per job */
+    string timingFile;
+    /** Number of jobs processed concurrently (0: one per hardware thread) */
+    unsigned int numWorkers;
+    
+    BatchOptions() : timingFile("timing.csv"), numWorkers(1) { }
+};
 
 
 /**
@@ -78,7 +134,9 @@ static bool rttMbtStyle = false;
  * @param name program name as specified in argv[0]
  */
 static void printUsage(char* name) {
-    cerr << "usage: " << name << " [-w|-wp|-h|-hsi] [-s] [-n fsmname] [-p infile outfile statefile] [-a additionalstates] [-t testsuitename] [-rtt <prefix>] modelfile [model abstraction file]" << endl;
+    cerr << "usage: " << name << " [-w|-wp|-h|-hsi] [-s] [-n fsmname] [-p infile outfile statefile] [-a additionalstates] [-j threads] [-t testsuitename] [-trie] [-rtt <prefix>] [-snapshot snapshotfile] modelfile [model abstraction file]" << endl;
+    cerr << "       " << name << " -batch manifest [-j threads] [-timing timingfile] [-trie] [-n fsmname] [-p infile outfile statefile]" << endl;
+    cerr << "       each manifest line specifies a job: modelfile w|wp|h|hsi additionalstates testsuitename" << endl;
 }
 
 /**
@@ -94,9 +152,16 @@ static void printUsage(char* name) {
  *
  *  @return FSM_CSV, if the model file has extension .csv
  *
+ *  @return FSM_SNAPSHOT, if the model file is a binary snapshot,
+ *                        see FsmSnapshot
+ *
  */
 static model_type_t getModelType(const string& mf) {
     
+    if ( FsmSnapshot::isSnapshotFile(mf) ) {
+        return FSM_SNAPSHOT;
+    }
+    
     if ( mf.find(".csv") != string::npos ) {
         return FSM_CSV;
     }
@@ -123,58 +188,56 @@ static model_type_t getModelType(const string& mf) {
  *
  * @param argc parameter 1 from main() invocation
  * @param argv parameter 2 from main() invocation
+ * @param ctx receives the options of a single generation
+ * @param batch receives the options of a batch run
  */
-static void parseParameters(int argc, char* argv[]) {
-    
-    // Set default parameters
-    genMethod = WPMETHOD;
-    fsmName = string("FSM");
-    testSuiteFileName = string("testsuite.txt");
-    numAddStates = 0;
+static void parseParameters(int argc, char* argv[],
+                            GeneratorContext& ctx,
+                            BatchOptions& batch) {
     
     bool haveModelFileName = false;
     
     for ( int p = 1; p < argc; p++ ) {
         
         if ( strcmp(argv[p],"-w") == 0 ) {
-            switch (genMethod) {
-                case WPMETHOD: genMethod = WMETHOD;
+            switch (ctx.genMethod) {
+                case WPMETHOD: ctx.genMethod = WMETHOD;
                     break;
-                case SAFE_WPMETHOD: genMethod = SAFE_WMETHOD;
+                case SAFE_WPMETHOD: ctx.genMethod = SAFE_WMETHOD;
                     break;
                 default:
                     break;
             }
         }
         else if ( strcmp(argv[p],"-wp") == 0 ) {
-            if ( genMethod == SAFE_WMETHOD or
-                genMethod == SAFE_WPMETHOD ) {
-                genMethod= SAFE_WPMETHOD;
+            if ( ctx.genMethod == SAFE_WMETHOD or
+                ctx.genMethod == SAFE_WPMETHOD ) {
+                ctx.genMethod= SAFE_WPMETHOD;
             }
             else {
-                genMethod = WPMETHOD;
+                ctx.genMethod = WPMETHOD;
             }
         }
         else if ( strcmp(argv[p],"-h") == 0 ) {
-            if ( genMethod == SAFE_WMETHOD or
-                genMethod == SAFE_WPMETHOD or
-                genMethod == SAFE_HMETHOD ) {
-                genMethod= SAFE_HMETHOD;
+            if ( ctx.genMethod == SAFE_WMETHOD or
+                ctx.genMethod == SAFE_WPMETHOD or
+                ctx.genMethod == SAFE_HMETHOD ) {
+                ctx.genMethod= SAFE_HMETHOD;
             }
             else {
-                genMethod = HMETHOD;
+                ctx.genMethod = HMETHOD;
             }
         }
         else if ( strcmp(argv[p],"-hsi") == 0 ) {
-            genMethod = HSIMETHOD;
+            ctx.genMethod = HSIMETHOD;
         }
         else if ( strcmp(argv[p],"-s") == 0 ) {
-            switch (genMethod) {
-                case WPMETHOD: genMethod = SAFE_WPMETHOD;
+            switch (ctx.genMethod) {
+                case WPMETHOD: ctx.genMethod = SAFE_WPMETHOD;
                     break;
-                case WMETHOD: genMethod = SAFE_WMETHOD;
+                case WMETHOD: ctx.genMethod = SAFE_WMETHOD;
                     break;
-                case HMETHOD: genMethod = SAFE_HMETHOD;
+                case HMETHOD: ctx.genMethod = SAFE_HMETHOD;
                     break;
                 default:
                     break;
@@ -187,7 +250,7 @@ static void parseParameters(int argc, char* argv[]) {
                 exit(1);
             }
             else {
-                fsmName = string(argv[++p]);
+                ctx.fsmName = string(argv[++p]);
             }
         }
         else if ( strcmp(argv[p],"-t") == 0 ) {
@@ -197,9 +260,12 @@ static void parseParameters(int argc, char* argv[]) {
                 exit(1);
             }
             else {
-                testSuiteFileName = string(argv[++p]);
+                ctx.testSuiteFileName = string(argv[++p]);
             }
         }
+        else if ( strcmp(argv[p],"-trie") == 0 ) {
+            ctx.trieFormat = true;
+        }
         else if ( strcmp(argv[p],"-a") == 0 ) {
             if ( argc < p+2 ) {
                 cerr << argv[0] << ": missing number of additional states" << endl;
@@ -207,7 +273,17 @@ static void parseParameters(int argc, char* argv[]) {
                 exit(1);
             }
             else {
-                numAddStates = atoi(argv[++p]);
+                ctx.numAddStates = atoi(argv[++p]);
+            }
+        }
+        else if ( strcmp(argv[p],"-j") == 0 ) {
+            if ( argc < p+2 ) {
+                cerr << argv[0] << ": missing number of threads" << endl;
+                printUsage(argv[0]);
+                exit(1);
+            }
+            else {
+                ctx.numThreads = atoi(argv[++p]);
             }
         }
         else if ( strcmp(argv[p],"-rtt") == 0 ) {
@@ -217,8 +293,38 @@ static void parseParameters(int argc, char* argv[]) {
                 exit(1);
             }
             else {
-                rttMbtStyle = true;
-                tcFilePrefix = string(argv[++p]);
+                ctx.rttMbtStyle = true;
+                ctx.tcFilePrefix = string(argv[++p]);
+            }
+        }
+        else if ( strcmp(argv[p],"-snapshot") == 0 ) {
+            if ( argc < p+2 ) {
+                cerr << argv[0] << ": missing snapshot file name" << endl;
+                printUsage(argv[0]);
+                exit(1);
+            }
+            else {
+                ctx.snapshotFile = string(argv[++p]);
+            }
+        }
+        else if ( strcmp(argv[p],"-batch") == 0 ) {
+            if ( argc < p+2 ) {
+                cerr << argv[0] << ": missing batch manifest" << endl;
+                printUsage(argv[0]);
+                exit(1);
+            }
+            else {
+                batch.manifestFile = string(argv[++p]);
+            }
+        }
+        else if ( strcmp(argv[p],"-timing") == 0 ) {
+            if ( argc < p+2 ) {
+                cerr << argv[0] << ": missing timing file" << endl;
+                printUsage(argv[0]);
+                exit(1);
+            }
+            else {
+                batch.timingFile = string(argv[++p]);
             }
         }
         else if ( strcmp(argv[p],"-p") == 0 ) {
@@ -228,20 +334,26 @@ static void parseParameters(int argc, char* argv[]) {
                 exit(1);
             }
             else {
-                plInputFile = string(argv[++p]);
-                plOutputFile = string(argv[++p]);
-                plStateFile = string(argv[++p]);
+                ctx.plInputFile = string(argv[++p]);
+                ctx.plOutputFile = string(argv[++p]);
+                ctx.plStateFile = string(argv[++p]);
             }
         }
         else if ( strstr(argv[p],".csv")  ) {
             haveModelFileName = true;
-            modelFile = string(argv[p]);
-            modelType = getModelType(modelFile);
+            ctx.modelFile = string(argv[p]);
+            ctx.modelType = getModelType(ctx.modelFile);
         }
         else if ( strstr(argv[p],".fsm")  ) {
             haveModelFileName = true;
-            modelFile = string(argv[p]);
-            modelType = getModelType(modelFile);
+            ctx.modelFile = string(argv[p]);
+            ctx.modelType = getModelType(ctx.modelFile);
+        }
+        else if ( FsmSnapshot::isSnapshotFile(argv[p]) ) {
+            // Snapshots are recognised by their contents, whatever their name
+            haveModelFileName = true;
+            ctx.modelFile = string(argv[p]);
+            ctx.modelType = FSM_SNAPSHOT;
         }
         else {
             cerr << argv[0] << ": illegal parameter `" << argv[p] << "'" << endl;
@@ -250,22 +362,36 @@ static void parseParameters(int argc, char* argv[]) {
         }
         
         if ( haveModelFileName and
-            (genMethod == SAFE_WPMETHOD or
-             genMethod == SAFE_WMETHOD or
-             genMethod == SAFE_HMETHOD) ) {
+            (ctx.genMethod == SAFE_WPMETHOD or
+             ctx.genMethod == SAFE_WMETHOD or
+             ctx.genMethod == SAFE_HMETHOD) ) {
                 p++;
                 if ( p >= argc ) {
                     cerr << argv[0] << ": missing model abstraction file" << endl;
                     printUsage(argv[0]);
                     exit(1);
                 }
-                modelAbstractionFile = string(argv[p]);
-                modelAbstractionType = getModelType(modelAbstractionFile); 
+                ctx.modelAbstractionFile = string(argv[p]);
+                ctx.modelAbstractionType = getModelType(ctx.modelAbstractionFile); 
             }
         
     }
     
-    if ( modelFile.empty() ) {
+    if ( not batch.manifestFile.empty() ) {
+        if ( not ctx.modelFile.empty() or ctx.rttMbtStyle or
+            not ctx.snapshotFile.empty() ) {
+            cerr << argv[0] << ": -batch cannot be combined with a model file, -rtt or -snapshot" << endl;
+            printUsage(argv[0]);
+            exit(1);
+        }
+        // In batch mode, the threads process jobs concurrently,
+        // each job is generated by a single thread
+        batch.numWorkers = ctx.numThreads;
+        ctx.numThreads = 1;
+        return;
+    }
+    
+    if ( ctx.modelFile.empty() ) {
         cerr << argv[0] << ": missing model file" << endl;
         printUsage(argv[0]);
         exit(1);
@@ -277,115 +403,149 @@ static void parseParameters(int argc, char* argv[]) {
 /**
  *   Instantiate DFSM or FSM from input file according to
  *   the different input formats which are supported.
+ *
+ *   @return false, if the model could not be read
  */
-static void readModel(model_type_t mtp,
-                      string thisFileName,
-                      string thisFsmName,
-                      shared_ptr<Fsm>& myFsm,
-                      shared_ptr<Dfsm>& myDfsm) {
+static bool readModel(GeneratorContext& ctx) {
+    
+    ctx.dfsm = nullptr;
+    ctx.fsm = nullptr;
     
-    myDfsm = nullptr;
-    myFsm = nullptr;
+    // The CSV reader terminates the program if it cannot open the
+    // model file, which would abort all remaining jobs of a batch run
+    ifstream modelStream(ctx.modelFile);
+    if ( not modelStream.is_open() ) {
+        cerr << "Could not open model file " << ctx.modelFile << endl;
+        return false;
+    }
+    modelStream.close();
     
     
-    switch ( mtp ) {
+    switch ( ctx.modelType ) {
         case FSM_CSV:
-            isDeterministic = true;
-            myDfsm = make_shared<Dfsm>(thisFileName,thisFsmName);
-            pl = myDfsm->getPresentationLayer();
+            ctx.isDeterministic = true;
+            ctx.dfsm = make_shared<Dfsm>(ctx.modelFile,ctx.fsmName);
+            ctx.pl = ctx.dfsm->getPresentationLayer();
             
             break;
             
         case FSM_JSON:
         {
-            Reader jReader;
-            Value root;
-            stringstream document;
-            ifstream inputFile(modelFile);
-            document << inputFile.rdbuf();
-            inputFile.close();
+            JsonModelReader jReader;
+            JsonFsmModel model;
+            ifstream inputFile(ctx.modelFile);
             
-            if ( jReader.parse(document.str(),root) ) {
-                myDfsm = make_shared<Dfsm>(root);
-                pl = myDfsm->getPresentationLayer();
+            if ( jReader.read(inputFile,model) ) {
+                ctx.dfsm = make_shared<Dfsm>(model);
+                ctx.pl = ctx.dfsm->getPresentationLayer();
             }
             else {
-                cerr << "Could not parse JSON model - exit." << endl;
-                exit(1);
+                cerr << "Could not parse JSON model " << ctx.modelFile
+                << ": " << jReader.getError() << endl;
+                return false;
             }
         }
             break;
             
         case FSM_BASIC:
-            if ( plStateFile.empty() ) {
-                pl = make_shared<FsmPresentationLayer>();
+            if ( ctx.plStateFile.empty() ) {
+                ctx.pl = make_shared<FsmPresentationLayer>();
             }
             else {
-                pl = make_shared<FsmPresentationLayer>(plInputFile,plOutputFile,plStateFile);
+                ctx.pl = make_shared<FsmPresentationLayer>(ctx.plInputFile,ctx.plOutputFile,ctx.plStateFile);
+            }
+            ctx.fsm = make_shared<Fsm>(ctx.modelFile,ctx.pl,ctx.fsmName);
+            if ( ctx.fsm->isDeterministic() ) {
+                ctx.isDeterministic = true;
+                ctx.dfsm = make_shared<Dfsm>(ctx.modelFile,ctx.pl,ctx.fsmName);
+                ctx.fsm = nullptr;
+            }
+            break;
+            
+        case FSM_SNAPSHOT:
+        {
+            shared_ptr<FsmSnapshot> snapshot = FsmSnapshot::open(ctx.modelFile);
+            if ( snapshot == nullptr ) {
+                return false;
             }
-            myFsm = make_shared<Fsm>(modelFile,pl,fsmName);
-            if ( myFsm->isDeterministic() ) {
-                isDeterministic = true;
-                myDfsm = make_shared<Dfsm>(modelFile,pl,fsmName);
-                myFsm = nullptr;
+            if ( snapshot->isDeterministic() ) {
+                ctx.isDeterministic = true;
+                ctx.dfsm = snapshot->createDfsm(ctx.fsmName);
+                ctx.pl = ctx.dfsm->getPresentationLayer();
+            }
+            else {
+                ctx.fsm = snapshot->createFsm(ctx.fsmName);
+                ctx.pl = ctx.fsm->getPresentationLayer();
             }
+        }
             break;
     }
     
-    if ( myFsm != nullptr ) {
-        myFsm->toDot(fsmName);
+    if ( not ctx.snapshotFile.empty() ) {
+        bool saved = ( ctx.dfsm != nullptr ) ?
+            FsmSnapshot::save(*ctx.dfsm,ctx.snapshotFile) :
+            FsmSnapshot::save(*ctx.fsm,ctx.snapshotFile);
+        if ( not saved ) {
+            return false;
+        }
+    }
+    
+    if ( not ctx.writeModelFiles ) {
+        return true;
     }
-    else if ( myDfsm != nullptr ) {
-        myDfsm->toDot(fsmName);
-        myDfsm->toCsv(fsmName);
+    
+    if ( ctx.fsm != nullptr ) {
+        ctx.fsm->toDot(ctx.fsmName);
+    }
+    else if ( ctx.dfsm != nullptr ) {
+        ctx.dfsm->toDot(ctx.fsmName);
+        ctx.dfsm->toCsv(ctx.fsmName);
     }
     
+    return true;
+    
 }
 
 
-static void readModelAbstraction(model_type_t mtp,
-                                 string thisFileName,
-                                 string thisFsmName,
-                                 shared_ptr<Dfsm>& myDfsm,
-                                 shared_ptr<FsmPresentationLayer> plRef) {
+static void readModelAbstraction(GeneratorContext& ctx) {
     
-    myDfsm = nullptr;
+    shared_ptr<FsmPresentationLayer> plRef = ctx.dfsm->getPresentationLayer();
+    ctx.dfsmAbstraction = nullptr;
     
     
-    switch ( mtp ) {
+    switch ( ctx.modelAbstractionType ) {
         case FSM_CSV:
-            isDeterministic = true;
-            myDfsm = make_shared<Dfsm>(thisFileName,thisFsmName,plRef);
+            ctx.isDeterministic = true;
+            ctx.dfsmAbstraction = make_shared<Dfsm>(ctx.modelAbstractionFile,"ABS_"+ctx.fsmName,plRef);
             break;
             
         case FSM_JSON:
         {
-            Reader jReader;
-            Value root;
-            stringstream document;
-            ifstream inputFile(thisFileName);
-            document << inputFile.rdbuf();
-            inputFile.close();
+            JsonModelReader jReader;
+            JsonFsmModel model;
+            ifstream inputFile(ctx.modelAbstractionFile);
             
-            if ( jReader.parse(document.str(),root) ) {
-                myDfsm = make_shared<Dfsm>(root,plRef);
+            if ( jReader.read(inputFile,model) ) {
+                ctx.dfsmAbstraction = make_shared<Dfsm>(model,plRef);
             }
             else {
-                cerr << "Could not parse JSON model - exit." << endl;
+                cerr << "Could not parse JSON model: " << jReader.getError()
+                << " - exit." << endl;
                 exit(1);
             }
         }
             break;
             
         case FSM_BASIC:
+        case FSM_SNAPSHOT:
             cerr << "ERROR. Model abstraction for SAFE W/WP/H METHOD may only be specified in CSV or JSON format - exit." << endl;
             exit(1);
             break;
     }
     
-    if ( myDfsm != nullptr ) {
-        myDfsm->toDot("ABS_"+fsmName);
-        myDfsm->toCsv("ABS_"+fsmName);
+    if ( ctx.dfsmAbstraction != nullptr ) {
+        ctx.dfsmAbstraction->toDot("ABS_"+ctx.fsmName);
+        ctx.dfsmAbstraction->toCsv("ABS_"+ctx.fsmName);
     }
 
 }
@@ -443,7 +603,7 @@ bool inPrefixRelation(vector<int> aPath, vector<int> bPath)
     return true;
 }
 
-shared_ptr<Tree> getPrefixRelationTreeWithoutTrace(const shared_ptr<Tree> & a, const shared_ptr<Tree> & b, const vector<int> & trc)
+shared_ptr<Tree> getPrefixRelationTreeWithoutTrace(const shared_ptr<Tree> & a, const shared_ptr<Tree> & b, const vector<int> & trc, const shared_ptr<FsmPresentationLayer> & pl)
 {
     IOListContainer aIOlst = a->getIOLists();
     IOListContainer bIOlst = b->getIOLists();
@@ -487,19 +647,11 @@ shared_ptr<Tree> getPrefixRelationTreeWithoutTrace(const shared_ptr<Tree> & a, c
 
 }
 
-static int costMatrix[3][3];
-
-static void initCostMatrix() {
-    costMatrix[0][0] = 0;
-    costMatrix[0][1] = 1;
-    costMatrix[0][2] = 3;
-    costMatrix[1][0] = 1;
-    costMatrix[1][1] = 2;
-    costMatrix[1][2] = 4;
-    costMatrix[2][0] = 3;
-    costMatrix[2][1] = 4;
-    costMatrix[2][2] = 5;
-}
+static const int costMatrix[3][3] = {
+    { 0, 1, 3 },
+    { 1, 2, 4 },
+    { 3, 4, 5 }
+};
 
 static int insertionCosts(int trc1Costs, int trc2Costs) {
     return costMatrix[trc1Costs][trc2Costs];
@@ -613,20 +765,35 @@ static void addSHTraces(deque<pair<shared_ptr<SegmentedTrace>,shared_ptr<Segment
 #endif
 }
 
+/**
+ *   Apply the test cases to a model and write the resulting output
+ *   trees, as Fsm::createTestSuite() does, but without collecting them
+ */
+static void writeTestCases(Fsm& fsm,
+                           const IOListContainer& iolc,
+                           TestSuiteWriter& writer) {
+    
+    for ( const auto& inVec : *iolc.getIOLists() ) {
+        writer.add(fsm.apply(InputTrace(inVec,fsm.getPresentationLayer())));
+    }
+    
+}
+
 #if 0
 
-static void safeHMethod(const shared_ptr<TestSuite> &testSuite) {
+static void safeHMethod(const GeneratorContext& ctx,
+                        TestSuiteWriter& writer) {
     
     // Minimise original reference DFSM
-    Dfsm dfsmRefMin = dfsm->minimise();
+    Dfsm dfsmRefMin = ctx.dfsm->minimise();
 
     // Minimise abstracted Dfsm
-    Dfsm dfsmAbstractionMin = dfsmAbstraction->minimise();
+    Dfsm dfsmAbstractionMin = ctx.dfsmAbstraction->minimise();
     
     dfsmRefMin.toDot("FSM_MINIMAL");
     dfsmAbstractionMin.toDot("ABS_FSM_MINIMAL");
     dfsmAbstractionMin.toCsv("ABS_FSM_MINIMAL");
-    cout << "REF    size = " << dfsm->size() << endl;
+    cout << "REF    size = " << ctx.dfsm->size() << endl;
     cout << "REFMIN size = " << dfsmRefMin.size() << endl;
     cout << "ABSMIN size = " << dfsmAbstractionMin.size() << endl;
     
@@ -645,7 +812,7 @@ static void safeHMethod(const shared_ptr<TestSuite> &testSuite) {
     shared_ptr<Tree> B = dfsmRefMin.getStateCover();
     IOListContainer inputEnum = IOListContainer(dfsmRefMin.getMaxInput(),
                                                 1,
-                                                numAddStates + 1,
+                                                ctx.numAddStates + 1,
                                                 pl);
     B->add(inputEnum);
     iTreeH->unionTree(B);
@@ -830,7 +997,7 @@ static void safeHMethod(const shared_ptr<TestSuite> &testSuite) {
 
             shared_ptr<Tree> alphaTree = iTreeSH->getSubTree(make_shared<InputTrace>(alpha->get(),pl));
             shared_ptr<Tree> betaTree = iTreeSH->getSubTree(make_shared<InputTrace>(beta->get(),pl));
-            shared_ptr<Tree> prefixRelationTree = getPrefixRelationTreeWithoutTrace(alphaTree, betaTree, gamma);
+            shared_ptr<Tree> prefixRelationTree = getPrefixRelationTreeWithoutTrace(alphaTree, betaTree, gamma, pl);
 
             if (prefixRelationTree->size() == 1)
             {
@@ -910,16 +1077,16 @@ static void safeHMethod(const shared_ptr<TestSuite> &testSuite) {
     }
 
     IOListContainer testCasesSH = iTreeSH->getIOLists();
-    *testSuite = dfsmRefMin.createTestSuite(testCasesSH);
+    writeTestCases(dfsmRefMin,testCasesSH,writer);
 }
 
 #else
 
 
-static void safeHMethod(const shared_ptr<TestSuite> &testSuite) {
+static void safeHMethod(const GeneratorContext& ctx,
+                        TestSuiteWriter& writer) {
     
-    initCostMatrix();
-    Dfsm dfsmRefMin = dfsm->minimise();
+    Dfsm dfsmRefMin = ctx.dfsm->minimise();
     dfsmRefMin.calculateDistMatrix();
     
     // Map from node numbers in dfsmRefMin to
@@ -928,8 +1095,8 @@ static void safeHMethod(const shared_ptr<TestSuite> &testSuite) {
     for ( size_t n = 0; n < dfsmRefMin.size(); n++ ) {
         dfsmMinNodes2dfsmNodes.push_back(0);
     }
-    shared_ptr<PkTable> pDfsm = dfsm->getPktblLst().back();
-    for ( size_t n = 0; n < dfsm->size(); n++ ) {
+    shared_ptr<PkTable> pDfsm = ctx.dfsm->getPktblLst().back();
+    for ( size_t n = 0; n < ctx.dfsm->size(); n++ ) {
         dfsmMinNodes2dfsmNodes[pDfsm->getClass(n)] = n;
     }
     
@@ -953,12 +1120,12 @@ static void safeHMethod(const shared_ptr<TestSuite> &testSuite) {
     
     
     // Minimise abstracted Dfsm
-    Dfsm dfsmAbstractionMin = dfsmAbstraction->minimise();
+    Dfsm dfsmAbstractionMin = ctx.dfsmAbstraction->minimise();
     
     dfsmRefMin.toDot("FSM_MINIMAL");
     dfsmAbstractionMin.toDot("ABS_FSM_MINIMAL");
     dfsmAbstractionMin.toCsv("ABS_FSM_MINIMAL");
-    cout << "REF    size = " << dfsm->size() << endl;
+    cout << "REF    size = " << ctx.dfsm->size() << endl;
     cout << "REFMIN size = " << dfsmRefMin.size() << endl;
     cout << "ABSMIN size = " << dfsmAbstractionMin.size() << endl;
     
@@ -1014,7 +1181,7 @@ static void safeHMethod(const shared_ptr<TestSuite> &testSuite) {
     // is transformed into a deque of trace segments
     IOListContainer inputEnum = IOListContainer(dfsmRefMin.getMaxInput(),
                                                 1,
-                                                numAddStates + 1,
+                                                ctx.numAddStates + 1,
                                                 pl);
     shared_ptr< vector< vector<int> > > inputEnumVec = inputEnum.getIOLists();
     deque< shared_ptr<TraceSegment> > inputEnumDeq;
@@ -1106,25 +1273,26 @@ static void safeHMethod(const shared_ptr<TestSuite> &testSuite) {
     }
     
     addSHTraces(A,dfsmRefMin,dfsmRefMin,*testSuiteTree);
-    addSHTraces(B,dfsmRefMin,*dfsmAbstraction,*testSuiteTree,&dfsmMinNodes2dfsmNodes);
-    addSHTraces(C,dfsmRefMin,*dfsmAbstraction,*testSuiteTree,&dfsmMinNodes2dfsmNodes);
+    addSHTraces(B,dfsmRefMin,*ctx.dfsmAbstraction,*testSuiteTree,&dfsmMinNodes2dfsmNodes);
+    addSHTraces(C,dfsmRefMin,*ctx.dfsmAbstraction,*testSuiteTree,&dfsmMinNodes2dfsmNodes);
     
     IOListContainer testCasesSH = testSuiteTree->getIOLists();
-    *testSuite = dfsmRefMin.createTestSuite(testCasesSH);
+    writeTestCases(dfsmRefMin,testCasesSH,writer);
     
 }
 
 #endif
 
 
-static void safeWpMethod(const shared_ptr<TestSuite> &testSuite) {
+static void safeWpMethod(const GeneratorContext& ctx,
+                         TestSuiteWriter& writer) {
     
     // Minimise original reference DFSM
     // Dfsm dfsmRefMin = dfsm->minimise();
-    Fsm dfsmRefMin = dfsm->minimiseObservableFSM();
+    Fsm dfsmRefMin = ctx.dfsm->minimiseObservableFSM();
     
     dfsmRefMin.toDot("REFMIN");
-    cout << "REF    size = " << dfsm->size() << endl;
+    cout << "REF    size = " << ctx.dfsm->size() << endl;
     cout << "REFMIN size = " << dfsmRefMin.size() << endl;
     
     // Get state cover of original model
@@ -1139,7 +1307,7 @@ static void safeWpMethod(const shared_ptr<TestSuite> &testSuite) {
     cout << "W = " << w << endl;
     
     // Minimise the abstracted reference model
-    Dfsm dfsmAbstractionMin = dfsmAbstraction->minimise();
+    Dfsm dfsmAbstractionMin = ctx.dfsmAbstraction->minimise();
     //Fsm dfsmAbstractionMin = dfsmAbstraction->minimiseObservableFSM();
     
     
@@ -1167,12 +1335,12 @@ static void safeWpMethod(const shared_ptr<TestSuite> &testSuite) {
     
     // Calc W22 = V.(union_(i=1)^(m-n) Sigma_I).wSafe)
     shared_ptr<Tree> W22;
-    if ( numAddStates > 0 ) {
+    if ( ctx.numAddStates > 0 ) {
         W22 = dfsmRefMin.getStateCover();
-        IOListContainer inputEnum = IOListContainer(dfsm->getMaxInput(),
+        IOListContainer inputEnum = IOListContainer(ctx.dfsm->getMaxInput(),
                                                     1,
-                                                    numAddStates,
-                                                    pl);
+                                                    ctx.numAddStates,
+                                                    ctx.pl);
         W22->add(inputEnum);
         W22->add(wSafe);
         W2->unionTree(W22);
@@ -1181,10 +1349,10 @@ static void safeWpMethod(const shared_ptr<TestSuite> &testSuite) {
     // Calc W3 = V.Sigma_I^(m - n + 1) oplus
     //           {Wis | Wis is state identification set of csmAbsMin}
     shared_ptr<Tree> W3 = dfsmRefMin.getStateCover();
-    IOListContainer inputEnum2 = IOListContainer(dfsm->getMaxInput(),
-                                                 (numAddStates+1),
-                                                 (numAddStates+1),
-                                                 pl);
+    IOListContainer inputEnum2 = IOListContainer(ctx.dfsm->getMaxInput(),
+                                                 (ctx.numAddStates+1),
+                                                 (ctx.numAddStates+1),
+                                                 ctx.pl);
     W3->add(inputEnum2);
     
     dfsmAbstractionMin.appendStateIdentificationSets(W3);
@@ -1195,16 +1363,17 @@ static void safeWpMethod(const shared_ptr<TestSuite> &testSuite) {
     W1->unionTree(W3);
     
     IOListContainer iolc = W1->getTestCases();
-    *testSuite = dfsm->createTestSuite(iolc);
+    writeTestCases(*ctx.dfsm,iolc,writer);
     
 }
 
-static void safeWMethod(const shared_ptr<TestSuite> &testSuite) {
+static void safeWMethod(const GeneratorContext& ctx,
+                        TestSuiteWriter& writer) {
     
     // Minimise original reference DFSM
-    Dfsm dfsmRefMin = dfsm->minimise();
+    Dfsm dfsmRefMin = ctx.dfsm->minimise();
     
-    cout << "REF    size = " << dfsm->size() << endl;
+    cout << "REF    size = " << ctx.dfsm->size() << endl;
     cout << "REFMIN size = " << dfsmRefMin.size() << endl;
     
     // Get state cover of original model
@@ -1216,7 +1385,7 @@ static void safeWMethod(const shared_ptr<TestSuite> &testSuite) {
     cout << "W = " << w << endl;
     
     // Minimise the abstracted reference model
-    Dfsm dfsmAbstractionMin = dfsmAbstraction->minimise();
+    Dfsm dfsmAbstractionMin = ctx.dfsmAbstraction->minimise();
     
     cout << "ABSMIN size = " << dfsmAbstractionMin.size() << endl;
     
@@ -1238,10 +1407,10 @@ static void safeWMethod(const shared_ptr<TestSuite> &testSuite) {
     // Calc W22 = V.(union_(i=1)^(m-n+1) Sigma_I).wSafe)
     shared_ptr<Tree> W22 = dfsmRefMin.getStateCover();
     
-    IOListContainer inputEnum = IOListContainer(dfsm->getMaxInput(),
+    IOListContainer inputEnum = IOListContainer(ctx.dfsm->getMaxInput(),
                                                 1,
-                                                numAddStates+1,
-                                                pl);
+                                                ctx.numAddStates+1,
+                                                ctx.pl);
     W22->add(inputEnum);
     
     W22->add(wSafe);
@@ -1252,150 +1421,352 @@ static void safeWMethod(const shared_ptr<TestSuite> &testSuite) {
     W1->unionTree(W22);
     
     IOListContainer iolc = W1->getTestCases();
-    *testSuite = dfsm->createTestSuite(iolc);
+    writeTestCases(*ctx.dfsm,iolc,writer);
     
 }
 
 
 
-static void generateTestSuite() {
-    
-    shared_ptr<TestSuite> testSuite =
-    make_shared<TestSuite>();
+/**
+ * Generate the test suite for the model of a context. Each test case
+ * is passed to the writer as soon as it has been applied to the model.
+ * @return false if the test suite file could not be written
+ */
+static bool generateTestSuite(const GeneratorContext& ctx,
+                              TestSuiteWriter& writer) {
     
-    switch ( genMethod ) {
+    switch ( ctx.genMethod ) {
         case WMETHOD:
-            if ( dfsm != nullptr ) {
-                IOListContainer iolc = dfsm->wMethod(numAddStates);
+            if ( ctx.dfsm != nullptr ) {
+                IOListContainer iolc = ctx.dfsm->wMethod(ctx.numAddStates,ctx.numThreads);
                 for ( auto inVec : *iolc.getIOLists() ) {
-                    shared_ptr<InputTrace> itrc = make_shared<InputTrace>(inVec,pl);
-                    testSuite->push_back(dfsm->apply(*itrc));
+                    shared_ptr<InputTrace> itrc = make_shared<InputTrace>(inVec,ctx.pl);
+                    writer.add(ctx.dfsm->apply(*itrc));
                 }
             }
             else {
-                IOListContainer iolc = fsm->wMethod(numAddStates);
+                IOListContainer iolc = ctx.fsm->wMethod(ctx.numAddStates,ctx.numThreads);
                 for ( auto inVec : *iolc.getIOLists() ) {
-                    shared_ptr<InputTrace> itrc = make_shared<InputTrace>(inVec,pl);
-                    testSuite->push_back(fsm->apply(*itrc));
+                    shared_ptr<InputTrace> itrc = make_shared<InputTrace>(inVec,ctx.pl);
+                    writer.add(ctx.fsm->apply(*itrc));
                 }
             }
             break;
             
         case WPMETHOD:
-            if ( dfsm != nullptr ) {
-                IOListContainer iolc = dfsm->wpMethod(numAddStates);
+            if ( ctx.dfsm != nullptr ) {
+                IOListContainer iolc = ctx.dfsm->wpMethod(ctx.numAddStates,ctx.numThreads);
                 for ( auto inVec : *iolc.getIOLists() ) {
-                    shared_ptr<InputTrace> itrc = make_shared<InputTrace>(inVec,pl);
-                    testSuite->push_back(dfsm->apply(*itrc));
+                    shared_ptr<InputTrace> itrc = make_shared<InputTrace>(inVec,ctx.pl);
+                    writer.add(ctx.dfsm->apply(*itrc));
                 }
             }
             else {
-                IOListContainer iolc = fsm->wpMethod(numAddStates);
+                IOListContainer iolc = ctx.fsm->wpMethod(ctx.numAddStates,ctx.numThreads);
                 for ( auto inVec : *iolc.getIOLists() ) {
-                    shared_ptr<InputTrace> itrc = make_shared<InputTrace>(inVec,pl);
-                    testSuite->push_back(fsm->apply(*itrc));
+                    shared_ptr<InputTrace> itrc = make_shared<InputTrace>(inVec,ctx.pl);
+                    writer.add(ctx.fsm->apply(*itrc));
                 }
             }
             break;
             
         case HMETHOD:
-            if ( dfsm != nullptr ) {
-                Dfsm dfsmMin = dfsm->minimise();
+            if ( ctx.dfsm != nullptr ) {
+                Dfsm dfsmMin = ctx.dfsm->minimise();
                 IOListContainer iolc =
-                dfsmMin.hMethodOnMinimisedDfsm(numAddStates);
+                dfsmMin.hMethodOnMinimisedDfsm(ctx.numAddStates,ctx.numThreads);
                 for ( auto inVec : *iolc.getIOLists() ) {
-                    shared_ptr<InputTrace> itrc = make_shared<InputTrace>(inVec,pl);
-                    testSuite->push_back(dfsm->apply(*itrc));
+                    shared_ptr<InputTrace> itrc = make_shared<InputTrace>(inVec,ctx.pl);
+                    writer.add(ctx.dfsm->apply(*itrc));
                 }
             }
             break;
             
         case HSIMETHOD:
-            if ( dfsm != nullptr ) {
-                IOListContainer iolc = dfsm->hsiMethod(numAddStates);
+            if ( ctx.dfsm != nullptr ) {
+                IOListContainer iolc = ctx.dfsm->hsiMethod(ctx.numAddStates,ctx.numThreads);
                 for ( auto inVec : *iolc.getIOLists() ) {
-                    shared_ptr<InputTrace> itrc = make_shared<InputTrace>(inVec,pl);
-                    testSuite->push_back(dfsm->apply(*itrc));
+                    shared_ptr<InputTrace> itrc = make_shared<InputTrace>(inVec,ctx.pl);
+                    writer.add(ctx.dfsm->apply(*itrc));
                 }
             }
             else {
-                IOListContainer iolc = fsm->hsiMethod(numAddStates);
+                IOListContainer iolc = ctx.fsm->hsiMethod(ctx.numAddStates,ctx.numThreads);
                 for ( auto inVec : *iolc.getIOLists() ) {
-                    shared_ptr<InputTrace> itrc = make_shared<InputTrace>(inVec,pl);
-                    testSuite->push_back(fsm->apply(*itrc));
+                    shared_ptr<InputTrace> itrc = make_shared<InputTrace>(inVec,ctx.pl);
+                    writer.add(ctx.fsm->apply(*itrc));
                 }
             }
             break;
             
         case SAFE_HMETHOD:
-            safeHMethod(testSuite);
+            safeHMethod(ctx,writer);
             break;
         case SAFE_WPMETHOD:
-            safeWpMethod(testSuite);
+            safeWpMethod(ctx,writer);
             break;
             
         case SAFE_WMETHOD:
-            safeWMethod(testSuite);
+            safeWMethod(ctx,writer);
             break;
     }
     
-    testSuite->save(testSuiteFileName);
+    return writer.close();
     
-    if ( rttMbtStyle ) {
-        int numTc = 0;
-        for ( size_t tIdx = 0; tIdx < testSuite->size(); tIdx++ ) {
-            
-            OutputTree ot = testSuite->at(tIdx);
-            vector<IOTrace> iotrcVec;
-            ot.toIOTrace(iotrcVec);
-            
-            for ( size_t iIdx = 0; iIdx < iotrcVec.size(); iIdx++ ) {
-                ostringstream tcFileName;
-                tcFileName << tcFilePrefix << tIdx << "_" << iIdx << ".log";
-                ofstream outFile(tcFileName.str());
-                outFile << iotrcVec[iIdx].toRttString();
-                outFile.close();
-                numTc++;
+}
+
+/**
+ *   One job of a batch run, together with its outcome
+ */
+struct BatchJob {
+    /** Line of the job in the manifest */
+    int line;
+    string methodName;
+    GeneratorContext ctx;
+    
+    bool done;
+    string error;
+    double readMillis;
+    double generateMillis;
+    size_t numTestCases;
+    size_t totalLength;
+    
+    BatchJob() :
+    line(0),
+    done(false),
+    readMillis(0),
+    generateMillis(0),
+    numTestCases(0),
+    totalLength(0) { }
+};
+
+/**
+ * Read the jobs of a batch manifest. Each non-empty line of the manifest
+ * which does not start with '#' specifies a job by the model file, the
+ * generation method (w, wp, h or hsi), the number of additional states and
+ * the test suite file. Stop execution if the manifest is illegal.
+ *
+ * @param batch options of the batch run
+ * @param proto context providing the options shared by all jobs
+ * @param jobs receives the jobs in the order of the manifest
+ */
+static void readManifest(const BatchOptions& batch,
+                         const GeneratorContext& proto,
+                         vector<BatchJob>& jobs) {
+    
+    ifstream manifest(batch.manifestFile);
+    if ( not manifest.is_open() ) {
+        cerr << "Could not open batch manifest " << batch.manifestFile << " - exit." << endl;
+        exit(1);
+    }
+    
+    string line;
+    int lineNo = 0;
+    while ( getline(manifest,line) ) {
+        lineNo++;
+        
+        istringstream fields(line);
+        string model;
+        if ( not (fields >> model) or model[0] == '#' ) {
+            continue;
+        }
+        
+        BatchJob job;
+        job.line = lineNo;
+        job.ctx = proto;
+        job.ctx.modelFile = model;
+        job.ctx.writeModelFiles = false;
+        
+        string extra;
+        int m = -1;
+        if ( not (fields >> job.methodName >> m >> job.ctx.testSuiteFileName) or
+            (fields >> extra) or m < 0 ) {
+            cerr << batch.manifestFile << ":" << lineNo
+            << ": expected `modelfile method additionalstates testsuitename' - exit." << endl;
+            exit(1);
+        }
+        job.ctx.numAddStates = static_cast<unsigned int>(m);
+        
+        if ( job.methodName == "w" ) {
+            job.ctx.genMethod = WMETHOD;
+        }
+        else if ( job.methodName == "wp" ) {
+            job.ctx.genMethod = WPMETHOD;
+        }
+        else if ( job.methodName == "h" ) {
+            job.ctx.genMethod = HMETHOD;
+        }
+        else if ( job.methodName == "hsi" ) {
+            job.ctx.genMethod = HSIMETHOD;
+        }
+        else {
+            cerr << batch.manifestFile << ":" << lineNo
+            << ": illegal generation method `" << job.methodName << "' - exit." << endl;
+            exit(1);
+        }
+        
+        job.ctx.modelType = getModelType(model);
+        jobs.push_back(job);
+    }
+    
+}
+
+/**
+ * Read the model of a batch job and generate its test suite. The
+ * outcome is recorded in the job, which releases its models afterwards.
+ */
+static void runJob(BatchJob& job) {
+    
+    typedef chrono::steady_clock Clock;
+    
+    try {
+        Clock::time_point start = Clock::now();
+        bool haveModel = readModel(job.ctx);
+        Clock::time_point read = Clock::now();
+        job.readMillis = chrono::duration<double,milli>(read - start).count();
+        
+        if ( not haveModel ) {
+            job.error = "could not read model";
+        }
+        else {
+            TestSuiteWriter writer(job.ctx.testSuiteFileName,"",
+                                   job.ctx.trieFormat);
+            bool written = generateTestSuite(job.ctx,writer);
+            job.generateMillis =
+            chrono::duration<double,milli>(Clock::now() - read).count();
+            job.numTestCases = writer.size();
+            job.totalLength = writer.getTotalLength();
+            if ( written ) {
+                job.done = true;
+            }
+            else {
+                job.error = "could not write test suite";
             }
-            
         }
+    }
+    catch ( const exception& e ) {
+        job.error = e.what();
+    }
+    
+    job.ctx.pl = nullptr;
+    job.ctx.dfsm = nullptr;
+    job.ctx.fsm = nullptr;
+    
+}
+
+/**
+ * Run the jobs of a batch manifest concurrently and write one timing
+ * record per job to the timing file.
+ *
+ * The jobs are started in descending order of their model file sizes,
+ * so that the large models do not end up at the tail of the run. Each
+ * worker thread takes the next job which has not been started yet,
+ * until all jobs are done.
+ *
+ * @return the number of failed jobs
+ */
+static size_t runBatch(const BatchOptions& batch, const GeneratorContext& proto) {
+    
+    vector<BatchJob> jobs;
+    readManifest(batch,proto,jobs);
+    
+    vector<pair<streamoff,size_t>> bySize;
+    for ( size_t j = 0; j < jobs.size(); j++ ) {
+        ifstream model(jobs[j].ctx.modelFile, ios::binary | ios::ate);
+        streamoff size = model.is_open() ? static_cast<streamoff>(model.tellg()) : 0;
+        bySize.push_back(make_pair(-size,j));
+    }
+    sort(bySize.begin(),bySize.end());
+    
+    const unsigned int nThreads = numWorkerThreads(batch.numWorkers);
+    
+    // The performance tracking of the library functions reports through a
+    // shared callback object which must not be used by concurrent jobs
+    if ( nThreads > 1 ) {
+        el::Loggers::reconfigureLogger(el::base::consts::kPerformanceLoggerId,
+                                       el::ConfigurationType::PerformanceTracking,
+                                       "false");
+    }
+    
+    mutex outMutex;
+    parallelFor(bySize.size(), nThreads, [&](size_t k, unsigned int) {
+        BatchJob& job = jobs[bySize[k].second];
+        runJob(job);
         
+        lock_guard<mutex> lock(outMutex);
+        if ( job.done ) {
+            cout << job.ctx.modelFile << " -> " << job.ctx.testSuiteFileName
+            << ": " << job.numTestCases << " test cases, total length "
+            << job.totalLength << endl;
+        }
+        else {
+            cerr << batch.manifestFile << ":" << job.line << ": "
+            << job.ctx.modelFile << ": " << job.error << endl;
+        }
+    });
+    
+    ofstream timing(batch.timingFile);
+    timing << "model,method,m,testsuite,status,read_ms,generate_ms,testcases,totallength" << endl;
+    size_t numFailed = 0;
+    for ( const auto& job : jobs ) {
+        if ( not job.done ) numFailed++;
+        timing << job.ctx.modelFile << ","
+        << job.methodName << ","
+        << job.ctx.numAddStates << ","
+        << job.ctx.testSuiteFileName << ","
+        << (job.done ? "ok" : "failed") << ","
+        << job.readMillis << ","
+        << job.generateMillis << ","
+        << job.numTestCases << ","
+        << job.totalLength << endl;
     }
+    timing.close();
     
-    cout << "Number of test cases: " << testSuite->size() << endl;
-    cout << "        total length: " << testSuite->totalLength() << endl;
+    cout << "Batch jobs: " << jobs.size() << ", failed: " << numFailed << endl;
+    
+    return numFailed;
     
 }
 
 int main(int argc, char* argv[])
 {
     
-    parseParameters(argc,argv);
-    readModel(modelType,modelFile,fsmName,fsm,dfsm);
+    GeneratorContext ctx;
+    BatchOptions batch;
+    parseParameters(argc,argv,ctx,batch);
     
-    if ( genMethod == SAFE_WPMETHOD or
-        genMethod == SAFE_WMETHOD or
-        genMethod == SAFE_HMETHOD) {
-        if ( dfsm == nullptr ) {
+    if ( not batch.manifestFile.empty() ) {
+        exit(runBatch(batch,ctx) == 0 ? 0 : 1);
+    }
+    
+    if ( not readModel(ctx) ) {
+        exit(1);
+    }
+    
+    if ( ctx.genMethod == SAFE_WPMETHOD or
+        ctx.genMethod == SAFE_WMETHOD or
+        ctx.genMethod == SAFE_HMETHOD) {
+        if ( ctx.dfsm == nullptr ) {
             cerr << "SAFE W/WP METHOD only operates on deterministic FSMs - exit."
             << endl;
             exit(1);
         }
         
-        shared_ptr<FsmPresentationLayer> plRef = dfsm->getPresentationLayer();
-        
-        readModelAbstraction(modelAbstractionType,
-                             modelAbstractionFile,
-                             "ABS_"+fsmName,
-                             dfsmAbstraction,
-                             plRef);
+        readModelAbstraction(ctx);
     }
     
-    generateTestSuite();
+    TestSuiteWriter writer(ctx.testSuiteFileName,
+                           ctx.rttMbtStyle ? ctx.tcFilePrefix : "",
+                           ctx.trieFormat);
+    if ( not generateTestSuite(ctx,writer) ) {
+        exit(1);
+    }
+    
+    cout << "Number of test cases: " << writer.size() << endl;
+    cout << "        total length: " << writer.getTotalLength() << endl;
     
     exit(0);
     
 }
 
 
-
@@ -1,6 +1,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 
 
 extern void sut_init();
@@ -41,63 +48,516 @@ void getNextIO(char** p, char** x, char** y) {
 
 
 
-void executeTestCase(const char* tcId, char* line) {
+void executeTestCase(FILE* out, const char* tcId, char* line) {
     
     char* p = line;
     char* x = 0;
     char* y = 0;
-    printf("%s",tcId);
+    fprintf(out,"%s",tcId);
     
     while ( *p ) {
         
-        if ( p > line ) printf(".");
+        if ( p > line ) fprintf(out,".");
         
         getNextIO(&p,&x,&y);
         
         if ( x != NULL && y != NULL ) {
             const char* r = sut(x);
             if ( strcmp(r,y) != 0 ) {
-                printf(" after input %s: expected %s - observed %s: FAIL\n",
+                fprintf(out," after input %s: expected %s - observed %s: FAIL\n",
                        x,y,r);
                 return;
             }
             else {
-                printf("(%s,%s)",x,r);
+                fprintf(out,"(%s,%s)",x,r);
             }
         }
         
     }
     
-    printf(" PASS\n");
+    fprintf(out," PASS\n");
     
 }
 
 
-void executeTestCases(const char* fname) {
+/**
+ *   Test suite files in the prefix tree format written by the generator
+ *   with option -trie start with this magic number. The format is
+ *   described in trees/TestSuiteTrie.h.
+ */
+static const char trieMagic[8] = { 'F','S','M','T','R','I','E',0 };
+
+
+/**
+ *   Visitor called for each test case of a test suite, with the
+ *   number of the test case (starting at 0) and its text line.
+ */
+typedef void (*tc_visitor_t)(int k, const char* line, void* arg);
+
+
+/**
+ *   Read an unsigned LEB128 number.
+ *   Returns 0 on success, -1 on error or end of file.
+ */
+static int readNumber(FILE* f, unsigned int* n) {
+    
+    *n = 0;
+    for ( int shift = 0; shift < 35; shift += 7 ) {
+        int c = getc(f);
+        if ( c == EOF ) return -1;
+        *n |= (unsigned int)(c & 0x7F) << shift;
+        if ( (c & 0x80) == 0 ) return 0;
+    }
+    return -1;
+    
+}
+
+
+/**
+ *   Read a name table of a trie file.
+ *   Returns the names, or NULL on error.
+ */
+static char** readNames(FILE* f, unsigned int* numNames) {
+    
+    if ( readNumber(f,numNames) < 0 ) return NULL;
+    
+    char** names = (char**)calloc((size_t)*numNames + 1,sizeof(char*));
+    if ( names == NULL ) return NULL;
+    for ( unsigned int i = 0; i < *numNames; i++ ) {
+        unsigned int len;
+        if ( readNumber(f,&len) < 0 ) return NULL;
+        names[i] = (char*)malloc((size_t)len + 1);
+        if ( names[i] == NULL ) return NULL;
+        if ( fread(names[i],1,len,f) != len ) return NULL;
+        names[i][len] = 0;
+    }
+    return names;
+    
+}
+
+
+/**
+ *   Decode the test cases of a trie file depth-first, after its magic
+ *   number has been read. The text line of a test case is extended and
+ *   truncated in place while the tree is traversed, so a shared prefix
+ *   is formatted only once.
+ *   Returns the number of test cases, or -1 if the file is corrupt.
+ */
+static int forEachTrieTestCase(FILE* f, tc_visitor_t visit, void* arg) {
+    
+    unsigned int version, numIn, numOut, count, numChildren;
+    char** inNames;
+    char** outNames;
+    
+    if ( readNumber(f,&version) < 0 || version != 1 ) return -1;
+    if ( (inNames = readNames(f,&numIn)) == NULL ) return -1;
+    if ( (outNames = readNames(f,&numOut)) == NULL ) return -1;
+    if ( readNumber(f,&count) < 0 || readNumber(f,&numChildren) < 0 ) return -1;
+    
+    // Per node on the current path, root first: number of unread
+    // children and length of the line up to the node
+    int capacity = 64;
+    int depth = 0;
+    unsigned int* unread = (unsigned int*)malloc(capacity * sizeof(unsigned int));
+    size_t* lineLen = (size_t*)malloc(capacity * sizeof(size_t));
+    unread[0] = numChildren;
+    lineLen[0] = 0;
+    
+    size_t lineCapacity = 1024;
+    char* line = (char*)malloc(lineCapacity);
+    line[0] = 0;
+    
+    int tcNum = 0;
+    
+    while ( depth >= 0 ) {
+        
+        // Empty test cases are skipped, as empty lines of text files
+        for ( ; count > 0; count-- ) {
+            if ( depth > 0 ) visit(tcNum++,line,arg);
+        }
+        
+        if ( unread[depth] == 0 ) {
+            depth--;
+            continue;
+        }
+        unread[depth]--;
+        
+        unsigned int x, y;
+        if ( readNumber(f,&x) < 0 || readNumber(f,&y) < 0 ||
+             readNumber(f,&count) < 0 || readNumber(f,&numChildren) < 0 ||
+             x >= numIn || y >= numOut ) {
+            return -1;
+        }
+        
+        size_t len = lineLen[depth];
+        size_t need = len + strlen(inNames[x]) + strlen(outNames[y]) + 5;
+        if ( need > lineCapacity ) {
+            while ( need > lineCapacity ) lineCapacity *= 2;
+            line = (char*)realloc(line,lineCapacity);
+        }
+        // Overwrites the line of a previously visited sibling
+        len += sprintf(line + len,"%s(%s/%s)",(depth > 0) ? "." : "",inNames[x],outNames[y]);
+        
+        if ( ++depth == capacity ) {
+            capacity *= 2;
+            unread = (unsigned int*)realloc(unread,capacity * sizeof(unsigned int));
+            lineLen = (size_t*)realloc(lineLen,capacity * sizeof(size_t));
+        }
+        unread[depth] = numChildren;
+        lineLen[depth] = len;
+        
+    }
+    
+    free(line);
+    free(unread);
+    free(lineLen);
+    for ( unsigned int i = 0; i < numIn; i++ ) free(inNames[i]);
+    for ( unsigned int i = 0; i < numOut; i++ ) free(outNames[i]);
+    free(inNames);
+    free(outNames);
+    
+    return tcNum;
+    
+}
+
+
+/**
+ *   Open a test suite file and check whether it is in trie format.
+ *   If so, the file is positioned after the magic number.
+ */
+static FILE* openTestSuite(const char* fname, int* isTrie) {
     
-    const int lineSize = 100000;
-    char* line = (char*)calloc(lineSize,1);
     FILE* f = fopen(fname,"r");
     if ( f == NULL ) {
         fprintf(stderr,"Could not open file %s - exit.\n",fname);
         exit(1);
     }
     
-    int tcNum = 0;
-    while ( fgets(line,lineSize,f) ) {
+    char magic[sizeof(trieMagic)];
+    *isTrie = ( fread(magic,1,sizeof(magic),f) == sizeof(magic) &&
+                memcmp(magic,trieMagic,sizeof(magic)) == 0 );
+    if ( !*isTrie ) rewind(f);
+    return f;
+    
+}
+
+
+/**
+ *   Collect the test cases of a test suite into an array of lines.
+ */
+struct tc_lines {
+    char** lines;
+    int num;
+    int capacity;
+};
+
+static void appendTestCase(int k, const char* line, void* arg) {
+    
+    struct tc_lines* tcs = (struct tc_lines*)arg;
+    (void)k;
+    if ( tcs->num == tcs->capacity ) {
+        tcs->capacity *= 2;
+        tcs->lines = (char**)realloc(tcs->lines,tcs->capacity * sizeof(char*));
+    }
+    tcs->lines[tcs->num++] = strdup(line);
+    
+}
+
+
+/**
+ *   Read the test cases of the test suite file, one per non-empty line,
+ *   or depth-first from a file in trie format.
+ *   Returns the number of test cases; *tcLines receives the lines,
+ *   newline characters removed.
+ */
+int readTestCases(const char* fname, char*** tcLines) {
+    
+    int isTrie;
+    FILE* f = openTestSuite(fname,&isTrie);
+    
+    struct tc_lines tcs;
+    tcs.num = 0;
+    tcs.capacity = 64;
+    tcs.lines = (char**)malloc(tcs.capacity * sizeof(char*));
+    
+    if ( isTrie ) {
+        if ( forEachTrieTestCase(f,appendTestCase,&tcs) < 0 ) {
+            fprintf(stderr,"Corrupt test suite file %s - exit.\n",fname);
+            exit(1);
+        }
+    }
+    else {
+        const int lineSize = 100000;
+        char* line = (char*)calloc(lineSize,1);
         
-        size_t len = strlen(line);
+        while ( fgets(line,lineSize,f) ) {
+            
+            size_t len = strlen(line);
+            
+            // Replace newline by null character
+            if ( len > 1 ) {
+                line[len-1] = 0;
+                appendTestCase(tcs.num,line,&tcs);
+            }
+            
+        }
+        free(line);
+    }
+    
+    fclose(f);
+    *tcLines = tcs.lines;
+    return tcs.num;
+    
+}
+
+
+/**
+ *   Execute a test case while a trie file is decoded. The line is
+ *   copied, since executeTestCase() modifies it.
+ */
+static void executeTrieTestCase(int k, const char* line, void* arg) {
+    
+    char** scratch = (char**)arg;
+    char tcId[100];
+    
+    *scratch = (char*)realloc(*scratch,strlen(line) + 1);
+    strcpy(*scratch,line);
+    sprintf(tcId,"TC-%d: ",k+1);
+    executeTestCase(stdout,tcId,*scratch);
+    sut_reset();
+    
+}
+
+
+void executeTestCases(const char* fname) {
+    
+    int isTrie;
+    FILE* f = openTestSuite(fname,&isTrie);
+    
+    // Test cases in trie format are executed as they are decoded
+    if ( isTrie ) {
+        char* scratch = NULL;
+        if ( forEachTrieTestCase(f,executeTrieTestCase,&scratch) < 0 ) {
+            fprintf(stderr,"Corrupt test suite file %s - exit.\n",fname);
+            exit(1);
+        }
+        free(scratch);
+        fclose(f);
+        return;
+    }
+    fclose(f);
+    
+    char** tcLines;
+    int numTc = readTestCases(fname,&tcLines);
+    
+    for ( int k = 0; k < numTc; k++ ) {
+        char tcId[100];
+        sprintf(tcId,"TC-%d: ",k+1);
+        executeTestCase(stdout,tcId,tcLines[k]);
+        sut_reset();
+    }
+    
+}
+
+
+/**
+ *   Write len bytes to fd, retrying on short writes.
+ *   Returns 0 on success, -1 on error.
+ */
+static int writeAll(int fd, const void* buf, size_t len) {
+    
+    const char* p = (const char*)buf;
+    while ( len > 0 ) {
+        ssize_t n = write(fd,p,len);
+        if ( n < 0 ) {
+            if ( errno == EINTR ) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+    
+}
+
+
+/**
+ *   Read len bytes from fd, retrying on short reads.
+ *   Returns 0 on success, -1 on error or end of file.
+ */
+static int readAll(int fd, void* buf, size_t len) {
+    
+    char* p = (char*)buf;
+    while ( len > 0 ) {
+        ssize_t n = read(fd,p,len);
+        if ( n < 0 ) {
+            if ( errno == EINTR ) continue;
+            return -1;
+        }
+        if ( n == 0 ) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+    
+}
+
+
+/**
+ *   Worker process: initialise an own SUT instance, then take test case
+ *   numbers from the shared queue counter until all are taken. The verdict
+ *   text of each test case is sent to the parent as
+ *   (test case number, text length, text).
+ */
+static void runWorker(char** tcLines, int numTc, volatile int* nextTc, int fd) {
+    
+    sut_init();
+    
+    for ( int k = __sync_fetch_and_add(nextTc,1); k < numTc;
+          k = __sync_fetch_and_add(nextTc,1) ) {
         
-        // Replace newline by null character
-        if ( len > 1 ) {
-            line[len-1] = 0;
-            char tcId[100];
-            *tcId = 0;
-            sprintf(tcId,"TC-%d: ",++tcNum);
-            executeTestCase(tcId,line);
-            sut_reset();
+        char* buf = NULL;
+        size_t len = 0;
+        FILE* out = open_memstream(&buf,&len);
+        if ( out == NULL ) {
+            perror("open_memstream");
+            _exit(1);
         }
         
+        char tcId[100];
+        sprintf(tcId,"TC-%d: ",k+1);
+        executeTestCase(out,tcId,tcLines[k]);
+        sut_reset();
+        fclose(out);
+        
+        if ( writeAll(fd,&k,sizeof(k)) < 0 ||
+             writeAll(fd,&len,sizeof(len)) < 0 ||
+             writeAll(fd,buf,len) < 0 ) {
+            _exit(1);
+        }
+        free(buf);
+        
+    }
+    
+    close(fd);
+    _exit(0);
+    
+}
+
+
+/**
+ *   Execute the test cases on numWorkers forked processes.
+ *   The verdicts are printed in test case order, so that the
+ *   output is the same as for executeTestCases().
+ */
+void executeTestCasesParallel(const char* fname, int numWorkers) {
+    
+    char** tcLines;
+    int numTc = readTestCases(fname,&tcLines);
+    if ( numWorkers > numTc ) numWorkers = numTc;
+    if ( numWorkers < 1 ) return;
+    
+    // Work queue: index of the next test case to be executed
+    volatile int* nextTc = (volatile int*)mmap(NULL,sizeof(int),
+                                               PROT_READ | PROT_WRITE,
+                                               MAP_SHARED | MAP_ANONYMOUS,
+                                               -1,0);
+    if ( nextTc == MAP_FAILED ) {
+        perror("mmap");
+        exit(1);
+    }
+    *nextTc = 0;
+    
+    struct pollfd* fds = (struct pollfd*)calloc(numWorkers,sizeof(struct pollfd));
+    pid_t* pids = (pid_t*)calloc(numWorkers,sizeof(pid_t));
+    
+    // Buffered output must not be duplicated into the workers
+    fflush(stdout);
+    fflush(stderr);
+    
+    for ( int w = 0; w < numWorkers; w++ ) {
+        int pfd[2];
+        if ( pipe(pfd) < 0 ) {
+            perror("pipe");
+            exit(1);
+        }
+        pids[w] = fork();
+        if ( pids[w] < 0 ) {
+            perror("fork");
+            exit(1);
+        }
+        if ( pids[w] == 0 ) {
+            close(pfd[0]);
+            for ( int v = 0; v < w; v++ ) close(fds[v].fd);
+            runWorker(tcLines,numTc,nextTc,pfd[1]);
+        }
+        close(pfd[1]);
+        fds[w].fd = pfd[0];
+        fds[w].events = POLLIN;
+    }
+    
+    // Verdicts received ahead of the next one to be printed
+    char** verdicts = (char**)calloc(numTc,sizeof(char*));
+    size_t* verdictLens = (size_t*)calloc(numTc,sizeof(size_t));
+    int nextPrinted = 0;
+    int openPipes = numWorkers;
+    
+    while ( openPipes > 0 ) {
+        
+        if ( poll(fds,numWorkers,-1) < 0 ) {
+            if ( errno == EINTR ) continue;
+            perror("poll");
+            exit(1);
+        }
+        
+        for ( int w = 0; w < numWorkers; w++ ) {
+            
+            if ( fds[w].fd < 0 || fds[w].revents == 0 ) continue;
+            
+            int k;
+            size_t len;
+            if ( readAll(fds[w].fd,&k,sizeof(k)) < 0 ) {
+                // The worker has finished or terminated
+                close(fds[w].fd);
+                fds[w].fd = -1;
+                openPipes--;
+                continue;
+            }
+            if ( readAll(fds[w].fd,&len,sizeof(len)) < 0 ||
+                 k < 0 || k >= numTc ) {
+                fprintf(stderr,"Corrupt verdict from worker %d - exit.\n",w);
+                exit(1);
+            }
+            verdicts[k] = (char*)malloc(len + 1);
+            if ( readAll(fds[w].fd,verdicts[k],len) < 0 ) {
+                fprintf(stderr,"Corrupt verdict from worker %d - exit.\n",w);
+                exit(1);
+            }
+            verdictLens[k] = len;
+            
+            while ( nextPrinted < numTc && verdicts[nextPrinted] != NULL ) {
+                fwrite(verdicts[nextPrinted],1,verdictLens[nextPrinted],stdout);
+                free(verdicts[nextPrinted]);
+                verdicts[nextPrinted] = NULL;
+                nextPrinted++;
+            }
+            
+        }
+        
+    }
+    fflush(stdout);
+    
+    int failed = 0;
+    for ( int w = 0; w < numWorkers; w++ ) {
+        int status;
+        while ( waitpid(pids[w],&status,0) < 0 && errno == EINTR );
+        if ( !WIFEXITED(status) || WEXITSTATUS(status) != 0 ) failed = 1;
+    }
+    
+    if ( failed || nextPrinted < numTc ) {
+        fprintf(stderr,"A worker terminated before TC-%d was executed - exit.\n",
+                nextPrinted + 1);
+        exit(1);
     }
     
 }
@@ -107,14 +567,37 @@ void executeTestCases(const char* fname) {
 
 int main(int argc, char** argv) {
     
-    if ( argc < 2 ) {
+    int numWorkers = 0;
+    int opt;
+    
+    while ( (opt = getopt(argc,argv,"j:")) != -1 ) {
+        switch ( opt ) {
+            case 'j':
+                numWorkers = atoi(optarg);
+                if ( numWorkers < 1 ) {
+                    fprintf(stderr,"Invalid number of workers %s - exit.\n",optarg);
+                    exit(1);
+                }
+                break;
+            default:
+                fprintf(stderr,"Usage: %s [-j workers] <test suite file>\n",argv[0]);
+                exit(1);
+        }
+    }
+    
+    if ( optind >= argc ) {
         fprintf(stderr,"Missing file name of test suite file - exit.\n");
         exit(1);
     }
     
-    sut_init();
-    
-    executeTestCases(argv[1]);
+    if ( numWorkers > 0 ) {
+        // Every worker process initialises its own SUT
+        executeTestCasesParallel(argv[optind],numWorkers);
+    }
+    else {
+        sut_init();
+        executeTestCases(argv[optind]);
+    }
     
     exit(0);
     
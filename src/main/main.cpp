@@ -5,6 +5,7 @@
  */
 
 #include <string>
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <fstream>
@@ -14,19 +15,29 @@
 #include <random>
 #include <stdlib.h>
 #include <interface/FsmPresentationLayer.h>
+#include <fsm/CsrTransitionTable.h>
 #include <fsm/Dfsm.h>
+#include <fsm/DfsmExecutionTable.h>
+#include <fsm/DistinguishingTraceMatrix.h>
 #include <fsm/Fsm.h>
 #include <fsm/FsmNode.h>
+#include <fsm/FsmSnapshot.h>
 #include <fsm/FsmTransition.h>
 #include <fsm/IOTrace.h>
 #include <fsm/IOTraceContainer.h>
+#include <fsm/JsonModelReader.h>
+#include <fsm/MutationAnalysis.h>
+#include <fsm/OFSMTable.h>
+#include <fsm/RDistinguishability.h>
 #include <fsm/FsmPrintVisitor.h>
 #include <fsm/FsmSimVisitor.h>
 #include <fsm/FsmOraVisitor.h>
+#include <sets/HittingSet.h>
 #include <trees/IOListContainer.h>
 #include <trees/IOTreeContainer.h>
 #include <trees/OutputTree.h>
 #include <trees/TestSuite.h>
+#include <trees/TestSuiteTrie.h>
 #include "json/json.h"
 #include "logging/easylogging++.h"
 #include "logging/Logging.h"
@@ -37,6 +48,7 @@
 #include <math.h>
 #include <stdio.h>
 #include <deque>
+#include <set>
 
 using namespace std;
 using namespace Json;
@@ -999,6 +1011,8 @@ void wVersusT() {
 
 
 
+    vector<DfsmExecutionTable> mutantTables;
+
     for ( int i = 0; i < 10; i++ ) {
 
         cout << "Mutant No. " << (i+1) << ": " << endl;
@@ -1006,6 +1020,7 @@ void wVersusT() {
         shared_ptr<Dfsm> mutant =
             make_shared<Dfsm>("FSBRTSX.csv","FSBRTS");
         mutant->createAtRandom();
+        mutantTables.push_back(mutant->getExecutionTable());
 
 //        runAgainstMutant(mutant,expectedResultsW0);
 //        runAgainstMutant(mutant,expectedResultsW1);
@@ -1020,6 +1035,13 @@ void wVersusT() {
 
     }
 
+    MutationAnalysis analysis(refModel->getExecutionTable(),
+                              mutantTables,
+                              *wpTestSuite0.getIOLists());
+    analysis.run(0);
+    analysis.printKillMatrix(cout);
+    cout << "Mutation score: " << analysis.getMutationScore() << endl;
+
 
 }
 
@@ -1147,6 +1169,1193 @@ void test15() {
 
 }
 
+static shared_ptr<Dfsm> readJsonDfsm(const string& fname) {
+
+    Reader jReader;
+    Value root;
+    stringstream document;
+    ifstream inputFile(fname);
+    document << inputFile.rdbuf();
+    inputFile.close();
+
+    if ( not jReader.parse(document.str(),root) ) {
+        cerr << "Could not parse JSON model " << fname << " - exit." << endl;
+        exit(1);
+    }
+    return make_shared<Dfsm>(root);
+
+}
+
+/** Deterministic models of the resources directory, flagged if in JSON format */
+static const vector< pair<string,bool> > dfsmModels = {
+    { "TC-DFSM-0001.fsm", false }, { "TC-FSM-0005.fsm", false },
+    { "fsm.fsm", false }, { "fsmGillA17.fsm", false },
+    { "fsmGillA7.fsm", false }, { "fsma.fsm", false }, { "fsmb.fsm", false },
+    { "garage.fsm", false }, { "huang201711.fsm", false },
+    { "brake.fsm", true }, { "csm0.fsm", true }, { "csm0-abs.fsm", true },
+    { "exp1.fsm", true }, { "exp2.fsm", true },
+    { "safety-complete-example-1.fsm", true },
+    { "safety-complete-example-1-abs.fsm", true },
+    { "unreachable_gdc.fsm", true }
+};
+
+static shared_ptr<Dfsm> readDfsmModel(const pair<string,bool>& model) {
+
+    string fname = "../../../resources/" + model.first;
+    if ( model.second ) {
+        return readJsonDfsm(fname);
+    }
+    return make_shared<Dfsm>(fname,make_shared<FsmPresentationLayer>(),"D");
+
+}
+
+static vector<string> getStateNames(Fsm& fsm) {
+
+    vector<string> names;
+    for ( auto n : fsm.getNodes() ) {
+        names.push_back(n->getName());
+    }
+    sort(names.begin(),names.end());
+    return names;
+
+}
+
+void test17() {
+
+    cout << "TC-DFSM-0016 Show that Dfsm::minimise() with Hopcroft partition "
+    << "refinement creates the same DFSM as the minimisation by Pk-tables"
+    << endl;
+
+    for ( auto model : dfsmModels ) {
+
+        // Both minimisations remove the unreachable states of the
+        // DFSM they are applied to, so each gets its own copy
+        shared_ptr<Dfsm> dPk = readDfsmModel(model);
+        shared_ptr<Dfsm> dHopcroft = readDfsmModel(model);
+
+        Dfsm minPk = dPk->minimise();
+        Dfsm minHopcroft = dHopcroft->minimise(true);
+
+        shared_ptr<IOTrace> failTrace;
+        fsmlib_assert("TC-DFSM-0016",
+               minPk.size() == minHopcroft.size() and
+               getStateNames(minPk) == getStateNames(minHopcroft) and
+               minPk.isEquivalent(minHopcroft,failTrace),
+               "Both minimisations of " + model.first + " have the same states and language");
+
+    }
+
+}
+
+void test18() {
+
+    cout << "TC-FSM-0011 Show that Fsm::minimiseObservableFSM() creates the same "
+    << "FSM as the OFSM tables calculated by OFSMTable::next()"
+    << endl;
+
+    vector<string> fsmFiles = { "M0.fsm", "M1.fsm", "M2.fsm", "N1MIN.fsm",
+        "N2MIN.fsm", "N3MIN.fsm", "N4MIN.fsm", "N5MIN.fsm", "NMIN.fsm",
+        "NMIN4.fsm", "NMIN_SUT.fsm", "NN.fsm", "adaptive.fsm", "adaptive2.fsm",
+        "adaptive-iut.fsm", "adaptive-iut-fail.fsm", "example-master-m1.fsm",
+        "example-master-m1-iut.fsm", "fsmdump.fsm", "nondetnonmin.fsm",
+        "wp1ref.fsm", "wp2imp.fsm", "fsmGillA7.fsm", "garage.fsm" };
+
+    for ( auto f : fsmFiles ) {
+
+        shared_ptr<FsmPresentationLayer> pl = make_shared<FsmPresentationLayer>();
+        Fsm fsm("../../../resources/" + f,pl,"F");
+
+        // Calculate the OFSM tables row by row, as before the
+        // introduction of signature refinement
+        shared_ptr<OFSMTable> tbl =
+        make_shared<OFSMTable>(fsm.getNodes(),
+                               fsm.getMaxInput(),
+                               fsm.getMaxOutput(),
+                               pl);
+        for ( shared_ptr<OFSMTable> next = tbl->next();
+              next != nullptr;
+              next = tbl->next() ) {
+            tbl = next;
+        }
+        Fsm expected = tbl->toFsm(fsm.getName() + "_MIN");
+
+        Fsm fsmMin = fsm.minimiseObservableFSM();
+
+        stringstream expectedDot;
+        stringstream minDot;
+        expectedDot << expected;
+        minDot << fsmMin;
+
+        fsmlib_assert("TC-FSM-0011",
+               expectedDot.str() == minDot.str(),
+               "Both minimisations of " + f + " create the same FSM");
+
+    }
+
+}
+
+void test19() {
+
+    cout << "TC-FSM-0012 Show that Fsm::transformToObservableFSM() creates the "
+    << "states and transitions of the breadth-first subset construction"
+    << endl;
+
+    vector< pair<string,shared_ptr<Fsm>> > fsms;
+    vector<string> fsmFiles = { "nonObservable.fsm", "NFSM1.fsm", "NN.fsm",
+        "fsmdump.fsm", "nondetnonmin.fsm", "adaptive2.fsm" };
+    for ( auto f : fsmFiles ) {
+        fsms.push_back(make_pair(f,
+                                 make_shared<Fsm>("../../../resources/" + f,
+                                                  make_shared<FsmPresentationLayer>(),
+                                                  "F")));
+    }
+    for ( unsigned seed = 1; seed <= 4; seed++ ) {
+        fsms.push_back(make_pair("random FSM " + to_string(seed),
+                                 Fsm::createRandomFsm("R",2,2,7,
+                                                      make_shared<FsmPresentationLayer>(),
+                                                      seed)));
+    }
+
+    for ( auto p : fsms ) {
+
+        shared_ptr<Fsm> fsm = p.second;
+        vector<shared_ptr<FsmNode>> nodes = fsm->getNodes();
+
+        // Subset construction on sets of state ids: new states are
+        // numbered in breadth-first order, the labels of each state
+        // are processed in ascending order of inputs and outputs
+        map<set<int>,int> subsetIds;
+        vector< set<int> > subsets;
+        vector< vector< vector<int> > > expected;
+
+        subsets.push_back(set<int>({ fsm->getInitStateIdx() }));
+        subsetIds[subsets[0]] = 0;
+        for ( size_t s = 0; s < subsets.size(); s++ ) {
+            vector< vector<int> > transitions;
+            for ( int x = 0; x <= fsm->getMaxInput(); x++ ) {
+                for ( int y = 0; y <= fsm->getMaxOutput(); y++ ) {
+                    set<int> post;
+                    for ( int n : subsets[s] ) {
+                        for ( auto tr : nodes[n]->getTransitions() ) {
+                            if ( tr->getLabel()->getInput() == x and
+                                 tr->getLabel()->getOutput() == y ) {
+                                post.insert(tr->getTarget()->getId());
+                            }
+                        }
+                    }
+                    if ( post.empty() ) continue;
+                    if ( subsetIds.find(post) == subsetIds.end() ) {
+                        int id = (int)subsets.size();
+                        subsetIds[post] = id;
+                        subsets.push_back(post);
+                    }
+                    transitions.push_back({ x, y, subsetIds[post] });
+                }
+            }
+            expected.push_back(transitions);
+        }
+
+        Fsm obs = fsm->transformToObservableFSM();
+
+        vector< vector< vector<int> > > observed;
+        for ( auto n : obs.getNodes() ) {
+            vector< vector<int> > transitions;
+            for ( auto tr : n->getTransitions() ) {
+                transitions.push_back({ tr->getLabel()->getInput(),
+                    tr->getLabel()->getOutput(),
+                    tr->getTarget()->getId() });
+            }
+            sort(transitions.begin(),transitions.end());
+            observed.push_back(transitions);
+        }
+
+        fsmlib_assert("TC-FSM-0012",
+               obs.isObservable() and
+               obs.getInitStateIdx() == 0 and
+               observed == expected,
+               "Observable FSM of " + p.first + " matches the subset construction");
+
+    }
+
+}
+
+/**
+ * Calculate for every pair of states of an observable FSM the smallest
+ * l such that the states are r(l)-distinguishable, 0 if there is none,
+ * by evaluating the definition level by level
+ */
+static vector< vector<size_t> > calcRDistinguishabilityLevels(Fsm& fsm) {
+
+    vector<shared_ptr<FsmNode>> nodes = fsm.getNodes();
+    size_t n = nodes.size();
+
+    // post[q][x] maps every output y of state q under input x
+    // to the post-state
+    vector< vector< map<int,int> > > post(n);
+    for ( size_t q = 0; q < n; q++ ) {
+        post[q].resize(fsm.getMaxInput() + 1);
+        for ( auto tr : nodes[q]->getTransitions() ) {
+            post[q][tr->getLabel()->getInput()][tr->getLabel()->getOutput()] =
+            tr->getTarget()->getId();
+        }
+    }
+
+    vector< vector<size_t> > levels(n,vector<size_t>(n,0));
+    bool changed = true;
+    for ( size_t l = 1; changed; l++ ) {
+        changed = false;
+        vector< vector<size_t> > next = levels;
+        for ( size_t q1 = 0; q1 < n; q1++ ) {
+            for ( size_t q2 = q1 + 1; q2 < n; q2++ ) {
+                if ( levels[q1][q2] != 0 ) continue;
+                for ( int x = 0; x <= fsm.getMaxInput(); x++ ) {
+                    // x distinguishes q1 and q2 if every output they
+                    // have in common leads to distinct post-states that
+                    // are r(l-1)-distinguishable
+                    bool distinguishes = true;
+                    for ( auto yt : post[q1][x] ) {
+                        auto other = post[q2][x].find(yt.first);
+                        if ( other == post[q2][x].end() ) continue;
+                        if ( yt.second == other->second or
+                             levels[yt.second][other->second] == 0 ) {
+                            distinguishes = false;
+                            break;
+                        }
+                    }
+                    if ( distinguishes ) {
+                        next[q1][q2] = next[q2][q1] = l;
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+        levels = next;
+    }
+    return levels;
+
+}
+
+void test20() {
+
+    cout << "TC-FSM-0013 Show that Fsm::calcRDistinguishableStates() finds the "
+    << "r(l)-distinguishable states for the smallest l"
+    << endl;
+
+    vector<string> fsmFiles = { "M0.fsm", "M1.fsm", "M2.fsm", "NMIN.fsm",
+        "NN.fsm", "adaptive.fsm", "adaptive2.fsm", "example-master-m1.fsm",
+        "fsmdump.fsm", "nondetnonmin.fsm", "wp1ref.fsm", "garage.fsm" };
+
+    for ( auto f : fsmFiles ) {
+
+        shared_ptr<FsmPresentationLayer> pl = make_shared<FsmPresentationLayer>();
+        Fsm fsm("../../../resources/" + f,pl,"F");
+        vector< vector<size_t> > expected = calcRDistinguishabilityLevels(fsm);
+
+        for ( unsigned int numThreads : { 1, 4 } ) {
+
+            Fsm rFsm("../../../resources/" + f,pl,"F");
+            rFsm.calcRDistinguishableStates(numThreads);
+
+            vector<shared_ptr<FsmNode>> nodes = rFsm.getNodes();
+            bool ok = true;
+            for ( size_t q1 = 0; q1 < nodes.size(); q1++ ) {
+                shared_ptr<RDistinguishability> r = nodes[q1]->getRDistinguishability();
+                for ( size_t q2 = 0; q2 < nodes.size() and ok; q2++ ) {
+                    if ( q1 == q2 ) continue;
+                    size_t l = expected[q1][q2];
+                    if ( l == 0 ) {
+                        ok = not r->isRDistinguishableWith(nodes[q2]);
+                    }
+                    else {
+                        ok = r->isRDistinguishableWith(l,nodes[q2]) and
+                        (l == 1 or not r->isRDistinguishableWith(l - 1,nodes[q2]));
+                    }
+                }
+            }
+
+            fsmlib_assert("TC-FSM-0013",
+                   ok,
+                   "r-distinguishability levels of " + f + " calculated with " +
+                   to_string(numThreads) + " threads");
+
+        }
+
+    }
+
+}
+
+/**
+ * Collect the input traces of length len that yield the same outputs
+ * from s1 and s2 on all but the last input, and distinct outputs on
+ * the last one, in lexicographic order
+ */
+static void collectDistTraces(const DfsmExecutionTable& tbl,
+                              const int s1,
+                              const int s2,
+                              const size_t len,
+                              vector<int>& prefix,
+                              vector< vector<int> >& traces) {
+
+    for ( int x = 0; x < tbl.getNumInputs(); x++ ) {
+        int y1 = tbl.getOutput(s1,x);
+        int y2 = tbl.getOutput(s2,x);
+        prefix.push_back(x);
+        if ( prefix.size() == len ) {
+            if ( y1 != y2 ) traces.push_back(prefix);
+        }
+        else if ( y1 == y2 and y1 >= 0 and
+                  tbl.getNext(s1,x) != tbl.getNext(s2,x) ) {
+            collectDistTraces(tbl,tbl.getNext(s1,x),tbl.getNext(s2,x),
+                              len,prefix,traces);
+        }
+        prefix.pop_back();
+    }
+
+}
+
+void test21() {
+
+    cout << "TC-DFSM-0017 Show that Dfsm::calculateDistMatrix() finds all "
+    << "shortest distinguishing traces of every pair of states"
+    << endl;
+
+    for ( auto model : dfsmModels ) {
+
+        shared_ptr<Dfsm> d = readDfsmModel(model);
+        const DfsmExecutionTable& tbl = d->getExecutionTable();
+        int n = tbl.size();
+
+        // Enumerate the traces of increasing length until a
+        // distinguishing one is found
+        vector< vector< vector< vector<int> > > > expected(n,vector< vector< vector<int> > >(n));
+        for ( int s1 = 0; s1 < n; s1++ ) {
+            for ( int s2 = s1 + 1; s2 < n; s2++ ) {
+                for ( int len = 1; len <= n and expected[s1][s2].empty(); len++ ) {
+                    vector<int> prefix;
+                    collectDistTraces(tbl,s1,s2,(size_t)len,prefix,expected[s1][s2]);
+                }
+            }
+        }
+
+        for ( unsigned int numThreads : { 1, 4 } ) {
+
+            d->calculateDistMatrix(numThreads);
+            shared_ptr<const DistinguishingTraceMatrix> m = d->getDistMatrix();
+
+            bool ok = true;
+            for ( int s1 = 0; s1 < n and ok; s1++ ) {
+                for ( int s2 = s1 + 1; s2 < n and ok; s2++ ) {
+                    vector< vector<int> >& traces = expected[s1][s2];
+                    size_t len = traces.empty() ? 0 : traces[0].size();
+                    ok = m->getTraceLength(s1,s2) == len and
+                    m->getNumTraces(s1,s2) == traces.size();
+                    for ( size_t k = 0; k < traces.size() and ok; k++ ) {
+                        const int* trc = m->getTrace(s1,s2,k);
+                        ok = vector<int>(trc,trc + len) == traces[k];
+                    }
+                }
+            }
+
+            fsmlib_assert("TC-DFSM-0017",
+                   ok,
+                   "Distinguishing traces of " + model.first + " calculated with " +
+                   to_string(numThreads) + " threads");
+
+        }
+
+    }
+
+}
+
+/**
+ * FSM read from a file in .fsm format by only one of the two parsers
+ * used by Fsm::readFsm()
+ */
+class FsmParserProbe : public Fsm {
+public:
+    /** False if the fast parser was selected and rejected the file */
+    bool parsed;
+
+    FsmParserProbe(const string& fname,
+                   const shared_ptr<FsmPresentationLayer>& pl,
+                   const bool fast) : Fsm(pl), parsed(true) {
+        name = "F";
+        if ( fast ) {
+            parsed = readFsmFast(fname);
+        }
+        else {
+            readFsmStream(fname);
+        }
+        if ( parsed and initStateIdx >= 0 ) nodes[initStateIdx]->markAsInitial();
+    }
+};
+
+void test22() {
+
+    cout << "TC-FSM-0014 Show that the fast .fsm parser creates the same FSM "
+    << "as the line parser"
+    << endl;
+
+    vector<string> fsmFiles;
+    for ( auto f : { "M0.fsm", "NFSM1.fsm", "NN.fsm", "TC-DFSM-0001.fsm",
+        "TC-FSM-0005.fsm", "adaptive2.fsm", "example-master-m1.fsm",
+        "fsmGillA7.fsm", "fsmdump.fsm", "garage.fsm", "huang201711.fsm",
+        "nonObservable.fsm", "nondetnonmin.fsm", "wp1ref.fsm" } ) {
+        fsmFiles.push_back(string("../../../resources/") + f);
+    }
+
+    // Files with CRLF line ends, signs, rows rejected by the
+    // line parser and text following the fourth integer
+    vector< pair<string,string> > edgeCases = {
+        { "TC-FSM-0014-crlf.fsm", "0 0 1 1\r\n1 1 0 0\r\n1 0 1 2\r\n" },
+        { "TC-FSM-0014-signs.fsm", "+1 0 1 0\n0 +1 0 -1\n0 -1 0 1\n-2 0 0 0\n0 0 0 1" },
+        { "TC-FSM-0014-text.fsm", "2 0 0 1 from 2 to 1\n1 1 1 2\t# comment\n" },
+        { "TC-FSM-0014-gaps.fsm", "0 0 0 4\n4 1 1 0\n" }
+    };
+    for ( auto e : edgeCases ) {
+        ofstream out(e.first);
+        out << e.second;
+        out.close();
+        fsmFiles.push_back(e.first);
+    }
+
+    // A larger random FSM
+    mt19937 gen(17);
+    ofstream out("TC-FSM-0014-random.fsm");
+    for ( int s = 0; s < 2000; s++ ) {
+        for ( int x = 0; x < 5; x++ ) {
+            out << s << " " << x << " " << gen() % 4 << " " << gen() % 2000 << endl;
+        }
+    }
+    out.close();
+    fsmFiles.push_back("TC-FSM-0014-random.fsm");
+
+    for ( auto f : fsmFiles ) {
+
+        FsmParserProbe fast(f,make_shared<FsmPresentationLayer>(),true);
+        FsmParserProbe lines(f,make_shared<FsmPresentationLayer>(),false);
+
+        stringstream fastDot;
+        stringstream linesDot;
+        fastDot << fast;
+        linesDot << lines;
+
+        fsmlib_assert("TC-FSM-0014",
+               fast.parsed and
+               fast.getMaxInput() == lines.getMaxInput() and
+               fast.getMaxOutput() == lines.getMaxOutput() and
+               fast.size() == lines.size() and
+               fast.getInitStateIdx() == lines.getInitStateIdx() and
+               fastDot.str() == linesDot.str(),
+               "Both parsers read " + f + " into the same FSM");
+
+    }
+
+}
+
+/**
+ * Describe an FSM: its states with their names, the initial state and
+ * the transitions, the names of its presentation layer, and the
+ * requirements satisfied by states and transitions
+ */
+static string describeFsm(Fsm& d) {
+
+    stringstream s;
+    s << d;
+    d.getPresentationLayer()->dumpIn(s);
+    d.getPresentationLayer()->dumpOut(s);
+    d.getPresentationLayer()->dumpState(s);
+    for ( auto n : d.getNodes() ) {
+        s << n->getId() << " " << n->getName()
+        << (n == d.getInitialState() ? " initial" : "") << ":";
+        for ( auto r : n->getSatisfied() ) s << " " << r;
+        s << endl;
+        for ( auto tr : n->getTransitions() ) {
+            s << "  " << tr->getLabel()->getInput() << "/"
+            << tr->getLabel()->getOutput() << " -> "
+            << tr->getTarget()->getId() << ":";
+            for ( auto r : tr->getSatisfied() ) s << " " << r;
+            s << endl;
+        }
+    }
+    return s.str();
+
+}
+
+void test23() {
+
+    cout << "TC-DFSM-0018 Show that JsonModelReader creates the same DFSMs "
+    << "as the Dfsm constructors taking a jsoncpp document"
+    << endl;
+
+    // A model with requirements, escaped names, a transition with
+    // several inputs, inputs requiring NOP self-loops, a state which
+    // is not initial first and members in unusual order
+    ofstream out("TC-DFSM-0018.fsm");
+    out << "{\"states\":[{\"name\":\"s\\\"1\",\"initial\":false,"
+    << "\"requirements\":[\"R2\"],\"view\":{\"x\":1.5,\"y\":-2e3}},"
+    << "{\"initial\":true,\"name\":\"s0\",\"requirements\":[\"R1\",\"R3\"]}],"
+    << "\"inputs\":[\"a\",\"b\",\"\\u0063\"],\"outputs\":[\"x\",\"y\"],"
+    << "\"requirements\":[\"R1\",\"R2\",\"R3\"],"
+    << "\"transitions\":["
+    << "{\"source\":\"s0\",\"target\":\"s\\\"1\",\"input\":[\"a\",\"c\"],"
+    << "\"output\":\"x\",\"requirements\":[\"R1\"]},"
+    << "{\"source\":\"s\\\"1\",\"target\":\"s0\",\"input\":[\"b\"],"
+    << "\"output\":\"y\",\"requirements\":[]},"
+    << "{\"requirements\":[\"R2\",\"R3\"],\"output\":\"x\",\"input\":[\"a\"],"
+    << "\"target\":\"s\\\"1\",\"source\":\"s\\\"1\"}]}" << endl;
+    out.close();
+
+    vector<string> jsonFiles = { "TC-DFSM-0018.fsm" };
+    for ( auto model : dfsmModels ) {
+        if ( model.second ) {
+            jsonFiles.push_back("../../../resources/" + model.first);
+        }
+    }
+
+    shared_ptr<FsmPresentationLayer> refPl =
+    readJsonDfsm("../../../resources/csm0.fsm")->getPresentationLayer();
+
+    for ( auto f : jsonFiles ) {
+
+        Reader jReader;
+        Value root;
+        stringstream document;
+        ifstream inputFile(f);
+        document << inputFile.rdbuf();
+        inputFile.close();
+
+        JsonModelReader modelReader;
+        JsonFsmModel model;
+        ifstream modelFile(f);
+        bool parsed = jReader.parse(document.str(),root) and
+        modelReader.read(modelFile,model);
+        modelFile.close();
+
+        if ( not parsed ) {
+            fsmlib_assert("TC-DFSM-0018",
+                   false,
+                   "Both readers parse " + f);
+            continue;
+        }
+
+        Dfsm fromDocument(root);
+        Dfsm fromModel(model);
+        fsmlib_assert("TC-DFSM-0018",
+               describeFsm(fromDocument) == describeFsm(fromModel),
+               "Both readers create the same DFSM from " + f);
+
+        // Inputs and outputs unknown to the given presentation
+        // layer are appended to it
+        Dfsm fromDocumentPl(root,make_shared<FsmPresentationLayer>(*refPl));
+        Dfsm fromModelPl(model,make_shared<FsmPresentationLayer>(*refPl));
+        fsmlib_assert("TC-DFSM-0018",
+               describeFsm(fromDocumentPl) == describeFsm(fromModelPl),
+               "Both readers create the same DFSM from " + f +
+               " with the presentation layer of csm0.fsm");
+
+    }
+
+}
+
+void test24() {
+
+    cout << "TC-FSM-0015 Show that the transition tables follow changes "
+    << "made through the FsmNode and FsmTransition setters"
+    << endl;
+
+    for ( auto model : dfsmModels ) {
+
+        shared_ptr<Dfsm> d = readDfsmModel(model);
+        vector< shared_ptr<FsmNode> > nodes = d->getNodes();
+        int s = d->getInitStateIdx();
+        shared_ptr<FsmNode> node = nodes[s];
+        if ( node->getTransitions().empty() or nodes.size() < 2 ) continue;
+
+        // Query the tables before each change
+        shared_ptr<FsmTransition> tr = node->getTransitions()[0];
+        int x = tr->getLabel()->getInput();
+        int y = tr->getLabel()->getOutput();
+        int t = d->getCsrTransitionTable()->getIndex(tr->getTarget().get());
+        int u = (t + 1) % nodes.size();
+        bool wasDeterministic = d->isDeterministic();
+        int nextBefore = d->getExecutionTable().getNext(s,x);
+        int numTransitions = d->getCsrTransitionTable()->getNumTransitions();
+
+        // A second transition with input x makes the DFSM nondeterministic
+        shared_ptr<FsmTransition> extra =
+        make_shared<FsmTransition>(node,nodes[u],
+                                   make_shared<FsmLabel>(x,y,d->getPresentationLayer()));
+        node->addTransition(extra);
+        fsmlib_assert("TC-FSM-0015",
+               wasDeterministic and not d->isDeterministic()
+               and not d->isObservable(),
+               "addTransition() is visible to the next query for " + model.first);
+
+        node->removeTransition(extra);
+        fsmlib_assert("TC-FSM-0015",
+               d->isDeterministic() and
+               d->getCsrTransitionTable()->getNumTransitions() == numTransitions,
+               "removeTransition() is visible to the next query for " + model.first);
+
+        tr->setTarget(nodes[u]);
+        fsmlib_assert("TC-FSM-0015",
+               nextBefore == t and d->getExecutionTable().getNext(s,x) == u,
+               "FsmTransition::setTarget() is visible to the next query for " + model.first);
+        tr->setTarget(nodes[t]);
+
+        int y2 = (y + 1) % (d->getMaxOutput() + 1);
+        tr->setLabel(make_shared<FsmLabel>(x,y2,d->getPresentationLayer()));
+        fsmlib_assert("TC-FSM-0015",
+               d->getExecutionTable().getOutput(s,x) == y2 and
+               d->getExecutionTable().getNext(s,x) == t,
+               "FsmTransition::setLabel() is visible to the next query for " + model.first);
+
+        vector< shared_ptr<FsmTransition> > trs = node->getTransitions();
+        trs.erase(trs.begin());
+        node->setTransitions(trs);
+        fsmlib_assert("TC-FSM-0015",
+               d->getCsrTransitionTable()->getNumTransitions() == numTransitions - 1,
+               "FsmNode::setTransitions() is visible to the next query for " + model.first);
+    }
+
+}
+
+static string readBinaryFile(const string& fname) {
+
+    ifstream in(fname, ios::binary);
+    stringstream s;
+    s << in.rdbuf();
+    return s.str();
+
+}
+
+static void writeBinaryFile(const string& fname, const string& contents) {
+
+    ofstream out(fname, ios::binary | ios::trunc);
+    out << contents;
+
+}
+
+void test25() {
+
+    cout << "TC-FSM-0016 Show that FsmSnapshot::save() and FsmSnapshot::open() "
+    << "reproduce the FSM, and that corrupt snapshots are rejected"
+    << endl;
+
+    // Nondeterministic FSMs, with and without presentation layer
+    vector< vector<string> > fsmFiles = {
+        { "N1MIN.fsm" }, { "NN.fsm" }, { "nondetnonmin.fsm" },
+        { "example-master-m1.fsm", "example-master-m1.in",
+          "example-master-m1.out", "example-master-m1.state" },
+        { "adaptive.fsm", "adaptiveIn.txt", "adaptiveOut.txt", "adaptiveState.txt" }
+    };
+
+    for ( auto f : fsmFiles ) {
+
+        string prefix = "../../../resources/";
+        shared_ptr<FsmPresentationLayer> pl = ( f.size() == 1 ) ?
+        make_shared<FsmPresentationLayer>() :
+        make_shared<FsmPresentationLayer>(prefix + f[1],prefix + f[2],prefix + f[3]);
+        Fsm fsm(prefix + f[0],pl,"F");
+
+        bool saved = FsmSnapshot::save(fsm,"TC-FSM-0016.snap");
+        shared_ptr<FsmSnapshot> snapshot = FsmSnapshot::open("TC-FSM-0016.snap");
+        if ( not saved or snapshot == nullptr ) {
+            fsmlib_assert("TC-FSM-0016", false, "Snapshot of " + f[0] + " can be saved and opened");
+            continue;
+        }
+        shared_ptr<Fsm> loaded = snapshot->createFsm();
+
+        fsmlib_assert("TC-FSM-0016",
+               describeFsm(fsm) == describeFsm(*loaded)
+               and fsm.getName() == loaded->getName(),
+               "Snapshot of " + f[0] + " reproduces states, names and transitions");
+        fsmlib_assert("TC-FSM-0016",
+               snapshot->createDfsm() == nullptr,
+               "Snapshot of nondeterministic " + f[0] + " does not create a DFSM");
+
+        // The test cases must not depend on the way the model was loaded
+        stringstream wpFsm;
+        stringstream wpLoaded;
+        wpFsm << fsm.wpMethod(1,1);
+        wpLoaded << loaded->wpMethod(1,1);
+        fsmlib_assert("TC-FSM-0016",
+               wpFsm.str() == wpLoaded.str(),
+               "Snapshot of " + f[0] + " yields the same Wp test suite");
+    }
+
+    for ( auto model : dfsmModels ) {
+
+        shared_ptr<Dfsm> d = readDfsmModel(model);
+        shared_ptr<FsmSnapshot> snapshot;
+        if ( FsmSnapshot::save(*d,"TC-FSM-0016.snap") ) {
+            snapshot = FsmSnapshot::open("TC-FSM-0016.snap");
+        }
+        shared_ptr<Dfsm> loaded = ( snapshot != nullptr ) ? snapshot->createDfsm() : nullptr;
+        if ( loaded == nullptr ) {
+            fsmlib_assert("TC-FSM-0016", false, "Snapshot of " + model.first + " creates a DFSM");
+            continue;
+        }
+        fsmlib_assert("TC-FSM-0016",
+               describeFsm(*d) == describeFsm(*loaded)
+               and d->getName() == loaded->getName(),
+               "Snapshot of DFSM " + model.first + " reproduces states, names, "
+               "transitions and requirements");
+    }
+
+    // Corrupt copies of a valid snapshot, see the header layout in FsmSnapshot.cpp
+    shared_ptr<FsmPresentationLayer> pl = make_shared<FsmPresentationLayer>();
+    Fsm fsm("../../../resources/N1MIN.fsm",pl,"F");
+    FsmSnapshot::save(fsm,"TC-FSM-0016.snap");
+    const string valid = readBinaryFile("TC-FSM-0016.snap");
+
+    auto patch = [&valid](size_t pos, uint32_t value) {
+        string s = valid;
+        memcpy(&s[pos], &value, sizeof(value));
+        return s;
+    };
+    uint64_t targetsSection;
+    memcpy(&targetsSection, &valid[48 + 3 * 8], sizeof(targetsSection));
+
+    vector< pair<string,string> > corrupt = {
+        { "empty file", "" },
+        { "truncated header", valid.substr(0, 40) },
+        { "truncated file", valid.substr(0, valid.size() - 4) },
+        { "appended data", valid + "x" },
+        { "missing magic number", patch(0, 0) },
+        { "different byte order", patch(8, 0x04030201) },
+        { "unknown version", patch(12, FsmSnapshot::formatVersion + 1) },
+        { "illegal initial state", patch(32, 6) },
+        { "illegal number of transitions", patch(36, 1000) },
+        { "corrupt section table", patch(48 + 8, 3) },
+        { "illegal transition target", patch(targetsSection, 6) }
+    };
+
+    for ( auto c : corrupt ) {
+        writeBinaryFile("TC-FSM-0016.snap", c.second);
+        fsmlib_assert("TC-FSM-0016",
+               FsmSnapshot::open("TC-FSM-0016.snap") == nullptr,
+               "Snapshot with " + c.first + " is rejected");
+    }
+    fsmlib_assert("TC-FSM-0016",
+           FsmSnapshot::open("TC-FSM-0016-missing.snap") == nullptr
+           and not FsmSnapshot::isSnapshotFile("../../../resources/N1MIN.fsm"),
+           "Missing files and .fsm files are not opened as snapshots");
+
+}
+/**
+ * Outputs produced by a DFSM for an input trace, computed on the FsmNode
+ * graph; the trace ends where the DFSM does not accept the next input
+ */
+static vector<int> applyOnNodes(Dfsm& d, const vector<int>& inputs) {
+
+    InputTrace itrc(inputs,d.getPresentationLayer());
+    vector<OutputTrace> traces = d.apply(itrc).getOutputTraces();
+    return traces.empty() ? vector<int>() : traces.front().get();
+
+}
+
+void test26() {
+
+    cout << "TC-DFSM-0019 Show that MutationAnalysis calculates the kill matrix "
+    << "obtained by applying the test cases to each mutant"
+    << endl;
+
+    vector<string> models = { "fsmGillA7.fsm", "garage.fsm", "TC-FSM-0005.fsm" };
+
+    for ( auto model : models ) {
+
+        shared_ptr<Dfsm> ref = readDfsmModel(make_pair(model,false));
+        vector< vector<int> > testCases = *ref->wpMethod(1).getIOLists();
+        testCases.push_back(vector<int>());
+
+        // More than two batches of 64 mutants, the last one incomplete.
+        // Every fourth mutant lacks a transition, so that its lane
+        // enters the sink state, and one mutant equals the reference.
+        vector< shared_ptr<Dfsm> > mutants;
+        mutants.push_back(make_shared<Dfsm>(*ref));
+        for ( unsigned m = 1; mutants.size() < 150; m++ ) {
+            shared_ptr<Fsm> f = ref->createMutant("M",m % 2,(m + 1) % 2,false,m);
+            if ( not f->isDeterministic() ) continue;
+            shared_ptr<Dfsm> mutant = make_shared<Dfsm>(*f);
+            if ( m % 4 == 0 ) {
+                shared_ptr<FsmNode> n = mutant->getNodes()[m % mutant->size()];
+                if ( not n->getTransitions().empty() ) {
+                    n->removeTransition(n->getTransitions()[m % n->getTransitions().size()]);
+                }
+            }
+            mutants.push_back(mutant);
+        }
+
+        // Expected kill matrix: test case k kills mutant m if the mutant
+        // produces other outputs than the reference, or accepts a
+        // different prefix of the inputs
+        vector< vector<bool> > expected(testCases.size(),vector<bool>(mutants.size()));
+        vector<size_t> firstKill(mutants.size(),testCases.size());
+        size_t numKilled = 0;
+        for ( size_t k = 0; k < testCases.size(); k++ ) {
+            vector<int> refOut = applyOnNodes(*ref,testCases[k]);
+            for ( size_t m = 0; m < mutants.size(); m++ ) {
+                expected[k][m] = ( applyOnNodes(*mutants[m],testCases[k]) != refOut );
+                if ( expected[k][m] and firstKill[m] == testCases.size() ) {
+                    firstKill[m] = k;
+                    numKilled++;
+                }
+            }
+        }
+
+        vector<DfsmExecutionTable> tables;
+        for ( auto mutant : mutants ) {
+            tables.push_back(mutant->getExecutionTable());
+        }
+        MutationAnalysis analysis(ref->getExecutionTable(),tables,testCases);
+
+        for ( bool dropKilled : { false, true } ) {
+            for ( unsigned numThreads : { 1u, 3u } ) {
+
+                analysis.run(numThreads,dropKilled);
+
+                bool sameMatrix = true;
+                bool sameKilled = true;
+                for ( size_t m = 0; m < mutants.size(); m++ ) {
+                    for ( size_t k = 0; k < testCases.size(); k++ ) {
+                        bool exp = dropKilled ? ( k == firstKill[m] ) : expected[k][m];
+                        if ( analysis.kills(k,m) != exp ) sameMatrix = false;
+                    }
+                    if ( analysis.isKilled(m) != ( firstKill[m] < testCases.size() ) ) {
+                        sameKilled = false;
+                    }
+                }
+
+                string config = model + ( dropKilled ? " with" : " without" )
+                + " dropping killed mutants, " + to_string(numThreads) + " thread(s)";
+                fsmlib_assert("TC-DFSM-0019",
+                       sameMatrix,
+                       "Kill matrix equals the one obtained by Dfsm::apply() for " + config);
+                fsmlib_assert("TC-DFSM-0019",
+                       sameKilled and analysis.getNumKilled() == numKilled and
+                       analysis.getMutationScore() ==
+                       static_cast<double>(numKilled) / mutants.size(),
+                       "Killed mutants and mutation score are correct for " + config);
+            }
+        }
+
+        fsmlib_assert("TC-DFSM-0019",
+               firstKill[0] == testCases.size() and numKilled > 0,
+               "The copy of the reference survives and other mutants are killed for " + model);
+    }
+
+}
+/**
+ * Read the test cases of a test suite trie file in the format of
+ * the text file written by TestSuite::save()
+ * @return false if the file could not be read completely
+ */
+static bool readTrieTestCases(const string& fname, vector<string>& testCases) {
+
+    TestSuiteTrieReader reader;
+    if ( not reader.open(fname) ) return false;
+    vector< pair<int,int> > tc;
+    while ( reader.next(tc) ) {
+        stringstream s;
+        for ( size_t i = 0; i < tc.size(); i++ ) {
+            if ( i > 0 ) s << ".";
+            s << "(" << reader.getInName(tc[i].first) << "/"
+            << reader.getOutName(tc[i].second) << ")";
+        }
+        testCases.push_back(s.str());
+    }
+    return reader.getError().empty();
+
+}
+
+void test27() {
+
+    cout << "TC-FSM-0017 Show that a test suite saved as TestSuiteTrie contains "
+    << "the test cases of the text format, and that corrupt files are rejected"
+    << endl;
+
+    vector< vector<string> > fsmFiles = {
+        { "N1MIN.fsm" }, { "nondetnonmin.fsm" },
+        { "garage.fsm", "garageIn.txt", "garageOut.txt", "garageState.txt" },
+        { "example-master-m1.fsm", "example-master-m1.in",
+          "example-master-m1.out", "example-master-m1.state" }
+    };
+
+    for ( auto f : fsmFiles ) {
+
+        string prefix = "../../../resources/";
+        shared_ptr<FsmPresentationLayer> pl = ( f.size() == 1 ) ?
+        make_shared<FsmPresentationLayer>() :
+        make_shared<FsmPresentationLayer>(prefix + f[1],prefix + f[2],prefix + f[3]);
+        Fsm fsm(prefix + f[0],pl,"F");
+
+        // Empty and duplicate test cases included
+        IOListContainer iolc = fsm.wMethod(1);
+        vector< vector<int> > inputs = *iolc.getIOLists();
+        inputs.push_back(vector<int>());
+        inputs.push_back(inputs.front());
+        inputs.push_back(vector<int>());
+        TestSuite suite;
+        for ( auto in : inputs ) {
+            suite.push_back(fsm.apply(InputTrace(in,pl)));
+        }
+
+        suite.save("TC-FSM-0017.txt");
+        suite.save("TC-FSM-0017.trie",true);
+
+        // Readers of the text format skip empty lines
+        multiset<string> expected;
+        ifstream text("TC-FSM-0017.txt");
+        string line;
+        while ( getline(text,line) ) {
+            if ( not line.empty() ) expected.insert(line);
+        }
+
+        vector<string> fromTrie;
+        bool read = readTrieTestCases("TC-FSM-0017.trie",fromTrie);
+        fsmlib_assert("TC-FSM-0017",
+               read and TestSuiteTrie::isTrieFile("TC-FSM-0017.trie")
+               and not TestSuiteTrie::isTrieFile("TC-FSM-0017.txt"),
+               "Trie of the test suite of " + f[0] + " is read without error");
+        fsmlib_assert("TC-FSM-0017",
+               multiset<string>(fromTrie.begin(),fromTrie.end()) == expected,
+               "Trie and text file of the test suite of " + f[0] + " contain the same test cases");
+    }
+
+    // Every proper prefix of a valid file is rejected, as are files with
+    // a wrong magic number, an unknown version or a corrupt name length
+    const string valid = readBinaryFile("TC-FSM-0017.trie");
+    bool allRejected = true;
+    for ( size_t len = 0; len < valid.size(); len++ ) {
+        writeBinaryFile("TC-FSM-0017.trie",valid.substr(0,len));
+        vector<string> tcs;
+        if ( readTrieTestCases("TC-FSM-0017.trie",tcs) ) allRejected = false;
+    }
+    fsmlib_assert("TC-FSM-0017",
+           allRejected,
+           "Truncated test suite trie files are rejected");
+
+    string badMagic = valid;
+    badMagic[0] = 'X';
+    string badVersion = valid;
+    badVersion[8] = static_cast<char>(TestSuiteTrie::formatVersion + 1);
+    // The length of the first input name follows the magic number,
+    // the version and the number of input names
+    TestSuiteTrieReader probe;
+    probe.open("TC-FSM-0017-missing.trie");
+    vector< pair<string,string> > corrupt = {
+        { "wrong magic number", badMagic },
+        { "unknown version", badVersion },
+        { "huge name length", valid.substr(0,10) + string(4,'\xff') + string(1,'\x0f') }
+    };
+    for ( auto c : corrupt ) {
+        writeBinaryFile("TC-FSM-0017.trie",c.second);
+        vector<string> tcs;
+        fsmlib_assert("TC-FSM-0017",
+               not readTrieTestCases("TC-FSM-0017.trie",tcs),
+               "Test suite trie file with " + c.first + " is rejected");
+    }
+    fsmlib_assert("TC-FSM-0017",
+           not probe.getError().empty(),
+           "Missing test suite trie file is reported");
+
+}
+/**
+ *  Size of the smallest hitting set of a set system over the
+ *  elements 0..n-1, calculated by trying all subsets
+ */
+static size_t bruteForceHittingSetSize(const vector< unordered_set<int> >& sets,
+                                       int n) {
+
+    size_t best = n;
+    for ( unsigned int subset = 0; subset < (1u << n); subset++ ) {
+        size_t size = __builtin_popcount(subset);
+        if ( size >= best ) continue;
+        bool hits = true;
+        for ( auto& z : sets ) {
+            bool hit = false;
+            for ( int e : z ) {
+                if ( (subset >> e) & 1 ) hit = true;
+            }
+            if ( not hit ) hits = false;
+        }
+        if ( hits ) best = size;
+    }
+    return best;
+
+}
+
+static bool isHittingSet(const vector< unordered_set<int> >& sets,
+                         const unordered_set<int>& h) {
+
+    for ( auto& z : sets ) {
+        bool hit = false;
+        for ( int e : z ) {
+            if ( h.count(e) > 0 ) hit = true;
+        }
+        if ( not hit ) return false;
+    }
+    return true;
+
+}
+
+/**
+ *  The greedy hitting set HittingSet starts its search from: after
+ *  removing the sets containing a smaller one, repeatedly choose the
+ *  smallest element hitting the most sets which are not hit yet, then
+ *  drop the elements which have become redundant in ascending order.
+ */
+static unordered_set<int> greedyHittingSet(vector< unordered_set<int> > sets) {
+
+    stable_sort(sets.begin(), sets.end(),
+                [](const unordered_set<int>& a, const unordered_set<int>& b) {
+                    return a.size() < b.size();
+                });
+    vector< unordered_set<int> > kept;
+    set<int> elements;
+    for ( auto& z : sets ) {
+        bool dominated = false;
+        for ( auto& k : kept ) {
+            bool subset = true;
+            for ( int e : k ) {
+                if ( z.count(e) == 0 ) subset = false;
+            }
+            if ( subset ) dominated = true;
+        }
+        if ( not dominated ) kept.push_back(z);
+        elements.insert(z.begin(),z.end());
+    }
+
+    unordered_set<int> chosen;
+    while ( not isHittingSet(kept,chosen) ) {
+        int bestElement = 0;
+        size_t bestCount = 0;
+        for ( int e : elements ) {
+            size_t n = 0;
+            for ( auto& z : kept ) {
+                if ( z.count(e) > 0 and not isHittingSet({z},chosen) ) n++;
+            }
+            if ( n > bestCount ) {
+                bestCount = n;
+                bestElement = e;
+            }
+        }
+        chosen.insert(bestElement);
+    }
+    for ( int e : elements ) {
+        if ( chosen.erase(e) > 0 and not isHittingSet(kept,chosen) ) {
+            chosen.insert(e);
+        }
+    }
+    return chosen;
+
+}
+
+void test28() {
+
+    cout << "TC-HS-0001 Show that HittingSet::calcMinCardHittingSet() "
+    << "calculates smallest hitting sets, and hitting sets no larger "
+    << "than the greedy one when its budget is exhausted" << endl;
+
+    // Random set systems small enough to try all subsets
+    mt19937 gen(28);
+    bool allMinimal = true;
+    bool allOptimal = true;
+    for ( int i = 0; i < 200; i++ ) {
+        int n = 2 + gen() % 11;
+        size_t numSets = 1 + gen() % 12;
+        vector< unordered_set<int> > sets;
+        for ( size_t k = 0; k < numSets; k++ ) {
+            unordered_set<int> z;
+            size_t size = 1 + gen() % 4;
+            while ( z.size() < size and z.size() < (size_t)n ) {
+                z.insert(gen() % n);
+            }
+            sets.push_back(z);
+        }
+        size_t expected = bruteForceHittingSetSize(sets,n);
+
+        HittingSet hs(sets);
+        for ( unsigned int threads : { 1u, 3u } ) {
+            bool optimal = false;
+            unordered_set<int> h = hs.calcMinCardHittingSet(threads,0,0,optimal);
+            if ( not isHittingSet(sets,h) or h.size() != expected ) {
+                allMinimal = false;
+            }
+            if ( not optimal ) allOptimal = false;
+        }
+        if ( hs.calcMinCardHittingSet().size() != expected ) allMinimal = false;
+    }
+    fsmlib_assert("TC-HS-0001",
+           allMinimal,
+           "calcMinCardHittingSet() returns hitting sets of the size found by trying all subsets");
+    fsmlib_assert("TC-HS-0001",
+           allOptimal,
+           "calcMinCardHittingSet() without budget reports optimal results");
+
+    // More elements than fit into one word of the bitsets
+    vector< unordered_set<int> > pairs;
+    for ( int e = 0; e < 160; e += 2 ) {
+        pairs.push_back({ e, e + 1 });
+    }
+    bool optimal = false;
+    unordered_set<int> h = HittingSet(pairs).calcMinCardHittingSet(2,0,0,optimal);
+    fsmlib_assert("TC-HS-0001",
+           optimal and h.size() == pairs.size() and isHittingSet(pairs,h),
+           "calcMinCardHittingSet() handles more than 64 elements");
+
+    vector< unordered_set<int> > withEmpty = { { 1, 2 }, {}, { 3 } };
+    fsmlib_assert("TC-HS-0001",
+           HittingSet(withEmpty).calcMinCardHittingSet() == unordered_set<int>({ 1, 2, 3 }),
+           "calcMinCardHittingSet() returns the union of all sets if one of them is empty");
+
+    // In every block, the greedy solution first chooses b, which hits
+    // the most sets, and then b + 1 and b + 2 hitting the remaining sets,
+    // while { b + 3, b + 4 } is the smallest hitting set. Several blocks
+    // make sure that the search is not finished after a few nodes.
+    vector< unordered_set<int> > greedyTrap;
+    for ( int b = 0; b < 100; b += 10 ) {
+        greedyTrap.push_back({ b, b + 3, b + 5 });
+        greedyTrap.push_back({ b, b + 3, b + 6 });
+        greedyTrap.push_back({ b + 1, b + 3 });
+        greedyTrap.push_back({ b, b + 4, b + 7 });
+        greedyTrap.push_back({ b, b + 4, b + 8 });
+        greedyTrap.push_back({ b + 2, b + 4 });
+    }
+    HittingSet trap(greedyTrap);
+    unordered_set<int> greedy = greedyHittingSet(greedyTrap);
+    bool budgetRespected = true;
+    for ( size_t maxNodes : { 1, 2, 5, 20, 100 } ) {
+        for ( unsigned int threads : { 1u, 4u } ) {
+            optimal = true;
+            h = trap.calcMinCardHittingSet(threads,maxNodes,0,optimal);
+            if ( optimal or not isHittingSet(greedyTrap,h) or h.size() > greedy.size() ) {
+                budgetRespected = false;
+            }
+        }
+    }
+    fsmlib_assert("TC-HS-0001",
+           isHittingSet(greedyTrap,greedy) and greedy.size() == 30,
+           "Greedy hitting set of the trap blocks is a hitting set of size 30");
+    fsmlib_assert("TC-HS-0001",
+           budgetRespected,
+           "calcMinCardHittingSet() with exhausted node budget reports a non-optimal hitting set no larger than the greedy one");
+
+    unordered_set<int> smallest = trap.calcMinCardHittingSet(4,0,0,optimal);
+    fsmlib_assert("TC-HS-0001",
+           optimal and isHittingSet(greedyTrap,smallest)
+           and smallest.size() == 20
+           and smallest == trap.calcMinCardHittingSet(1,0,0,optimal),
+           "calcMinCardHittingSet() without budget improves on the greedy hitting set independent of the number of threads");
+
+}
+
+
+
+
 void faux() {
 
 
@@ -1611,11 +2820,10 @@ void printTestResult(AdaptiveTestResult& result, const CsvConfig& csvConfig,
     printTestResult(result, csvConfig, loggingConfig, dummyout);
 }
 
-bool isReduction(Fsm& spec, Fsm& iut, string intersectionName, shared_ptr<Fsm>& intersection)
+bool isReduction(Fsm& spec, Fsm& iut)
 {
-    Fsm inter = spec.intersect(iut, intersectionName);
-    intersection = make_shared<Fsm>(inter);
-    return !inter.hasFailure();
+    shared_ptr<IOTrace> failTrace;
+    return Fsm::isReduction(spec, iut, failTrace);
 }
 
 void executeAdaptiveTest(const string& testName, Fsm& spec, Fsm& iut, size_t m, string intersectionName,
@@ -1631,8 +2839,7 @@ void executeAdaptiveTest(const string& testName, Fsm& spec, Fsm& iut, size_t m,
     result.numInputs = specMin.getMaxInput() + 1;
     result.numOutputs = specMin.getMaxOutput() + 1;
 
-    shared_ptr<Fsm> intersection;
-    result.iutIsReduction = isReduction(specMin, iutMin, intersectionName, intersection);
+    result.iutIsReduction = isReduction(specMin, iutMin);
 
 
     if (toDot)
@@ -1641,7 +2848,8 @@ void executeAdaptiveTest(const string& testName, Fsm& spec, Fsm& iut, size_t m,
         iut.toDot(ascTestResultDirectory + testName + "-"  + iut.getName());
         specMin.toDot(ascTestResultDirectory + testName + "-"  + spec.getName() + "-min");
         iutMin.toDot(ascTestResultDirectory + testName + "-"  + iut.getName() + "-min");
-        intersection->toDot(ascTestResultDirectory + testName + "-"  + intersection->getName());
+        Fsm intersection = specMin.intersect(iutMin, intersectionName);
+        intersection.toDot(ascTestResultDirectory + testName + "-"  + intersection.getName());
     }
     if (toFsm)
     {
@@ -2845,6 +4053,18 @@ int main(int argc, char** argv)
     test13();
     test14();
     test15();
+    test17();
+    test18();
+    test19();
+    test20();
+    test21();
+    test22();
+    test23();
+    test24();
+    test25();
+    test26();
+    test27();
+    test28();
 
     /** Uncomment to run Adaptive State Counting tests **/
     // runAdaptiveStateCountingTests();
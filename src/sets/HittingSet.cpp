@@ -3,23 +3,375 @@
  * 
  * Licensed under the EUPL V.1.1
  */
+#include <algorithm>
+#include <chrono>
+
 #include "sets/HittingSet.h"
+#include "sets/ParallelFor.h"
+
+using namespace std;
+
+/** Number of elements of a bitset */
+static size_t count(const vector<uint64_t>& bits)
+{
+    size_t n = 0;
+    for (uint64_t w : bits)
+    {
+        for (; w != 0; w &= w - 1)
+        {
+            ++n;
+        }
+    }
+    return n;
+}
+
+/** Return true if and only if a and b have a common element */
+static bool intersects(const vector<uint64_t>& a, const vector<uint64_t>& b)
+{
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if ((a[i] & b[i]) != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool test(const vector<uint64_t>& bits, const size_t i)
+{
+    return (bits[i >> 6] >> (i & 63)) & 1;
+}
 
-HittingSet::HittingSet(const std::vector<std::unordered_set<int>>& s)
-	: s(s)
+struct HittingSet::Search
+{
+    /** Size of the smallest hitting set found by any worker */
+    atomic<size_t> bound;
+
+    /** Number of search tree nodes visited */
+    atomic<size_t> nodes;
+    size_t maxNodes;
+
+    bool hasDeadline;
+    chrono::steady_clock::time_point deadline;
+
+    /** Set as soon as the budget has been exhausted */
+    atomic<bool> aborted;
+
+    Search(const size_t bound, const size_t maxNodes, const long maxMillis)
+        : bound(bound), nodes(0), maxNodes(maxNodes), hasDeadline(maxMillis > 0),
+          deadline(chrono::steady_clock::now() + chrono::milliseconds(maxMillis)), aborted(false)
+    {
+    }
+
+    /** Count a visited node and return false if the budget is exhausted */
+    bool visit()
+    {
+        size_t n = ++nodes;
+        if ((maxNodes > 0 && n > maxNodes)
+            || (hasDeadline && (n & 1023) == 0 && chrono::steady_clock::now() > deadline))
+        {
+            aborted = true;
+        }
+        return !aborted;
+    }
+};
+
+HittingSet::HittingSet(const vector<unordered_set<int>>& s)
+	: s(s), containsEmptySet(false)
 {
     // The initial hitting set candidate h is the union of
     // all sets in s
-	for (std::unordered_set<int> z : s)
+	for (unordered_set<int> z : s)
 	{
 		h.insert(z.begin(), z.end());
+        if (z.empty())
+        {
+            containsEmptySet = true;
+        }
 	}
-	HsTreeNode::hSmallest = h;
+
+    elements.assign(h.begin(), h.end());
+    sort(elements.begin(), elements.end());
+    words = (elements.size() + 63) / 64;
+
+    vector<vector<uint64_t>> encoded;
+    for (const unordered_set<int>& z : s)
+    {
+        vector<uint64_t> bits(words, 0);
+        for (int e : z)
+        {
+            size_t i = lower_bound(elements.begin(), elements.end(), e) - elements.begin();
+            bits[i >> 6] |= uint64_t(1) << (i & 63);
+        }
+        encoded.push_back(bits);
+    }
+
+    // Smaller sets first: every set is hit if the smaller sets
+    // contained in it are hit, so only these are kept
+    stable_sort(encoded.begin(), encoded.end(),
+                [](const vector<uint64_t>& a, const vector<uint64_t>& b)
+    {
+        return count(a) < count(b);
+    });
+    for (const vector<uint64_t>& bits : encoded)
+    {
+        bool dominated = false;
+        for (const vector<uint64_t>& kept : sets)
+        {
+            dominated = true;
+            for (size_t i = 0; i < words; ++i)
+            {
+                if ((kept[i] & ~bits[i]) != 0)
+                {
+                    dominated = false;
+                    break;
+                }
+            }
+            if (dominated)
+            {
+                break;
+            }
+        }
+        if (!dominated)
+        {
+            sets.push_back(bits);
+        }
+    }
 }
 
-std::unordered_set<int> HittingSet::calcMinCardHittingSet() const
+unordered_set<int> HittingSet::toSet(const vector<uint64_t>& bits) const
 {
-	HsTreeNode root = HsTreeNode(h, s);
-	root.expandNode();
-	return HsTreeNode::hSmallest;
+    unordered_set<int> result;
+    for (size_t i = 0; i < elements.size(); ++i)
+    {
+        if (test(bits, i))
+        {
+            result.insert(elements[i]);
+        }
+    }
+    return result;
+}
+
+vector<uint64_t> HittingSet::calcGreedyHittingSet() const
+{
+    vector<uint64_t> chosen(words, 0);
+    vector<char> isHit(sets.size(), 0);
+    size_t numHit = 0;
+    while (numHit < sets.size())
+    {
+        size_t bestElement = 0;
+        size_t bestCount = 0;
+        for (size_t i = 0; i < elements.size(); ++i)
+        {
+            size_t n = 0;
+            for (size_t k = 0; k < sets.size(); ++k)
+            {
+                if (!isHit[k] && test(sets[k], i))
+                {
+                    ++n;
+                }
+            }
+            if (n > bestCount)
+            {
+                bestCount = n;
+                bestElement = i;
+            }
+        }
+        chosen[bestElement >> 6] |= uint64_t(1) << (bestElement & 63);
+        for (size_t k = 0; k < sets.size(); ++k)
+        {
+            if (!isHit[k] && test(sets[k], bestElement))
+            {
+                isHit[k] = 1;
+                ++numHit;
+            }
+        }
+    }
+
+    // Remove the elements which are no longer needed
+    for (size_t i = 0; i < elements.size(); ++i)
+    {
+        if (!test(chosen, i))
+        {
+            continue;
+        }
+        chosen[i >> 6] &= ~(uint64_t(1) << (i & 63));
+        bool stillHitting = true;
+        for (const vector<uint64_t>& z : sets)
+        {
+            if (!intersects(z, chosen))
+            {
+                stillHitting = false;
+                break;
+            }
+        }
+        if (!stillHitting)
+        {
+            chosen[i >> 6] |= uint64_t(1) << (i & 63);
+        }
+    }
+    return chosen;
+}
+
+void HittingSet::branch(Search& search,
+                        vector<uint64_t>& chosen,
+                        size_t numChosen,
+                        vector<uint64_t>& forbidden,
+                        vector<uint64_t>& best,
+                        size_t& bestSize) const
+{
+    if (!search.visit())
+    {
+        return;
+    }
+
+    // The sets which are not hit yet, restricted to the elements which
+    // may still be chosen. Pairwise disjoint ones need distinct elements.
+    size_t branchSet = sets.size();
+    size_t branchSize = 0;
+    size_t numDisjoint = 0;
+    vector<uint64_t> allowed(words);
+    vector<uint64_t> packed(words, 0);
+    for (size_t k = 0; k < sets.size(); ++k)
+    {
+        if (intersects(sets[k], chosen))
+        {
+            continue;
+        }
+        for (size_t i = 0; i < words; ++i)
+        {
+            allowed[i] = sets[k][i] & ~forbidden[i];
+        }
+        size_t n = count(allowed);
+        if (n == 0)
+        {
+            // This set can no longer be hit
+            return;
+        }
+        if (branchSet == sets.size() || n < branchSize)
+        {
+            branchSet = k;
+            branchSize = n;
+        }
+        if (!intersects(allowed, packed))
+        {
+            ++numDisjoint;
+            for (size_t i = 0; i < words; ++i)
+            {
+                packed[i] |= allowed[i];
+            }
+        }
+    }
+
+    if (branchSet == sets.size())
+    {
+        // chosen is a hitting set
+        if (numChosen < bestSize)
+        {
+            best = chosen;
+            bestSize = numChosen;
+            size_t bound = search.bound.load();
+            while (numChosen < bound && !search.bound.compare_exchange_weak(bound, numChosen)) { }
+        }
+        return;
+    }
+
+    // Hitting sets of the same size as the best one of another worker
+    // are still explored, so that the result does not depend on the
+    // number of workers
+    if (numChosen + numDisjoint >= bestSize || numChosen + numDisjoint > search.bound.load())
+    {
+        return;
+    }
+
+    vector<size_t> excluded;
+    for (size_t i = 0; i < elements.size() && !search.aborted; ++i)
+    {
+        if (!test(sets[branchSet], i) || test(forbidden, i))
+        {
+            continue;
+        }
+        chosen[i >> 6] |= uint64_t(1) << (i & 63);
+        branch(search, chosen, numChosen + 1, forbidden, best, bestSize);
+        chosen[i >> 6] &= ~(uint64_t(1) << (i & 63));
+
+        // The hitting sets containing i have been explored
+        forbidden[i >> 6] |= uint64_t(1) << (i & 63);
+        excluded.push_back(i);
+    }
+    for (size_t i : excluded)
+    {
+        forbidden[i >> 6] &= ~(uint64_t(1) << (i & 63));
+    }
+}
+
+unordered_set<int> HittingSet::calcMinCardHittingSet() const
+{
+    bool optimal;
+    return calcMinCardHittingSet(1, 0, 0, optimal);
+}
+
+unordered_set<int> HittingSet::calcMinCardHittingSet(const unsigned int numThreads,
+                                                     const size_t maxNodes,
+                                                     const long maxMillis,
+                                                     bool& optimal) const
+{
+    optimal = true;
+    if (containsEmptySet)
+    {
+        // There is no hitting set at all
+        return h;
+    }
+    if (sets.empty())
+    {
+        return unordered_set<int>();
+    }
+
+    const vector<uint64_t> greedy = calcGreedyHittingSet();
+    const size_t greedySize = count(greedy);
+    Search search(greedySize, maxNodes, maxMillis);
+
+    // The branches of the first level choose one of the elements of
+    // the smallest set, excluding the elements of the previous branches
+    vector<size_t> firstLevel;
+    for (size_t i = 0; i < elements.size(); ++i)
+    {
+        if (test(sets.front(), i))
+        {
+            firstLevel.push_back(i);
+        }
+    }
+    vector<vector<uint64_t>> bests(firstLevel.size(), greedy);
+    vector<size_t> bestSizes(firstLevel.size(), greedySize);
+
+    parallelFor(firstLevel.size(), numThreads, [&](size_t b, unsigned int)
+    {
+        if (search.aborted)
+        {
+            return;
+        }
+        vector<uint64_t> chosen(words, 0);
+        vector<uint64_t> forbidden(words, 0);
+        chosen[firstLevel[b] >> 6] |= uint64_t(1) << (firstLevel[b] & 63);
+        for (size_t k = 0; k < b; ++k)
+        {
+            forbidden[firstLevel[k] >> 6] |= uint64_t(1) << (firstLevel[k] & 63);
+        }
+        branch(search, chosen, 1, forbidden, bests[b], bestSizes[b]);
+    });
+
+    // The smallest hitting set of the first branch providing one
+    const vector<uint64_t>* result = &greedy;
+    size_t resultSize = greedySize;
+    for (size_t b = 0; b < firstLevel.size(); ++b)
+    {
+        if (bestSizes[b] < resultSize)
+        {
+            result = &bests[b];
+            resultSize = bestSizes[b];
+        }
+    }
+    optimal = !search.aborted;
+    return toSet(*result);
 }
@@ -6,12 +6,12 @@
 #ifndef FSM_SETS_HITTINGSET_H_
 #define FSM_SETS_HITTINGSET_H_
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <unordered_set>
 #include <vector>
 
-#include "sets/HsTreeNode.h"
-
 class HittingSet
 {
 private:
@@ -23,6 +23,50 @@ private:
 
 	/** the current candidate for the minimal hitting set problem */
 	std::unordered_set<int> h;
+
+    /** The elements of h in ascending order; element i is bit i of a bitset */
+    std::vector<int> elements;
+
+    /** Number of 64-bit words of a bitset over the elements */
+    size_t words;
+
+    /**
+     * The sets of s encoded as bitsets, without duplicates and without
+     * the sets that contain another set of s
+     */
+    std::vector<std::vector<uint64_t>> sets;
+
+    /** True if and only if s contains the empty set */
+    bool containsEmptySet;
+
+    /** Shared state of a branch-and-bound search */
+    struct Search;
+
+    /**
+     * Calculate a hitting set by repeatedly choosing the element hitting
+     * the most sets which are not hit yet, and remove the elements which
+     * have become redundant afterwards.
+     */
+    std::vector<uint64_t> calcGreedyHittingSet() const;
+
+    /**
+     * Depth-first branch-and-bound search below a node of the search
+     * tree. The sets which are not hit by chosen are hit by choosing one
+     * of the elements of the smallest of these sets, excluding the
+     * forbidden elements. A node is pruned if the number of pairwise
+     * disjoint sets not hit yet shows that it cannot lead to a smaller
+     * hitting set than best. Improved hitting sets are stored in best.
+     */
+    void branch(Search& search,
+                std::vector<uint64_t>& chosen,
+                size_t numChosen,
+                std::vector<uint64_t>& forbidden,
+                std::vector<uint64_t>& best,
+                size_t& bestSize) const;
+
+    /** Convert a bitset over the elements into a set of elements */
+    std::unordered_set<int> toSet(const std::vector<uint64_t>& bits) const;
+
 public:
    /**
 	* Create an object for solving the minimal hitting set problem.
@@ -38,8 +82,30 @@ public:
 	 * @return The smallest set into the hitting set
      *
      * @note this algorithm has worst case complexity
-     * of O(2^(#(union s)))
+     * of O(2^(#(union s))), but branches which cannot improve
+     * on the best hitting set found so far are pruned
 	 */
 	std::unordered_set<int> calcMinCardHittingSet() const;
+
+    /**
+     * Calculate the smallest hitting set for the set system by a
+     * branch-and-bound search, starting from a greedy solution.
+     * The calculation only reads this object, so several hitting
+     * sets may be calculated concurrently.
+     * @param numThreads Number of worker threads exploring the branches
+     *        of the first level (0: one per hardware thread)
+     * @param maxNodes Maximal number of search tree nodes, 0 for no limit
+     * @param maxMillis Maximal search time in milliseconds, 0 for no limit
+     * @param optimal On return, true if the search has been completed, so
+     *        that the result is a smallest hitting set. If the budget has
+     *        been exhausted, the best hitting set found so far is returned,
+     *        which is at most as large as the greedy solution.
+     * @return A hitting set, the union of all sets if the set system
+     *         contains the empty set
+     */
+    std::unordered_set<int> calcMinCardHittingSet(const unsigned int numThreads,
+                                                  const size_t maxNodes,
+                                                  const long maxMillis,
+                                                  bool& optimal) const;
 };
 #endif //FSM_SETS_HITTINGSET_H_
@@ -0,0 +1,76 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#ifndef FSM_SETS_PARALLELFOR_H_
+#define FSM_SETS_PARALLELFOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * Number of worker threads to use for a requested number
+ * @param numThreads Requested number of threads, 0 for one
+ *        per hardware thread
+ * @return numThreads, or the number of hardware threads if 0,
+ *         but at least 1
+ */
+inline unsigned int numWorkerThreads(const unsigned int numThreads)
+{
+    unsigned int nThreads = (numThreads > 0) ? numThreads : std::thread::hardware_concurrency();
+    return (nThreads < 1) ? 1 : nThreads;
+}
+
+/**
+ * Call f(i, w) for i = 0..n-1, distributed over worker threads.
+ * Every worker takes the next index which has not been started yet,
+ * so the indices are started in ascending order. The calling thread
+ * is worker 0, and no more workers than indices are started.
+ * @param n Number of indices
+ * @param numThreads Maximal number of workers, 0 for one per hardware thread
+ * @param f Called with the index and the number w < numWorkerThreads(numThreads)
+ *        of the worker, e.g. for selecting scratch space of the worker
+ */
+template <typename F>
+void parallelFor(const size_t n, const unsigned int numThreads, F f)
+{
+    const unsigned int nThreads = numWorkerThreads(numThreads);
+    std::atomic<size_t> next(0);
+    auto worker = [&](const unsigned int w)
+    {
+        for (size_t i = next++; i < n; i = next++)
+        {
+            f(i, w);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned int w = 1; w < nThreads && w < n; ++w)
+    {
+        pool.emplace_back(worker, w);
+    }
+    worker(0);
+    for (auto& t : pool)
+    {
+        t.join();
+    }
+}
+
+/**
+ * Call f(begin, end, w) for consecutive chunks begin..end-1 of 0..n-1,
+ * distributed over worker threads like the indices of parallelFor()
+ * @param chunk Number of indices per chunk, the last chunk may be smaller
+ */
+template <typename F>
+void parallelForChunks(const size_t n, const size_t chunk, const unsigned int numThreads, F f)
+{
+    parallelFor((n + chunk - 1) / chunk, numThreads, [&](const size_t c, const unsigned int w)
+    {
+        f(c * chunk, std::min(n, (c + 1) * chunk), w);
+    });
+}
+
+#endif //FSM_SETS_PARALLELFOR_H_
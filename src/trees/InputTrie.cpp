@@ -0,0 +1,383 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#include <algorithm>
+
+#include "trees/InputTrie.h"
+#include "sets/ParallelFor.h"
+#include "trees/Tree.h"
+#include "trees/TreeNode.h"
+
+using namespace std;
+
+const uint32_t InputTrie::NIL;
+
+InputTrie::InputTrie(const int maxInput,
+                     const shared_ptr<FsmPresentationLayer>& presentationLayer)
+: width(maxInput >= 0 ? static_cast<size_t>(maxInput) + 1 : 0),
+numDetached(0),
+presentationLayer(presentationLayer)
+{
+    newNode(NIL, -1);
+}
+
+uint32_t InputTrie::newNode(const uint32_t parent, const int x)
+{
+    uint32_t n = static_cast<uint32_t>(nodes.size());
+    Node node;
+    node.parent = parent;
+    node.firstChild = NIL;
+    node.lastChild = NIL;
+    node.nextSibling = NIL;
+    node.io = x;
+    node.deleted = false;
+    node.detached = false;
+    nodes.push_back(node);
+    childTable.resize(childTable.size() + width, NIL);
+
+    if ( parent != NIL ) {
+        Node& p = nodes[parent];
+        if ( p.lastChild == NIL ) {
+            p.firstChild = n;
+        }
+        else {
+            nodes[p.lastChild].nextSibling = n;
+        }
+        p.lastChild = n;
+        if ( x >= 0 && static_cast<size_t>(x) < width ) {
+            childTable[parent * width + x] = n;
+        }
+    }
+    return n;
+}
+
+uint32_t InputTrie::after(const uint32_t n, const int x) const
+{
+    if ( x >= 0 && static_cast<size_t>(x) < width ) {
+        return childTable[n * width + x];
+    }
+    for ( uint32_t c = nodes[n].firstChild; c != NIL; c = nodes[c].nextSibling ) {
+        if ( nodes[c].io == x ) return c;
+    }
+    return NIL;
+}
+
+uint32_t InputTrie::after(uint32_t n,
+                          vector<int>::const_iterator start,
+                          const vector<int>::const_iterator stop) const
+{
+    for ( ; start != stop && n != NIL; ++start ) {
+        n = after(n, *start);
+    }
+    return n;
+}
+
+uint32_t InputTrie::add(const uint32_t n, const int x)
+{
+    uint32_t c = after(n, x);
+    return (c != NIL) ? c : newNode(n, x);
+}
+
+void InputTrie::addToNode(uint32_t n, const vector<int>& lst)
+{
+    for ( int x : lst ) {
+        n = add(n, x);
+    }
+}
+
+void InputTrie::addToNode(const uint32_t n, const IOListContainer& tcl)
+{
+    for ( const auto& lst : *tcl.getIOLists() ) {
+        addToNode(n, lst);
+    }
+}
+
+void InputTrie::add(const IOListContainer& tcl)
+{
+    /* Tree::add() processes the nodes in post-order: the children first,
+     and then the node itself. Since every node has a larger index than its
+     parent, visiting the existing nodes by decreasing index yields the same
+     result, and nodes created on the way are never visited. */
+    for ( size_t n = nodes.size(); n-- > 0; ) {
+        if ( nodes[n].detached ) continue;
+        addToNode(static_cast<uint32_t>(n), tcl);
+    }
+}
+
+void InputTrie::add(const IOListContainer& tcl, const unsigned int numThreads)
+{
+    const unsigned int nThreads = numWorkerThreads(numThreads);
+    
+    /* Determine the levels of the trie, until a level offers
+     enough independent sub-tries to keep all workers busy */
+    const size_t minCut = 4 * static_cast<size_t>(nThreads);
+    vector<uint32_t> upper;
+    vector<uint32_t> cut;
+    cut.push_back(getRoot());
+    while ( nThreads > 1 && !cut.empty() && cut.size() < minCut ) {
+        vector<uint32_t> next;
+        for ( uint32_t n : cut ) {
+            for ( uint32_t c = nodes[n].firstChild; c != NIL; c = nodes[c].nextSibling ) {
+                next.push_back(c);
+            }
+        }
+        upper.insert(upper.end(), cut.begin(), cut.end());
+        cut.swap(next);
+    }
+    
+    if ( cut.size() < 2 ) {
+        add(tcl);
+        return;
+    }
+    
+    /* Every worker extends copies of the sub-tries below the cut nodes.
+     The nodes of a sub-trie only depend on additions made at the
+     sub-trie's own nodes, so the copies can be processed independently. */
+    vector<unique_ptr<InputTrie>> parts(cut.size());
+    parallelFor(cut.size(), nThreads, [&](size_t i, unsigned int) {
+        parts[i].reset(new InputTrie(static_cast<int>(width) - 1, presentationLayer));
+        copySubTree(cut[i], *parts[i], parts[i]->getRoot());
+        parts[i]->add(tcl);
+    });
+    
+    /* Re-assemble the trie: the nodes above the cut are copied, and the
+     extended sub-tries are grafted in the original order of the children */
+    InputTrie merged(static_cast<int>(width) - 1, presentationLayer);
+    vector<uint32_t> upperMerged;
+    vector<pair<uint32_t,uint32_t>> queue;
+    queue.emplace_back(getRoot(), merged.getRoot());
+    size_t cutIdx = 0;
+    for ( size_t head = 0; head < queue.size(); ++head ) {
+        uint32_t src = queue[head].first;
+        uint32_t tgt = queue[head].second;
+        upperMerged.push_back(tgt);
+        for ( uint32_t c = nodes[src].firstChild; c != NIL; c = nodes[c].nextSibling ) {
+            uint32_t cpy = merged.newNode(tgt, nodes[c].io);
+            merged.nodes[cpy].deleted = nodes[c].deleted;
+            if ( cutIdx < cut.size() && cut[cutIdx] == c ) {
+                parts[cutIdx]->copySubTree(parts[cutIdx]->getRoot(), merged, cpy);
+                parts[cutIdx].reset();
+                ++cutIdx;
+            }
+            else {
+                queue.emplace_back(c, cpy);
+            }
+        }
+    }
+    merged.nodes[merged.getRoot()].deleted = nodes[getRoot()].deleted;
+    *this = move(merged);
+    
+    /* Finally extend the nodes above the cut, children before parents */
+    for ( auto it = upperMerged.rbegin(); it != upperMerged.rend(); ++it ) {
+        addToNode(*it, tcl);
+    }
+}
+
+void InputTrie::addToRoot(const IOListContainer& tcl)
+{
+    addToNode(getRoot(), tcl);
+}
+
+void InputTrie::addToRoot(const vector<int>& lst)
+{
+    addToNode(getRoot(), lst);
+}
+
+void InputTrie::addAfter(const vector<int>& tr, const IOListContainer& cnt)
+{
+    uint32_t n = after(getRoot(), tr.cbegin(), tr.cend());
+    if ( n == NIL ) return;
+    addToNode(n, cnt);
+}
+
+void InputTrie::unionTree(const InputTrie& other)
+{
+    for ( uint32_t leaf : other.getLeaves() ) {
+        addToRoot(other.getPath(leaf));
+    }
+}
+
+void InputTrie::detach(const uint32_t n)
+{
+    Node& node = nodes[n];
+    Node& p = nodes[node.parent];
+
+    uint32_t prev = NIL;
+    for ( uint32_t c = p.firstChild; c != n; c = nodes[c].nextSibling ) {
+        prev = c;
+    }
+    if ( prev == NIL ) {
+        p.firstChild = node.nextSibling;
+    }
+    else {
+        nodes[prev].nextSibling = node.nextSibling;
+    }
+    if ( p.lastChild == n ) {
+        p.lastChild = prev;
+    }
+    if ( node.io >= 0 && static_cast<size_t>(node.io) < width ) {
+        childTable[node.parent * width + node.io] = NIL;
+    }
+
+    node.nextSibling = NIL;
+    node.detached = true;
+    ++numDetached;
+}
+
+void InputTrie::deleteNode(uint32_t n)
+{
+    nodes[n].deleted = true;
+
+    while ( isLeaf(n) && nodes[n].parent != NIL ) {
+        uint32_t p = nodes[n].parent;
+        detach(n);
+        if ( !isLeaf(p) || !nodes[p].deleted ) break;
+        n = p;
+    }
+}
+
+void InputTrie::remove(const InputTrie& other)
+{
+    vector<pair<uint32_t,uint32_t>> stack;
+    vector<uint32_t> children;
+    stack.emplace_back(getRoot(), other.getRoot());
+
+    while ( !stack.empty() ) {
+        uint32_t n = stack.back().first;
+        uint32_t o = stack.back().second;
+        stack.pop_back();
+
+        deleteNode(n);
+
+        /* Deleting a child may detach it, so the children are
+         collected before descending */
+        children.clear();
+        for ( uint32_t c = nodes[n].firstChild; c != NIL; c = nodes[c].nextSibling ) {
+            children.push_back(c);
+        }
+        for ( auto it = children.rbegin(); it != children.rend(); ++it ) {
+            uint32_t oc = other.after(o, nodes[*it].io);
+            if ( oc != NIL ) {
+                stack.emplace_back(*it, oc);
+            }
+        }
+    }
+}
+
+vector<uint32_t> InputTrie::getLeaves() const
+{
+    vector<uint32_t> leaves;
+    vector<uint32_t> stack;
+    stack.push_back(getRoot());
+
+    while ( !stack.empty() ) {
+        uint32_t n = stack.back();
+        stack.pop_back();
+
+        if ( isLeaf(n) ) {
+            leaves.push_back(n);
+            continue;
+        }
+
+        /* Push the children in reverse order, so that they are
+         popped in insertion order */
+        size_t mark = stack.size();
+        for ( uint32_t c = nodes[n].firstChild; c != NIL; c = nodes[c].nextSibling ) {
+            stack.push_back(c);
+        }
+        reverse(stack.begin() + mark, stack.end());
+    }
+    return leaves;
+}
+
+vector<int> InputTrie::getPath(uint32_t n) const
+{
+    vector<int> path;
+    for ( ; nodes[n].parent != NIL; n = nodes[n].parent ) {
+        path.push_back(nodes[n].io);
+    }
+    reverse(path.begin(), path.end());
+    return path;
+}
+
+IOListContainer InputTrie::getIOLists() const
+{
+    shared_ptr<vector<vector<int>>> ioll = make_shared<vector<vector<int>>>();
+
+    /* Depth-first traversal maintaining the current path, so that no
+     parent chains have to be followed for the individual leaves */
+    vector<int> path;
+    vector<pair<uint32_t,size_t>> stack;
+    stack.emplace_back(getRoot(), 0);
+
+    while ( !stack.empty() ) {
+        uint32_t n = stack.back().first;
+        size_t depth = stack.back().second;
+        stack.pop_back();
+
+        if ( n != getRoot() ) {
+            path.resize(depth - 1);
+            path.push_back(nodes[n].io);
+        }
+
+        if ( isLeaf(n) ) {
+            ioll->push_back(path);
+            continue;
+        }
+
+        size_t mark = stack.size();
+        for ( uint32_t c = nodes[n].firstChild; c != NIL; c = nodes[c].nextSibling ) {
+            stack.emplace_back(c, depth + 1);
+        }
+        reverse(stack.begin() + mark, stack.end());
+    }
+
+    return IOListContainer(ioll, presentationLayer);
+}
+
+void InputTrie::copySubTree(const uint32_t n, InputTrie& dst, const uint32_t dstNode) const
+{
+    /* Breadth-first copy, preserving the order of the children */
+    vector<pair<uint32_t,uint32_t>> queue;
+    queue.emplace_back(n, dstNode);
+    for ( size_t head = 0; head < queue.size(); ++head ) {
+        uint32_t src = queue[head].first;
+        uint32_t tgt = queue[head].second;
+        for ( uint32_t c = nodes[src].firstChild; c != NIL; c = nodes[c].nextSibling ) {
+            uint32_t cpy = dst.newNode(tgt, nodes[c].io);
+            dst.nodes[cpy].deleted = nodes[c].deleted;
+            queue.emplace_back(c, cpy);
+        }
+    }
+}
+
+InputTrie InputTrie::getSubTree(const vector<int>& alpha) const
+{
+    InputTrie sub(static_cast<int>(width) - 1, presentationLayer);
+    uint32_t n = after(getRoot(), alpha.cbegin(), alpha.cend());
+    if ( n != NIL ) {
+        copySubTree(n, sub, sub.getRoot());
+    }
+    return sub;
+}
+
+shared_ptr<Tree> InputTrie::toTree() const
+{
+    vector<shared_ptr<TreeNode>> t(nodes.size());
+    t[getRoot()] = make_shared<TreeNode>();
+
+    /* Parents have smaller indices than their children, but the order of
+     the children has to follow the sibling lists */
+    vector<uint32_t> queue;
+    queue.push_back(getRoot());
+    for ( size_t head = 0; head < queue.size(); ++head ) {
+        uint32_t n = queue[head];
+        for ( uint32_t c = nodes[n].firstChild; c != NIL; c = nodes[c].nextSibling ) {
+            t[c] = t[n]->add(nodes[c].io);
+            queue.push_back(c);
+        }
+    }
+    return make_shared<Tree>(t[getRoot()], presentationLayer);
+}
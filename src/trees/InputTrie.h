@@ -0,0 +1,218 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#ifndef FSM_TREES_INPUTTRIE_H_
+#define FSM_TREES_INPUTTRIE_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "trees/IOListContainer.h"
+#include "interface/FsmPresentationLayer.h"
+
+class Tree;
+
+/**
+ * Arena-allocated input tree with the semantics of class Tree.
+ *
+ * All nodes live in one contiguous vector and are addressed by 32-bit
+ * indices; the root always has index 0, and a child is always created
+ * after its parent, so its index is larger than the parent's index.
+ * Children are kept in insertion order in an intrusive sibling list,
+ * so that leaves and I/O lists are enumerated in exactly the order
+ * produced by Tree. In addition, every node owns a row of a dense child
+ * table indexed by input 0..maxInput, so that following an edge is a
+ * single array access. Labels outside this range are still accepted
+ * and resolved by scanning the sibling list.
+ *
+ * Nodes are never freed individually: a node removed from its parent
+ * is only detached, and the memory is released when the whole trie is
+ * destroyed.
+ */
+class InputTrie
+{
+public:
+
+    /** Index value denoting "no node" */
+    static const uint32_t NIL = UINT32_MAX;
+
+    /**
+     * Create a trie consisting of the root node only
+     * @param maxInput Maximal input label, determines the width of
+     *                 the dense child table
+     * @param presentationLayer The presentation layer used for the
+     *                 I/O lists created from this trie
+     */
+    InputTrie(const int maxInput,
+              const std::shared_ptr<FsmPresentationLayer>& presentationLayer);
+
+    /** Index of the root node */
+    uint32_t getRoot() const { return 0; }
+
+    /** Number of nodes reachable from the root */
+    size_t size() const { return nodes.size() - numDetached; }
+
+    /** Input labelling the edge from the parent to node n */
+    int getIO(const uint32_t n) const { return nodes[n].io; }
+
+    /** Parent of node n, NIL for the root */
+    uint32_t getParent(const uint32_t n) const { return nodes[n].parent; }
+
+    /** First child of node n in insertion order, NIL if n is a leaf */
+    uint32_t getFirstChild(const uint32_t n) const { return nodes[n].firstChild; }
+
+    /** Next sibling of node n in insertion order, NIL if there is none */
+    uint32_t getNextSibling(const uint32_t n) const { return nodes[n].nextSibling; }
+
+    bool isLeaf(const uint32_t n) const { return nodes[n].firstChild == NIL; }
+
+    bool isDeleted(const uint32_t n) const { return nodes[n].deleted; }
+
+    /**
+     * Return the child of node n reached under input x
+     * @return the child, or NIL if no edge labelled with x exists
+     */
+    uint32_t after(const uint32_t n, const int x) const;
+
+    /**
+     * Return the node reached from node n by following the inputs
+     * in [start, stop).
+     * @return the node reached, or NIL if the trace leaves the trie
+     */
+    uint32_t after(uint32_t n,
+                   std::vector<int>::const_iterator start,
+                   const std::vector<int>::const_iterator stop) const;
+
+    /**
+     * Conditional addition of an edge labelled by x to node n
+     * @return the existing target of the x-edge, or the new leaf if
+     *         the edge had to be created
+     */
+    uint32_t add(const uint32_t n, const int x);
+
+    /** Append input trace lst to node n, re-using existing edges */
+    void addToNode(uint32_t n, const std::vector<int>& lst);
+
+    /** Append every input trace of tcl to node n */
+    void addToNode(const uint32_t n, const IOListContainer& tcl);
+
+    /**
+     * Append a list of input traces to EVERY node of the trie,
+     * as Tree::add() does.
+     */
+    void add(const IOListContainer& tcl);
+
+    /**
+     * Append a list of input traces to EVERY node of the trie, using
+     * numThreads worker threads (0: one per hardware thread).
+     *
+     * The trie is cut at the first depth offering enough sub-tries for
+     * the workers. Each worker extends copies of its sub-tries, the
+     * extended copies are grafted back in their original order, and the
+     * nodes above the cut are finally extended on the calling thread.
+     * The resulting trie is identical to the one created by add(tcl).
+     */
+    void add(const IOListContainer& tcl, const unsigned int numThreads);
+
+    /** Insert a list of input traces at the root of the trie */
+    void addToRoot(const IOListContainer& tcl);
+
+    /** Insert a single input trace at the root of the trie */
+    void addToRoot(const std::vector<int>& lst);
+
+    /**
+     * Append a list of input traces to the node reached by tr.
+     * Nothing is changed if tr leaves the trie.
+     */
+    void addAfter(const std::vector<int>& tr, const IOListContainer& cnt);
+
+    /**
+     * Construct the union of this trie and other by adding
+     * every maximal input trace of other to this trie.
+     */
+    void unionTree(const InputTrie& other);
+
+    /**
+     * Special remove operation, as Tree::remove(): for all edges in
+     * other that correspond to an edge in this trie, the corresponding
+     * source and target nodes in this trie are marked as deleted.
+     * Deleted leaves are detached from their parents.
+     */
+    void remove(const InputTrie& other);
+
+    /**
+     * Return the leaves of the trie in depth-first order, children
+     * visited in insertion order.
+     */
+    std::vector<uint32_t> getLeaves() const;
+
+    /** Return the inputs needed to reach node n from the root */
+    std::vector<int> getPath(uint32_t n) const;
+
+    /**
+     * Get all maximal I/O lists of the trie, in the order of
+     * getLeaves().
+     */
+    IOListContainer getIOLists() const;
+
+    /**
+     * Return a copy of the sub-trie rooted in the node reached by alpha.
+     * If alpha leaves the trie, the copy consists of the root only.
+     */
+    InputTrie getSubTree(const std::vector<int>& alpha) const;
+
+    /**
+     * Convert this trie into a pointer-based Tree with identical
+     * structure and child order.
+     */
+    std::shared_ptr<Tree> toTree() const;
+
+private:
+
+    struct Node {
+        uint32_t parent;
+        uint32_t firstChild;
+        uint32_t lastChild;
+        uint32_t nextSibling;
+        int io;
+        bool deleted;
+        bool detached;
+    };
+
+    /** Width of the dense child table: maxInput + 1 */
+    size_t width;
+
+    /** Node arena, the root is nodes[0] */
+    std::vector<Node> nodes;
+
+    /** Dense child table, row n holds the children of node n */
+    std::vector<uint32_t> childTable;
+
+    /** Number of nodes which have been detached from the trie */
+    size_t numDetached;
+
+    std::shared_ptr<FsmPresentationLayer> presentationLayer;
+
+    uint32_t newNode(const uint32_t parent, const int x);
+
+    /**
+     * Append copies of all descendants of node n below node dstNode of
+     * trie dst, preserving the order of the children.
+     */
+    void copySubTree(const uint32_t n, InputTrie& dst, const uint32_t dstNode) const;
+
+    /**
+     * Mark node n as deleted; if it is a leaf, detach it and continue
+     * with all parents becoming deleted leaves (TreeNode::deleteNode()).
+     */
+    void deleteNode(uint32_t n);
+
+    /** Unlink leaf n from the child list of its parent */
+    void detach(const uint32_t n);
+
+};
+
+#endif // FSM_TREES_INPUTTRIE_H_
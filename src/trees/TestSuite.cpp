@@ -4,6 +4,7 @@
  * Licensed under the EUPL V.1.1
  */
 #include "trees/TestSuite.h"
+#include "trees/TestSuiteTrie.h"
 
 
 using namespace std;
@@ -78,7 +79,16 @@ ostream & operator<<(ostream & out, const TestSuite & testSuite)
 	return out;
 }
 
-void TestSuite::save(const std::string &name) {
+void TestSuite::save(const std::string &name, bool asTrie) {
+    
+    if ( asTrie ) {
+        TestSuiteTrie trie;
+        for (OutputTree& ot : *this) {
+            trie.add(ot);
+        }
+        trie.save(name);
+        return;
+    }
     
     ofstream out(name);
     
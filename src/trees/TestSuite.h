@@ -54,8 +54,9 @@ public:
     
     /**
      *   Save test suite to file, using the forma of the << operator
+     *   or, if asTrie is true, the prefix tree format of TestSuiteTrie
      */
-    void save(const std::string &name);
+    void save(const std::string &name, bool asTrie = false);
 
     /**
      * @return The sum of all test case sizes in this test suite
@@ -0,0 +1,344 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#include <cstring>
+#include <iostream>
+
+#include "trees/TestSuiteTrie.h"
+
+using namespace std;
+
+static const char trieMagic[8] = { 'F', 'S', 'M', 'T', 'R', 'I', 'E', 0 };
+
+/** Size of the output buffer in bytes, above which it is written to the file */
+static const size_t bufferSize = 1 << 20;
+
+static void writeNumber(string& buffer, uint32_t n)
+{
+    while (n >= 0x80)
+    {
+        buffer.push_back(static_cast<char>((n & 0x7F) | 0x80));
+        n >>= 7;
+    }
+    buffer.push_back(static_cast<char>(n));
+}
+
+static void writeNames(string& buffer, const vector<string>& names)
+{
+    writeNumber(buffer, static_cast<uint32_t>(names.size()));
+    for (const auto& name : names)
+    {
+        writeNumber(buffer, static_cast<uint32_t>(name.size()));
+        buffer += name;
+    }
+}
+
+TestSuiteTrie::TestSuiteTrie() : numTestCases(0)
+{
+    nodes.push_back({ -1, -1, 0, -1, -1, -1 });
+}
+
+int TestSuiteTrie::intern(const string& s,
+                          vector<string>& names,
+                          unordered_map<string, int>& index)
+{
+    auto it = index.find(s);
+    if (it != index.end())
+    {
+        return it->second;
+    }
+    int idx = static_cast<int>(names.size());
+    index.emplace(s, idx);
+    names.push_back(s);
+    return idx;
+}
+
+int TestSuiteTrie::getChild(const int parent, const int x, const int y)
+{
+    for (int c = nodes[parent].firstChild; c >= 0; c = nodes[c].nextSibling)
+    {
+        if (nodes[c].input == x and nodes[c].output == y)
+        {
+            return c;
+        }
+    }
+
+    int c = static_cast<int>(nodes.size());
+    nodes.push_back({ x, y, 0, -1, -1, -1 });
+    if (nodes[parent].lastChild < 0)
+    {
+        nodes[parent].firstChild = c;
+    }
+    else
+    {
+        nodes[nodes[parent].lastChild].nextSibling = c;
+    }
+    nodes[parent].lastChild = c;
+    return c;
+}
+
+void TestSuiteTrie::add(const vector<pair<string, string>>& testCase)
+{
+    // Empty test cases are not stored, as the readers of the
+    // text format skip empty lines
+    if (testCase.empty())
+    {
+        return;
+    }
+
+    int n = 0;
+    for (const auto& io : testCase)
+    {
+        n = getChild(n,
+                     intern(io.first, inNames, inIndex),
+                     intern(io.second, outNames, outIndex));
+    }
+    nodes[n].count++;
+    numTestCases++;
+}
+
+void TestSuiteTrie::add(const IOTrace& trace)
+{
+    // As in the text format, the names of inputs and outputs are taken
+    // from the presentation layer of the output trace
+    auto pl = trace.getOutputTrace().getPresentationLayer();
+    vector<int> inputs = trace.getInputTrace().get();
+    vector<int> outputs = trace.getOutputTrace().get();
+
+    vector<pair<string, string>> testCase;
+    for (size_t i = 0; i < outputs.size(); ++i)
+    {
+        testCase.emplace_back(pl->getInId(inputs[i]), pl->getOutId(outputs[i]));
+    }
+    add(testCase);
+}
+
+void TestSuiteTrie::add(OutputTree& ot)
+{
+    vector<IOTrace> iotrcVec;
+    ot.toIOTrace(iotrcVec);
+    for (const auto& trace : iotrcVec)
+    {
+        add(trace);
+    }
+}
+
+bool TestSuiteTrie::save(const string& fname) const
+{
+    ofstream out(fname, ios::binary);
+    if (not out)
+    {
+        cerr << "Could not open test suite file " << fname << endl;
+        return false;
+    }
+
+    string buffer(trieMagic, sizeof(trieMagic));
+    writeNumber(buffer, formatVersion);
+    writeNames(buffer, inNames);
+    writeNames(buffer, outNames);
+
+    auto numChildren = [this](const int n)
+    {
+        uint32_t k = 0;
+        for (int c = nodes[n].firstChild; c >= 0; c = nodes[c].nextSibling) ++k;
+        return k;
+    };
+
+    writeNumber(buffer, nodes[0].count);
+    writeNumber(buffer, numChildren(0));
+
+    // Preorder: a node is followed by its children, then by its next sibling
+    vector<int> pending;
+    if (nodes[0].firstChild >= 0)
+    {
+        pending.push_back(nodes[0].firstChild);
+    }
+    while (not pending.empty())
+    {
+        int n = pending.back();
+        pending.pop_back();
+
+        writeNumber(buffer, static_cast<uint32_t>(nodes[n].input));
+        writeNumber(buffer, static_cast<uint32_t>(nodes[n].output));
+        writeNumber(buffer, nodes[n].count);
+        writeNumber(buffer, numChildren(n));
+
+        if (nodes[n].nextSibling >= 0)
+        {
+            pending.push_back(nodes[n].nextSibling);
+        }
+        if (nodes[n].firstChild >= 0)
+        {
+            pending.push_back(nodes[n].firstChild);
+        }
+
+        if (buffer.size() >= bufferSize)
+        {
+            out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+            buffer.clear();
+        }
+    }
+    out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+    out.close();
+
+    if (not out)
+    {
+        cerr << "Could not write test suite file " << fname << endl;
+        return false;
+    }
+    return true;
+}
+
+bool TestSuiteTrie::isTrieFile(const string& fname)
+{
+    ifstream in(fname, ios::binary);
+    char magic[sizeof(trieMagic)];
+    return in.read(magic, sizeof(magic)) and memcmp(magic, trieMagic, sizeof(magic)) == 0;
+}
+
+TestSuiteTrieReader::TestSuiteTrieReader() : fileSize(0), pendingCount(0)
+{
+}
+
+bool TestSuiteTrieReader::fail(const string& msg)
+{
+    error = msg;
+    unreadChildren.clear();
+    path.clear();
+    pendingCount = 0;
+    return false;
+}
+
+bool TestSuiteTrieReader::readNumber(uint32_t& n)
+{
+    n = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        int c = file.get();
+        if (c == char_traits<char>::eof())
+        {
+            return fail("Unexpected end of test suite file");
+        }
+        n |= static_cast<uint32_t>(c & 0x7F) << shift;
+        if ((c & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return fail("Invalid number in test suite file");
+}
+
+bool TestSuiteTrieReader::readNames(vector<string>& names)
+{
+    uint32_t numNames;
+    if (not readNumber(numNames))
+    {
+        return false;
+    }
+    names.clear();
+    for (uint32_t i = 0; i < numNames; ++i)
+    {
+        uint32_t len;
+        if (not readNumber(len))
+        {
+            return false;
+        }
+        // Check the length first, so that a corrupt length does
+        // not allocate a huge string
+        if (len > fileSize - file.tellg())
+        {
+            return fail("Unexpected end of test suite file");
+        }
+        string name(len, 0);
+        if (not file.read(&name[0], len))
+        {
+            return fail("Unexpected end of test suite file");
+        }
+        names.push_back(name);
+    }
+    return true;
+}
+
+bool TestSuiteTrieReader::open(const string& fname)
+{
+    error.clear();
+    path.clear();
+    unreadChildren.clear();
+    pendingCount = 0;
+
+    file.close();
+    file.clear();
+    file.open(fname, ios::binary | ios::ate);
+    if (not file)
+    {
+        return fail("Could not open file " + fname);
+    }
+    fileSize = file.tellg();
+    file.seekg(0);
+
+    char magic[sizeof(trieMagic)];
+    if (not file.read(magic, sizeof(magic)) or memcmp(magic, trieMagic, sizeof(magic)) != 0)
+    {
+        return fail(fname + " is not a test suite trie file");
+    }
+
+    uint32_t version;
+    if (not readNumber(version))
+    {
+        return false;
+    }
+    if (version != TestSuiteTrie::formatVersion)
+    {
+        return fail("Unsupported test suite trie version " + to_string(version));
+    }
+
+    uint32_t numChildren;
+    if (not readNames(inNames) or not readNames(outNames) or
+        not readNumber(pendingCount) or not readNumber(numChildren))
+    {
+        return false;
+    }
+    unreadChildren.push_back(numChildren);
+    return true;
+}
+
+bool TestSuiteTrieReader::next(vector<pair<int, int>>& testCase)
+{
+    while (not unreadChildren.empty())
+    {
+        if (pendingCount > 0)
+        {
+            pendingCount--;
+            testCase = path;
+            return true;
+        }
+
+        if (unreadChildren.back() == 0)
+        {
+            // All children of the current node have been read
+            unreadChildren.pop_back();
+            if (not path.empty())
+            {
+                path.pop_back();
+            }
+            continue;
+        }
+
+        unreadChildren.back()--;
+        uint32_t x, y, numChildren;
+        if (not readNumber(x) or not readNumber(y) or
+            not readNumber(pendingCount) or not readNumber(numChildren))
+        {
+            return false;
+        }
+        if (x >= inNames.size() or y >= outNames.size())
+        {
+            return fail("Invalid input or output in test suite file");
+        }
+        path.emplace_back(static_cast<int>(x), static_cast<int>(y));
+        unreadChildren.push_back(numChildren);
+    }
+    return false;
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#ifndef FSM_TREES_TESTSUITETRIE_H_
+#define FSM_TREES_TESTSUITETRIE_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "fsm/IOTrace.h"
+#include "trees/OutputTree.h"
+
+/**
+ Test suite stored as a prefix tree over (input/output) pairs, so
+ that the prefixes shared by the test cases of a suite are stored
+ only once.
+
+ Every line of the text format written by TestSuite::save() is a
+ path from the root; a node records how many test cases end in it.
+ The binary file format written by save() consists of
+ - the magic number "FSMTRIE\0";
+ - the format version;
+ - the table of input names and the table of output names, each given
+   as the number of names followed by the length and the characters
+   of every name;
+ - the nodes in depth-first preorder, children in insertion order:
+   the root as (number of test cases ending in it, number of children),
+   every other node as (input, output, number of test cases ending
+   in it, number of children), input and output being indices into
+   the name tables.
+ All numbers following the magic number are unsigned LEB128 varints,
+ so the format does not depend on the byte order of the host.
+
+ TestSuiteTrieReader streams the test cases of such a file
+ depth-first, without building the tree.
+ */
+class TestSuiteTrie
+{
+private:
+    struct Node
+    {
+        int input;
+        int output;
+        /** Number of test cases ending in this node */
+        uint32_t count;
+        int firstChild;
+        int lastChild;
+        int nextSibling;
+    };
+
+    /** The nodes, the root at index 0 */
+    std::vector<Node> nodes;
+
+    std::vector<std::string> inNames;
+    std::vector<std::string> outNames;
+    std::unordered_map<std::string, int> inIndex;
+    std::unordered_map<std::string, int> outIndex;
+
+    /** Number of test cases */
+    size_t numTestCases;
+
+    static int intern(const std::string& s,
+                      std::vector<std::string>& names,
+                      std::unordered_map<std::string, int>& index);
+
+    /** Child of a node labelled with (x/y), created if needed */
+    int getChild(const int parent, const int x, const int y);
+
+public:
+    /** Version of the file format written by save() */
+    static const uint32_t formatVersion = 1;
+
+    /** Create an empty trie */
+    TestSuiteTrie();
+
+    /** Add a test case, given as the names of its inputs and outputs */
+    void add(const std::vector<std::pair<std::string, std::string>>& testCase);
+
+    /** Add an IO trace as a test case */
+    void add(const IOTrace& trace);
+
+    /** Add every IO trace of an output tree as a test case */
+    void add(OutputTree& ot);
+
+    /** Number of test cases added */
+    size_t size() const { return numTestCases; }
+
+    /** Number of nodes, including the root */
+    size_t getNumNodes() const { return nodes.size(); }
+
+    /**
+     * Write the trie to a file
+     * @return false if the file could not be written
+     */
+    bool save(const std::string& fname) const;
+
+    /** Check whether a file starts with the trie magic number */
+    static bool isTrieFile(const std::string& fname);
+};
+
+/**
+ Reader streaming the test cases of a test suite trie file.
+ */
+class TestSuiteTrieReader
+{
+private:
+    std::ifstream file;
+
+    /** Size of the file in bytes */
+    std::streamoff fileSize;
+
+    std::vector<std::string> inNames;
+    std::vector<std::string> outNames;
+
+    /** Inputs and outputs of the path to the current node */
+    std::vector<std::pair<int, int>> path;
+
+    /** Number of unread children of the nodes on the path, root first */
+    std::vector<uint32_t> unreadChildren;
+
+    /** Number of test cases ending in the current node not yet returned */
+    uint32_t pendingCount;
+
+    std::string error;
+
+    bool readNumber(uint32_t& n);
+    bool readNames(std::vector<std::string>& names);
+    bool fail(const std::string& msg);
+
+public:
+    TestSuiteTrieReader();
+
+    /**
+     * Open a trie file and read its name tables
+     * @return false if the file cannot be read or is not a trie file
+     */
+    bool open(const std::string& fname);
+
+    /**
+     * Read the next test case in depth-first order
+     * @param testCase Receives the test case as (input, output) pairs,
+     *        given as indices into the name tables
+     * @return false if there are no more test cases, or on error
+     */
+    bool next(std::vector<std::pair<int, int>>& testCase);
+
+    size_t getNumInNames() const { return inNames.size(); }
+    size_t getNumOutNames() const { return outNames.size(); }
+    const std::string& getInName(const int x) const { return inNames[x]; }
+    const std::string& getOutName(const int y) const { return outNames[y]; }
+
+    /** Description of the last error, empty if none occurred */
+    const std::string& getError() const { return error; }
+};
+#endif //FSM_TREES_TESTSUITETRIE_H_
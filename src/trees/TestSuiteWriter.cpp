@@ -0,0 +1,110 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "trees/TestSuiteWriter.h"
+
+using namespace std;
+
+TestSuiteWriter::TestSuiteWriter(const string& fname,
+                                 const string& rttPrefix,
+                                 const bool asTrie)
+    : fname(fname), rttPrefix(rttPrefix), numTestCases(0), totalLength(0),
+      failed(false)
+{
+    if (fname.empty())
+    {
+        return;
+    }
+    if (asTrie)
+    {
+        trie = make_shared<TestSuiteTrie>();
+    }
+    else
+    {
+        file.open(fname);
+        if (not file.is_open())
+        {
+            cerr << "Could not open test suite file " << fname << endl;
+            failed = true;
+        }
+    }
+}
+
+TestSuiteWriter::~TestSuiteWriter()
+{
+    close();
+}
+
+void TestSuiteWriter::add(OutputTree ot)
+{
+    if (trie != nullptr)
+    {
+        trie->add(ot);
+    }
+    else if (file.is_open())
+    {
+        ostringstream tc;
+        tc << ot;
+        buffer += tc.str();
+        if (buffer.size() >= bufferSize)
+        {
+            flush();
+        }
+    }
+
+    if (not rttPrefix.empty())
+    {
+        vector<IOTrace> iotrcVec;
+        ot.toIOTrace(iotrcVec);
+
+        for (size_t iIdx = 0; iIdx < iotrcVec.size(); iIdx++)
+        {
+            ostringstream tcFileName;
+            tcFileName << rttPrefix << numTestCases << "_" << iIdx << ".log";
+            ofstream outFile(tcFileName.str());
+            outFile << iotrcVec[iIdx].toRttString();
+        }
+    }
+
+    totalLength += ot.getInputTrace().get().size();
+    numTestCases++;
+}
+
+void TestSuiteWriter::flush()
+{
+    if (file.is_open() and not buffer.empty())
+    {
+        file.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+        file.flush();
+    }
+    buffer.clear();
+}
+
+bool TestSuiteWriter::close()
+{
+    if (trie != nullptr)
+    {
+        if (not trie->save(fname))
+        {
+            failed = true;
+        }
+        trie = nullptr;
+    }
+    if (file.is_open())
+    {
+        flush();
+        file.close();
+        if (not file)
+        {
+            cerr << "Could not write test suite file " << fname << endl;
+            failed = true;
+        }
+    }
+    return not failed;
+}
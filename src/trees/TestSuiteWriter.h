@@ -0,0 +1,90 @@
+/*
+ * Copyright. Gaël Dottel, Christoph Hilken, and Jan Peleska 2016 - 2021
+ *
+ * Licensed under the EUPL V.1.1
+ */
+#ifndef FSM_TREES_TESTSUITEWRITER_H_
+#define FSM_TREES_TESTSUITEWRITER_H_
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "trees/OutputTree.h"
+#include "trees/TestSuiteTrie.h"
+
+/**
+ Sink for the test cases of a test suite which writes each test case
+ as soon as it is added, instead of collecting the whole suite in a
+ TestSuite first.
+
+ The suite file has the format written by TestSuite::save(). Its lines
+ are collected in a buffer which is written to the file whenever it
+ exceeds bufferSize bytes, so that the per-line flush of the OutputTree
+ << operator does not reach the file. Optionally, every IO trace of a
+ test case is also written to a log file in RTT-MBT format, named
+ <rttPrefix><test case number>_<trace number>.log as before.
+
+ Only the number of test cases and their total length are retained,
+ so memory use does not depend on the size of the suite. If the suite
+ file is written in TestSuiteTrie format instead, the test cases are
+ collected in the trie, whose size is that of the distinct prefixes
+ of the suite, and the file is written by close().
+ */
+class TestSuiteWriter
+{
+private:
+    std::string fname;
+    std::ofstream file;
+    std::string buffer;
+    std::shared_ptr<TestSuiteTrie> trie;
+    std::string rttPrefix;
+    size_t numTestCases;
+    size_t totalLength;
+
+    /** Set if the suite file could not be opened or written */
+    bool failed;
+
+    TestSuiteWriter(const TestSuiteWriter&) = delete;
+    TestSuiteWriter& operator=(const TestSuiteWriter&) = delete;
+
+public:
+    /** Size of the buffer in bytes, above which it is written to the file */
+    static const size_t bufferSize = 1 << 20;
+
+    /**
+     * Create a writer
+     * @param fname Name of the test suite file; no suite file is
+     *        written if it is empty
+     * @param rttPrefix Prefix of the RTT-MBT log files; no log files
+     *        are written if it is empty
+     * @param asTrie If true, the suite file is written in TestSuiteTrie
+     *        format instead of the text format
+     */
+    TestSuiteWriter(const std::string& fname,
+                    const std::string& rttPrefix = "",
+                    const bool asTrie = false);
+
+    /** Calls close() */
+    ~TestSuiteWriter();
+
+    /** Write a test case */
+    void add(OutputTree ot);
+
+    /** Write the buffer to the suite file; nothing is written in trie format */
+    void flush();
+
+    /**
+     * Complete the suite file; no test cases may be added afterwards
+     * @return false if the suite file could not be written
+     */
+    bool close();
+
+    /** Number of test cases added so far */
+    size_t size() const { return numTestCases; }
+
+    /** Sum of the lengths of the input traces of the test cases added so far */
+    size_t getTotalLength() const { return totalLength; }
+};
+#endif //FSM_TREES_TESTSUITEWRITER_H_